@@ -0,0 +1,139 @@
+// ----------------------------------------------
+// Throughput of the BRDF evaluated one sample at a time (BRDF) and by batches of structures of arrays (BRDFBatch), on
+// random shading samples, and error of the batches against the scalar BRDF. Fails if the error exceeds
+// BRDF_BATCH_TOLERANCE, so it doubles as the correctness gate of the vectorized BRDF.
+//
+// Usage: BRDFBenchmark [options], see usage ().
+// ----------------------------------------------
+
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+
+#include "Sources/PBR.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+struct Options {
+	int numOfBatches = 1 << 17;
+	int repeat = 5;
+	unsigned int seed = 1;
+};
+
+static void usage(const char* command) {
+	std::cerr << "Usage : " << command << " [options]\n"
+		<< "\t--batches <n>          batches of " << BRDF_BATCH_SIZE << " random shading samples (default 131072)\n"
+		<< "\t--repeat <n>           timed evaluations of all the samples, the fastest being reported (default 5)\n"
+		<< "\t--seed <n>             seed of the samples (default 1)" << std::endl;
+	std::exit(EXIT_FAILURE);
+}
+
+static Options parseCommandLine(int argc, char** argv) {
+	Options options;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (i + 1 >= argc)
+			usage(argv[0]);
+		std::string value = argv[++i];
+		try {
+			if (argument == "--batches")
+				options.numOfBatches = std::stoi(value);
+			else if (argument == "--repeat")
+				options.repeat = std::stoi(value);
+			else if (argument == "--seed")
+				options.seed = static_cast<unsigned int>(std::stoul(value));
+			else
+				usage(argv[0]);
+		} catch (std::exception&) {
+			usage(argv[0]);
+		}
+	}
+	if (options.numOfBatches <= 0 || options.repeat <= 0)
+		usage(argv[0]);
+	return options;
+}
+
+/// Shading samples over the whole sphere of directions, half of them below the horizon, with the roughness of 1 (the
+/// constant GGX branch) in one sample out of sixteen.
+static std::vector<BRDFSamples> randomSamples(const Options& options) {
+	std::mt19937 generator(options.seed);
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+	std::normal_distribution<float> normal(0.f, 1.f);
+	auto direction = [&]() { return glm::normalize(glm::vec3(normal(generator), normal(generator), normal(generator))); };
+	std::vector<BRDFSamples> batches(options.numOfBatches);
+	for (BRDFSamples& batch : batches)
+		for (int i = 0; i < BRDF_BATCH_SIZE; i++) {
+			glm::vec3 n = direction();
+			glm::vec3 l = direction();
+			// Views from above the surface, as for camera and shadow rays
+			glm::vec3 v = direction();
+			if (glm::dot(v, n) < 0.f)
+				v = -v;
+			for (int c = 0; c < 3; c++) {
+				batch.N[c][i] = n[c];
+				batch.L[c][i] = l[c];
+				batch.V[c][i] = v[c];
+				batch.albedo[c][i] = uniform(generator);
+			}
+			batch.roughness[i] = uniform(generator) < 1.f / 16.f ? 1.f : std::max(0.01f, uniform(generator));
+			batch.metallic[i] = uniform(generator);
+		}
+	return batches;
+}
+
+int main(int argc, char** argv) {
+	Options options = parseCommandLine(argc, argv);
+	std::vector<BRDFSamples> batches = randomSamples(options);
+	size_t numOfSamples = batches.size() * BRDF_BATCH_SIZE;
+	std::vector<float> scalarResults(3 * numOfSamples);
+	std::vector<float> batchResults(3 * numOfSamples);
+
+	double scalarTime = 1e30, batchTime = 1e30;
+	for (int run = 0; run < options.repeat; run++) {
+		Clock::time_point before = Clock::now();
+		for (size_t b = 0; b < batches.size(); b++) {
+			const BRDFSamples& batch = batches[b];
+			for (int i = 0; i < BRDF_BATCH_SIZE; i++) {
+				glm::vec3 value = BRDF(glm::vec3(batch.L[0][i], batch.L[1][i], batch.L[2][i]),
+					glm::vec3(batch.V[0][i], batch.V[1][i], batch.V[2][i]),
+					glm::vec3(batch.N[0][i], batch.N[1][i], batch.N[2][i]),
+					glm::vec3(batch.albedo[0][i], batch.albedo[1][i], batch.albedo[2][i]),
+					batch.roughness[i], batch.metallic[i]);
+				for (int c = 0; c < 3; c++)
+					scalarResults[(b * 3 + c) * BRDF_BATCH_SIZE + i] = value[c];
+			}
+		}
+		scalarTime = std::min(scalarTime, std::chrono::duration<double, std::nano>(Clock::now() - before).count());
+		before = Clock::now();
+		for (size_t b = 0; b < batches.size(); b++)
+			BRDFBatch(batches[b], reinterpret_cast<float(*)[BRDF_BATCH_SIZE]>(&batchResults[b * 3 * BRDF_BATCH_SIZE]));
+		batchTime = std::min(batchTime, std::chrono::duration<double, std::nano>(Clock::now() - before).count());
+	}
+
+	// Relative to the scalar value, absolute below the smallest normal float
+	double maxError = 0.0;
+	size_t worst = 0;
+	for (size_t i = 0; i < scalarResults.size(); i++) {
+		double error = std::abs(double(batchResults[i]) - scalarResults[i]) / std::max(std::abs(double(scalarResults[i])), 1e-30);
+		if (!(error <= maxError)) {
+			maxError = error;
+			worst = i;
+		}
+	}
+
+	std::cout << "Instruction set: " << BRDFLanes::INSTRUCTION_SET << ", " << numOfSamples << " samples" << std::endl
+		<< std::fixed << std::setprecision(2)
+		<< "BRDF      " << std::setw(8) << scalarTime / numOfSamples << " ns/sample" << std::endl
+		<< "BRDFBatch " << std::setw(8) << batchTime / numOfSamples << " ns/sample (x" << scalarTime / batchTime << ")" << std::endl
+		<< std::scientific << "Max relative error " << maxError << " (tolerance " << BRDF_BATCH_TOLERANCE << ")" << std::endl;
+	if (!(maxError <= BRDF_BATCH_TOLERANCE)) {
+		std::cerr << "BRDFBatch exceeds the tolerance: " << batchResults[worst] << " instead of " << scalarResults[worst] << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,259 @@
+// ----------------------------------------------
+// BVH build time and ray traversal throughput on the bundled models and synthetic stress meshes, for coherent and
+// incoherent rays. Every BVH hit of a subset of the rays is checked against the brute force intersection of all the
+// triangles: the program fails if any differs.
+//
+// Usage: BVHBenchmark [options], see usage ().
+// ----------------------------------------------
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <memory>
+#include <algorithm>
+
+#include "Sources/Console.h"
+#include "Sources/IO.h"
+#include "Sources/Mesh.h"
+#include "Sources/BVH.h"
+#include "Sources/Ray.h"
+
+#ifndef DEFAULT_RESOURCES_DIR
+#define DEFAULT_RESOURCES_DIR "."
+#endif
+
+typedef std::chrono::high_resolution_clock Clock;
+
+struct Options {
+	int numOfRays = 65536;
+	int numOfValidatedRays = 1024;
+	unsigned int seed = 1;
+	std::string basePath = DEFAULT_RESOURCES_DIR;
+	std::vector<std::string> models = { "Apple.off", "monkey.off", "killeroo.off", "rhino.off" };
+};
+
+struct TestMesh {
+	std::string name;
+	std::vector<Triangle> triangles;
+};
+
+struct RaySet {
+	std::string name;
+	std::vector<Ray> rays;
+};
+
+static void usage(const char* command) {
+	std::cerr << "Usage : " << command << " [options]\n"
+		<< "\t--rays <n>                  rays per set (default 65536)\n"
+		<< "\t--validate <n>              rays per set checked against the brute force intersection (default 1024)\n"
+		<< "\t--seed <n>                  seed of the ray sets and of the synthetic meshes (default 1)\n"
+		<< "\t--resources <dir>           directory containing the Resources folder\n"
+		<< "\t--models <a.off,b.off,...>  models of Resources/Models (default Apple,monkey,killeroo,rhino)" << std::endl;
+	std::exit(EXIT_FAILURE);
+}
+
+static Options parseCommandLine(int argc, char** argv) {
+	Options options;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (i + 1 >= argc)
+			usage(argv[0]);
+		std::string value = argv[++i];
+		try {
+			if (argument == "--rays")
+				options.numOfRays = std::stoi(value);
+			else if (argument == "--validate")
+				options.numOfValidatedRays = std::stoi(value);
+			else if (argument == "--seed")
+				options.seed = static_cast<unsigned int>(std::stoul(value));
+			else if (argument == "--resources")
+				options.basePath = value;
+			else if (argument == "--models") {
+				options.models.clear();
+				std::istringstream stream(value);
+				std::string item;
+				while (std::getline(stream, item, ','))
+					options.models.push_back(item);
+			} else
+				usage(argv[0]);
+		} catch (std::exception&) {
+			usage(argv[0]);
+		}
+	}
+	if (options.numOfRays < 1 || options.numOfValidatedRays < 0)
+		usage(argv[0]);
+	options.numOfValidatedRays = std::min(options.numOfValidatedRays, options.numOfRays);
+	return options;
+}
+
+static Triangle makeTriangle(const glm::vec3& p0, const glm::vec3& p1, const glm::vec3& p2) {
+	return Triangle(p0, p1, p2, glm::vec3(0.f), glm::vec3(0.f), glm::vec3(0.f), glm::vec2(0.f), glm::vec2(0.f), glm::vec2(0.f), 0, 0);
+}
+
+static TestMesh loadModel(const std::string& filename, const std::string& name) {
+	std::shared_ptr<Mesh> meshPtr = IO::loadOFFMesh(filename, 0, false);
+	TestMesh result = { name, {} };
+	const std::vector<glm::vec3>& positions = meshPtr->vertexPositions();
+	for (const glm::uvec3& t : meshPtr->triangleIndices())
+		result.triangles.push_back(makeTriangle(positions[t.x], positions[t.y], positions[t.z]));
+	return result;
+}
+
+/// Flat grid of 2 n^2 triangles facing +z: every bounding box is flat along z.
+static TestMesh makeGrid(int n) {
+	TestMesh result = { "grid", {} };
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < n; i++) {
+			glm::vec3 p00(float(i) / n, float(j) / n, 0.f), p10(float(i + 1) / n, float(j) / n, 0.f);
+			glm::vec3 p01(float(i) / n, float(j + 1) / n, 0.f), p11(float(i + 1) / n, float(j + 1) / n, 0.f);
+			result.triangles.push_back(makeTriangle(p00, p10, p11));
+			result.triangles.push_back(makeTriangle(p00, p11, p01));
+		}
+	return result;
+}
+
+/// Closed UV sphere of 2 n^2 triangles facing outward, with slivers at the poles.
+static TestMesh makeSphere(int n) {
+	TestMesh result = { "sphere", {} };
+	auto point = [n](int i, int j) {
+		float theta = glm::pi<float>() * j / n, phi = 2.f * glm::pi<float>() * i / n;
+		return glm::vec3(std::sin(theta) * std::cos(phi), std::sin(theta) * std::sin(phi), std::cos(theta));
+	};
+	for (int j = 0; j < n; j++)
+		for (int i = 0; i < n; i++) {
+			result.triangles.push_back(makeTriangle(point(i, j), point(i, j + 1), point(i + 1, j + 1)));
+			result.triangles.push_back(makeTriangle(point(i, j), point(i + 1, j + 1), point(i + 1, j)));
+		}
+	return result;
+}
+
+/// Overlapping random triangles of random sizes in the unit cube.
+static TestMesh makeSoup(int numOfTriangles, unsigned int seed) {
+	TestMesh result = { "soup", {} };
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+	auto randomPoint = [&]() { return glm::vec3(uniform(rng), uniform(rng), uniform(rng)); };
+	for (int i = 0; i < numOfTriangles; i++) {
+		glm::vec3 center = randomPoint();
+		float size = 0.2f * std::pow(uniform(rng), 3.f);
+		result.triangles.push_back(makeTriangle(center + size * (randomPoint() - 0.5f), center + size * (randomPoint() - 0.5f), center + size * (randomPoint() - 0.5f)));
+	}
+	return result;
+}
+
+/// Pinhole camera looking at the mesh (coherent), and rays between random points around and inside the mesh (incoherent).
+static std::vector<RaySet> makeRaySets(const std::vector<Triangle>& triangles, int numOfRays, unsigned int seed) {
+	BoundingBox box(triangles[0].p0);
+	for (const Triangle& triangle : triangles) {
+		box.extendTo(triangle.p0);
+		box.extendTo(triangle.p1);
+		box.extendTo(triangle.p2);
+	}
+	glm::vec3 center = box.center();
+	float radius = std::max(box.radius(), 1e-3f);
+
+	RaySet coherent = { "coherent", {} };
+	glm::vec3 eye = center + 2.5f * radius * glm::normalize(glm::vec3(0.3f, 0.4f, 1.f));
+	glm::vec3 forward = glm::normalize(center - eye);
+	glm::vec3 right = glm::normalize(glm::cross(forward, glm::vec3(0.f, 1.f, 0.f)));
+	glm::vec3 up = glm::cross(right, forward);
+	int side = std::max(1, static_cast<int>(std::sqrt(double(numOfRays))));
+	float halfWidth = std::tan(glm::radians(22.5f));
+	for (int i = 0; i < numOfRays; i++) {
+		float u = 2.f * ((i % side) + 0.5f) / side - 1.f, v = 2.f * ((i / side % side) + 0.5f) / side - 1.f;
+		coherent.rays.push_back(Ray(eye, glm::normalize(forward + u * halfWidth * right + v * halfWidth * up)));
+	}
+
+	RaySet incoherent = { "incoherent", {} };
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> uniform(-1.f, 1.f);
+	for (int i = 0; i < numOfRays; i++) {
+		glm::vec3 direction;
+		do {
+			direction = glm::vec3(uniform(rng), uniform(rng), uniform(rng));
+		} while (glm::dot(direction, direction) > 1.f || glm::dot(direction, direction) < 1e-4f);
+		glm::vec3 origin = center + 2.5f * radius * glm::normalize(direction);
+		glm::vec3 target = center + 0.5f * (box.max() - box.min()) * glm::vec3(uniform(rng), uniform(rng), uniform(rng));
+		incoherent.rays.push_back(Ray(origin, glm::normalize(target - origin)));
+	}
+	return { coherent, incoherent };
+}
+
+static int depth(const std::shared_ptr<BVH>& bvh) {
+	return bvh ? 1 + std::max(depth(bvh->left()), depth(bvh->right())) : 0;
+}
+
+int main(int argc, char** argv) {
+	Options options = parseCommandLine(argc, argv);
+	Console::toggleVerbose(false);
+
+	std::vector<TestMesh> meshes;
+	for (const std::string& model : options.models)
+		meshes.push_back(loadModel(options.basePath + "/Resources/Models/" + model, model.substr(0, model.rfind('.'))));
+	meshes.push_back(makeGrid(200));
+	meshes.push_back(makeSphere(200));
+	meshes.push_back(makeSoup(50000, options.seed));
+
+	std::cout << options.numOfRays << " rays per set, " << options.numOfValidatedRays << " validated against the brute force intersection" << std::endl
+		<< "BVH: M rays/s of Ray::intersectBVH; brute: M triangle tests/s of Ray::intersectTriangles; ties: same distance, other triangle" << std::endl << std::endl;
+	std::cout << std::setw(10) << "mesh" << std::setw(10) << "triangles" << std::setw(10) << "build ms" << std::setw(8) << "depth"
+		<< std::setw(12) << "rays" << std::setw(8) << "hits %" << std::setw(9) << "BVH" << std::setw(9) << "brute"
+		<< std::setw(11) << "mismatch" << std::setw(6) << "ties" << std::endl;
+
+	size_t numOfMismatches = 0;
+	for (TestMesh& mesh : meshes) {
+		std::vector<int> indices;
+		Clock::time_point start = Clock::now();
+		std::shared_ptr<BVH> bvh = std::make_shared<BVH>(mesh.triangles, indices);
+		double buildTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		for (const RaySet& raySet : makeRaySets(mesh.triangles, options.numOfRays, options.seed)) {
+			std::vector<std::shared_ptr<RayHit>> hits(raySet.rays.size());
+			start = Clock::now();
+			for (size_t i = 0; i < raySet.rays.size(); i++)
+				hits[i] = raySet.rays[i].intersectBVH(mesh.triangles, bvh);
+			double traversalTime = std::chrono::duration<double>(Clock::now() - start).count();
+			size_t numOfHits = std::count_if(hits.begin(), hits.end(), [](const std::shared_ptr<RayHit>& hit) { return hit != nullptr; });
+
+			// Validation subset spread over the whole set
+			size_t mismatches = 0, ties = 0;
+			size_t stride = options.numOfValidatedRays ? raySet.rays.size() / options.numOfValidatedRays : 0;
+			start = Clock::now();
+			for (int k = 0; k < options.numOfValidatedRays; k++) {
+				size_t i = k * stride;
+				std::shared_ptr<RayHit> reference = raySet.rays[i].intersectTriangles(mesh.triangles);
+				const std::shared_ptr<RayHit>& hit = hits[i];
+				if (!hit || !reference) {
+					mismatches += (hit != nullptr) != (reference != nullptr);
+				} else if (hit->distance() != reference->distance()) {
+					mismatches++;
+				} else if (hit->triangleIndex() != reference->triangleIndex()) {
+					ties++;
+				} else if (hit->uv_coord() != reference->uv_coord()) {
+					mismatches++;
+				}
+			}
+			double bruteForceTime = std::chrono::duration<double>(Clock::now() - start).count();
+			numOfMismatches += mismatches;
+
+			std::cout << std::setw(10) << mesh.name << std::setw(10) << mesh.triangles.size()
+				<< std::fixed << std::setprecision(1) << std::setw(10) << buildTime << std::setw(8) << depth(bvh)
+				<< std::setw(12) << raySet.name << std::setw(8) << 100.0 * numOfHits / raySet.rays.size()
+				<< std::setprecision(3) << std::setw(9) << raySet.rays.size() / traversalTime * 1e-6
+				<< std::setw(9) << (options.numOfValidatedRays ? double(options.numOfValidatedRays) * mesh.triangles.size() / bruteForceTime * 1e-6 : 0.0)
+				<< std::setw(11) << mismatches << std::setw(6) << ties << std::endl;
+		}
+	}
+
+	if (numOfMismatches) {
+		std::cout << "FAILED: " << numOfMismatches << " BVH hits differ from the brute force intersection" << std::endl;
+		return EXIT_FAILURE;
+	}
+	std::cout << "All validated BVH hits match the brute force intersection" << std::endl;
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,165 @@
+// ----------------------------------------------
+// Shading cost over the number of lights: a built-in scene lit by many random point lights, rendered by evaluating
+// every light, only those in range (light BVH culling), and a few sampled by importance, with the error against the
+// first.
+//
+// Usage: LightBenchmark [options], see usage ().
+// ----------------------------------------------
+
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <memory>
+
+#include "Sources/Resources.h"
+#include "Sources/Console.h"
+#include "Sources/Scene.h"
+#include "Sources/Scenes.h"
+#include "Sources/RayTracer.h"
+
+#ifndef DEFAULT_RESOURCES_DIR
+#define DEFAULT_RESOURCES_DIR "."
+#endif
+
+typedef std::chrono::high_resolution_clock Clock;
+
+struct Options {
+	int scene = 1;
+	std::vector<int> numsOfLights = { 16, 256, 4096 };
+	int width = 160;
+	int height = 120;
+	float totalIntensity = 400.f; // shared by the lights, for images of similar brightness
+	float cutoff = 0.01f;
+	int numOfLightSamples = 4;
+	int numOfThreads = 0;
+	unsigned int seed = 1;
+	std::string basePath = DEFAULT_RESOURCES_DIR;
+};
+
+static void usage(const char* command) {
+	std::cerr << "Usage : " << command << " [options]\n"
+		<< "\t--scene <0|1|2>         built-in scene, its own lights being replaced (default 1)\n"
+		<< "\t--lights <n,m,...>      numbers of random point lights (default 16,256,4096)\n"
+		<< "\t--resolution <w>x<h>    image size (default 160x120)\n"
+		<< "\t--intensity <i>         total intensity of the lights (default 400)\n"
+		<< "\t--cutoff <r>            radiance below which a light is out of range, when culling (default 0.01)\n"
+		<< "\t--light-samples <n>     lights sampled per shading point (default 4)\n"
+		<< "\t--threads <n>           rendering threads, 0 for all cores (default 0)\n"
+		<< "\t--seed <n>              seed of the scene and of the lights (default 1)\n"
+		<< "\t--resources <dir>       directory containing the Resources folder" << std::endl;
+	std::exit(EXIT_FAILURE);
+}
+
+static Options parseCommandLine(int argc, char** argv) {
+	Options options;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (i + 1 >= argc)
+			usage(argv[0]);
+		std::string value = argv[++i];
+		try {
+			if (argument == "--scene")
+				options.scene = std::stoi(value);
+			else if (argument == "--lights") {
+				options.numsOfLights.clear();
+				std::istringstream stream(value);
+				std::string item;
+				while (std::getline(stream, item, ','))
+					options.numsOfLights.push_back(std::stoi(item));
+			} else if (argument == "--resolution") {
+				size_t separator = value.find('x');
+				if (separator == std::string::npos)
+					usage(argv[0]);
+				options.width = std::stoi(value.substr(0, separator));
+				options.height = std::stoi(value.substr(separator + 1));
+			} else if (argument == "--intensity")
+				options.totalIntensity = std::stof(value);
+			else if (argument == "--cutoff")
+				options.cutoff = std::stof(value);
+			else if (argument == "--light-samples")
+				options.numOfLightSamples = std::stoi(value);
+			else if (argument == "--threads")
+				options.numOfThreads = std::stoi(value);
+			else if (argument == "--seed")
+				options.seed = static_cast<unsigned int>(std::stoul(value));
+			else if (argument == "--resources")
+				options.basePath = value;
+			else
+				usage(argv[0]);
+		} catch (std::exception&) {
+			usage(argv[0]);
+		}
+	}
+	if (options.scene < 0 || options.scene >= Scenes::NUM_OF_SCENES || options.width <= 0 || options.height <= 0
+		|| options.numsOfLights.empty() || options.cutoff <= 0.f || options.numOfLightSamples <= 0)
+		usage(argv[0]);
+	return options;
+}
+
+/// Relative RMS error of the luminance of 'image' against 'reference'.
+static double relativeError(const Image& image, const Image& reference) {
+	double squaredErrors = 0.0, squaredReference = 0.0;
+	for (size_t i = 0; i < reference.pixels().size(); i++) {
+		double value = glm::dot(image.pixels()[i], glm::vec3(0.2126f, 0.7152f, 0.0722f));
+		double referenceValue = glm::dot(reference.pixels()[i], glm::vec3(0.2126f, 0.7152f, 0.0722f));
+		squaredErrors += (value - referenceValue) * (value - referenceValue);
+		squaredReference += referenceValue * referenceValue;
+	}
+	return squaredReference > 0.0 ? std::sqrt(squaredErrors / squaredReference) : 0.0;
+}
+
+int main(int argc, char** argv) {
+	Options options = parseCommandLine(argc, argv);
+	Console::toggleVerbose(false);
+	Scenes::Settings settings = { options.basePath, options.basePath + "/" + DEFAULT_MESH_FILENAME,
+		static_cast<float>(options.width) / static_cast<float>(options.height), options.seed };
+	std::shared_ptr<Scene> scenePtr = Scenes::build(options.scene, settings);
+	BoundingBox bounds(scenePtr->triangle(0).p0);
+	for (const Triangle& triangle : scenePtr->triangles()) {
+		bounds.extendTo(triangle.p0);
+		bounds.extendTo(triangle.p1);
+		bounds.extendTo(triangle.p2);
+	}
+
+	std::cout << "Scene " << options.scene << ", " << options.width << "x" << options.height << ", cutoff " << options.cutoff << std::endl
+		<< std::setw(8) << "lights" << std::setw(10) << "mode" << std::setw(12) << "time (ms)" << std::setw(14) << "rays/pixel"
+		<< std::setw(12) << "rel. error" << std::endl;
+	for (int numOfLights : options.numsOfLights) {
+		std::mt19937 generator(options.seed);
+		std::uniform_real_distribution<float> uniform(0.f, 1.f);
+		scenePtr->clearLights();
+		for (int i = 0; i < numOfLights; i++) {
+			glm::vec3 color(0.5f + 0.5f * uniform(generator), 0.5f + 0.5f * uniform(generator), 0.5f + 0.5f * uniform(generator));
+			auto light = std::make_shared<LightSource>(LightType::PointLight, color, options.totalIntensity / numOfLights);
+			light->transform().setTranslation(bounds.min() + glm::vec3(uniform(generator), uniform(generator), uniform(generator)) * (bounds.max() - bounds.min()));
+			scenePtr->addLight(light);
+		}
+
+		// Every light, only those in range, then a few sampled per point
+		const char* modes[] = { "all", "culled", "sampled" };
+		std::shared_ptr<Image> referencePtr;
+		for (int mode = 0; mode < 3; mode++) {
+			RayTracer rayTracer;
+			rayTracer.setResolution(options.width, options.height);
+			rayTracer.setNumOfThreads(options.numOfThreads);
+			rayTracer.setSeed(options.seed);
+			rayTracer.setLightCutoff(mode == 1 ? options.cutoff : 0.f);
+			rayTracer.setNumOfLightSamples(mode == 2 ? options.numOfLightSamples : 0);
+			Clock::time_point before = Clock::now();
+			rayTracer.render(scenePtr);
+			double time = std::chrono::duration<double, std::milli>(Clock::now() - before).count();
+			if (mode == 0)
+				referencePtr = std::make_shared<Image>(*rayTracer.image());
+			std::cout << std::setw(8) << numOfLights << std::setw(10) << modes[mode] << std::fixed << std::setprecision(1)
+				<< std::setw(12) << time << std::setw(14) << double(rayTracer.numOfRays()) / (double(options.width) * options.height)
+				<< std::setprecision(4) << std::setw(12) << relativeError(*rayTracer.image(), *referencePtr) << std::defaultfloat << std::endl;
+		}
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,291 @@
+// ----------------------------------------------
+// Evaluation throughput of the Gabor noise kernels and texture generators, over impulse density, kernel width and
+// isotropy, for several thread counts.
+//
+// Then error of the filtered noises against a supersampled reference, for footprints around the noise wavelength.
+// Fails if a filtered noise is further from the reference than FILTERING_TOLERANCE times 16 jittered samples.
+//
+// Usage: NoiseBenchmark [options], see usage ().
+// ----------------------------------------------
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <sstream>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <memory>
+#include <thread>
+#include <algorithm>
+#include <functional>
+#include <cmath>
+
+#include "Sources/Texture2Dnoise.h"
+#include "Sources/SetupFreeNoise.h"
+#include "Sources/Solid3DNoise.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+/// Largest error of a filtered noise, in units of the error of 16 jittered samples, accepted by the filtering check.
+static const double FILTERING_TOLERANCE = 2.0;
+
+struct Options {
+	int numOfEvaluations = 20000;
+	int resolution = 128;
+	std::vector<int> threads = { 1, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())) };
+	std::vector<float> densities = { 14.f, 56.f, 224.f }; // impulses per kernel, 56 in the built-in scenes
+	std::vector<float> widths = { 0.1f, 0.2f, 0.4f }; // kernel width a
+	int numOfFilteringPoints = 200;
+	int numOfReferenceSamples = 256;
+};
+
+static void usage(const char* command) {
+	std::cerr << "Usage : " << command << " [options]\n"
+		<< "\t--evaluations <n>          noise evaluations per measure (default 20000)\n"
+		<< "\t--resolution <n>           side of the generated textures (default 128)\n"
+		<< "\t--threads <n,m,...>        thread counts (default 1 and all cores)\n"
+		<< "\t--densities <d,e,...>      impulses per kernel (default 14,56,224)\n"
+		<< "\t--widths <a,b,...>         kernel widths a (default 0.1,0.2,0.4)\n"
+		<< "\t--filtering <n>            points of the filtering check, 0 to skip it (default 200)\n"
+		<< "\t--reference <n>            point samples of the reference of the filtering check (default 256)" << std::endl;
+	std::exit(EXIT_FAILURE);
+}
+
+template <typename T>
+static std::vector<T> parseList(const std::string& text) {
+	std::vector<T> result;
+	std::istringstream stream(text);
+	std::string item;
+	while (std::getline(stream, item, ','))
+		result.push_back(static_cast<T>(std::stod(item)));
+	return result;
+}
+
+static Options parseCommandLine(int argc, char** argv) {
+	Options options;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (i + 1 >= argc)
+			usage(argv[0]);
+		std::string value = argv[++i];
+		try {
+			if (argument == "--evaluations")
+				options.numOfEvaluations = std::stoi(value);
+			else if (argument == "--resolution")
+				options.resolution = std::stoi(value);
+			else if (argument == "--threads")
+				options.threads = parseList<int>(value);
+			else if (argument == "--densities")
+				options.densities = parseList<float>(value);
+			else if (argument == "--widths")
+				options.widths = parseList<float>(value);
+			else if (argument == "--filtering")
+				options.numOfFilteringPoints = std::stoi(value);
+			else if (argument == "--reference")
+				options.numOfReferenceSamples = std::stoi(value);
+			else
+				usage(argv[0]);
+		} catch (std::exception&) {
+			usage(argv[0]);
+		}
+	}
+	if (options.numOfEvaluations < 1 || options.resolution < 1 || options.threads.empty() || options.densities.empty() || options.widths.empty()
+		|| options.numOfFilteringPoints < 0 || options.numOfReferenceSamples < 16)
+		usage(argv[0]);
+	return options;
+}
+
+/// Evaluations per second of kernel(0 .. numOfEvaluations-1), statically distributed over the threads.
+static double measure(const std::function<float(int)>& kernel, int numOfEvaluations, int numOfThreads, double& checksum) {
+	double sum = 0.0;
+	Clock::time_point start = Clock::now();
+	#pragma omp parallel for schedule(static) num_threads(numOfThreads) reduction(+:sum)
+	for (int i = 0; i < numOfEvaluations; i++)
+		sum += kernel(i);
+	double seconds = std::chrono::duration<double>(Clock::now() - start).count();
+	checksum += sum;
+	return numOfEvaluations / seconds;
+}
+
+/// A noise sampled around evaluation point i: at the point jittered by the footprint applied to the standard normal
+/// vector g, or filtered over the footprint (a gaussian, of covariance the one of the jitter).
+struct FilteringCase {
+	std::string name;
+	std::function<float(int i, const glm::vec3& g)> sample;
+	std::function<float(int i)> filtered;
+};
+
+/// RMS errors of the filtered value and of 1 and 16 jittered samples (the first one at the point) against the mean of
+/// numOfReferenceSamples jittered samples, relative to the standard deviation of the noise.
+struct FilteringErrors {
+	double pointSample = 0.0;
+	double supersampled = 0.0;
+	double filtered = 0.0;
+};
+
+static FilteringErrors filteringErrors(const FilteringCase& filteringCase, int numOfPoints, int numOfReferenceSamples, unsigned int seed) {
+	std::vector<double> reference(numOfPoints), point(numOfPoints), supersampled(numOfPoints), filtered(numOfPoints);
+	#pragma omp parallel for schedule(dynamic)
+	for (int i = 0; i < numOfPoints; i++) {
+		std::mt19937 rng(seed + i);
+		std::normal_distribution<float> normal(0.f, 1.f);
+		auto jitter = [&]() { return glm::vec3(normal(rng), normal(rng), normal(rng)); };
+		for (int sample = 0; sample < numOfReferenceSamples; sample++)
+			reference[i] += filteringCase.sample(i, jitter());
+		reference[i] /= numOfReferenceSamples;
+		point[i] = filteringCase.sample(i, glm::vec3(0.f));
+		for (int sample = 0; sample < 16; sample++)
+			supersampled[i] += filteringCase.sample(i, jitter());
+		supersampled[i] /= 16;
+		filtered[i] = filteringCase.filtered(i);
+	}
+	double mean = 0.0, variance = 0.0;
+	for (double value : point)
+		mean += value / numOfPoints;
+	for (double value : point)
+		variance += (value - mean) * (value - mean) / numOfPoints;
+	auto rmse = [&](const std::vector<double>& values) {
+		double sum = 0.0;
+		for (int i = 0; i < numOfPoints; i++)
+			sum += (values[i] - reference[i]) * (values[i] - reference[i]);
+		return std::sqrt(sum / numOfPoints / std::max(variance, 1e-12));
+	};
+	FilteringErrors errors;
+	errors.pointSample = rmse(point);
+	errors.supersampled = rmse(supersampled);
+	errors.filtered = rmse(filtered);
+	return errors;
+}
+
+int main(int argc, char** argv) {
+	Options options = parseCommandLine(argc, argv);
+	const float K = 1.f, F_0 = 0.12f, omega_0 = float(M_PI / 4.0);
+	const unsigned int seed = 1234;
+	const std::vector<glm::vec3> colorMap = { glm::vec3(0.1f, 0.1f, 0.3f), glm::vec3(0.8f, 0.5f, 0.2f), glm::vec3(1.f) };
+
+	// Same evaluation points for every configuration: cell coordinates and offsets for the 2D cells, points and normals
+	// of a unit-sized object for the surface and solid noises
+	std::mt19937 rng(seed);
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+	std::vector<glm::ivec2> cells(options.numOfEvaluations);
+	std::vector<glm::vec2> offsets(options.numOfEvaluations);
+	std::vector<glm::vec3> positions(options.numOfEvaluations), normals(options.numOfEvaluations);
+	for (int i = 0; i < options.numOfEvaluations; i++) {
+		cells[i] = glm::ivec2(static_cast<int>(1000.f * uniform(rng)), static_cast<int>(1000.f * uniform(rng)));
+		offsets[i] = glm::vec2(uniform(rng), uniform(rng));
+		positions[i] = 2.f * glm::vec3(uniform(rng), uniform(rng), uniform(rng)) - 1.f;
+		normals[i] = glm::normalize(2.f * glm::vec3(uniform(rng), uniform(rng), uniform(rng)) - 1.f + glm::vec3(0.f, 0.f, 1e-3f));
+	}
+
+	std::cout << options.numOfEvaluations << " evaluations per measure, " << options.resolution << "x" << options.resolution
+		<< " textures, one per thread, for the generators" << std::endl
+		<< "Per thread throughput in M evaluations/s (M texels/s for the generators), scaling = total throughput of the last thread count over the first one" << std::endl << std::endl;
+	std::cout << std::setw(16) << "kernel" << std::setw(8) << "type" << std::setw(10) << "impulses" << std::setw(7) << "a";
+	for (int numOfThreads : options.threads)
+		std::cout << std::setw(10) << (std::to_string(numOfThreads) + "T");
+	std::cout << std::setw(10) << "scaling" << std::endl;
+
+	double checksum = 0.0;
+	auto report = [&](const std::string& name, bool isIsotropic, float density, float a, const std::function<double(int)>& throughput) {
+		std::cout << std::setw(16) << name << std::setw(8) << (isIsotropic ? "iso" : "aniso")
+			<< std::fixed << std::setprecision(1) << std::setw(10) << density << std::setprecision(2) << std::setw(7) << a << std::setprecision(4);
+		double first = 0.0, last = 0.0;
+		for (int numOfThreads : options.threads) {
+			last = throughput(numOfThreads);
+			if (first == 0.0)
+				first = last;
+			std::cout << std::setw(10) << last / numOfThreads * 1e-6 << std::flush;
+		}
+		std::cout << std::setprecision(2) << std::setw(10) << last / first << std::endl;
+	};
+
+	for (bool isIsotropic : { true, false }) {
+		for (float density : options.densities) {
+			for (float a : options.widths) {
+				Texture2Dnoise texture2Dnoise(isIsotropic, K, a, F_0, omega_0, density, seed);
+				SetupFreeNoise setupFreeNoise(isIsotropic, K, a, F_0, omega_0, density, seed);
+				Solid3DNoise solid3DNoise(isIsotropic, K, a, F_0, glm::vec3(1.f, 0.f, 0.f), density, seed);
+
+				report("2D cell", isIsotropic, density, a, [&](int numOfThreads) {
+					return measure([&](int i) { return texture2Dnoise.cell(cells[i].x, cells[i].y, offsets[i].x, offsets[i].y); }, options.numOfEvaluations, numOfThreads, checksum);
+				});
+				report("surface float", isIsotropic, density, a, [&](int numOfThreads) {
+					return measure([&](int i) { return setupFreeNoise.noiseFloat(positions[i], normals[i]); }, options.numOfEvaluations, numOfThreads, checksum);
+				});
+				report("surface color", isIsotropic, density, a, [&](int numOfThreads) {
+					return measure([&](int i) { return setupFreeNoise.noiseColor(positions[i], normals[i], colorMap).x; }, options.numOfEvaluations, numOfThreads, checksum);
+				});
+				report("solid float", isIsotropic, density, a, [&](int numOfThreads) {
+					return measure([&](int i) { return solid3DNoise.noiseFloat(positions[i]); }, options.numOfEvaluations, numOfThreads, checksum);
+				});
+				// The generators are sequential: each thread fills its own texture
+				int numOfTexels = options.resolution * options.resolution;
+				report("2D gen float", isIsotropic, density, a, [&](int numOfThreads) {
+					return numOfTexels * measure([&](int i) { return texture2Dnoise.generateFloat2DNoiseTexture(i, options.resolution)->fetch(glm::vec2(0.5f)).x; }, numOfThreads, numOfThreads, checksum);
+				});
+				report("2D gen color", isIsotropic, density, a, [&](int numOfThreads) {
+					return numOfTexels * measure([&](int i) { return texture2Dnoise.generateColor2DNoiseTexture(i, options.resolution, colorMap)->fetch(glm::vec2(0.5f)).x; }, numOfThreads, numOfThreads, checksum);
+				});
+			}
+		}
+	}
+	std::cout << "checksum " << checksum << std::endl;
+
+	// Filtering: footprints of a fraction of the noise wavelength up to a few ones, where 1 spp aliases
+	if (options.numOfFilteringPoints == 0)
+		return EXIT_SUCCESS;
+	const float density = 56.f, a = 0.2f;
+	const int numOfFilteringPoints = std::min(options.numOfFilteringPoints, options.numOfEvaluations);
+	std::cout << std::endl << "Filtering error against " << options.numOfReferenceSamples << " jittered samples, " << numOfFilteringPoints
+		<< " points, " << density << " impulses, a = " << a << ", relative to the noise standard deviation" << std::endl
+		<< std::setw(16) << "noise" << std::setw(8) << "type" << std::setw(14) << "footprint" << std::setw(10) << "1 spp"
+		<< std::setw(10) << "16 spp" << std::setw(10) << "filtered" << std::endl;
+	bool isWithinSupersampling = true;
+	for (bool isIsotropic : { true, false }) {
+		Texture2Dnoise texture2Dnoise(isIsotropic, K, a, F_0, omega_0, density, seed);
+		SetupFreeNoise setupFreeNoise(isIsotropic, K, a, F_0, omega_0, density, seed);
+		Solid3DNoise solid3DNoise(isIsotropic, K, a, F_0, glm::vec3(1.f, 0.f, 0.f), density, seed);
+		for (float wavelengths : { 0.25f, 1.f, 4.f }) {
+			// Standard deviation of the footprint, in texels for the 2D noise, in object units for the others, whose
+			// kernel coordinates are 180 times the position
+			float texelSigma = wavelengths / F_0;
+			float sigma = texelSigma / 180.f;
+			std::vector<FilteringCase> cases = {
+				{ "2D texture",
+					[&](int i, const glm::vec3& g) { return texture2Dnoise.noise(1000.f * offsets[i].x + texelSigma * g.x, 1000.f * offsets[i].y + texelSigma * g.y); },
+					[&](int i) { return texture2Dnoise.noise(1000.f * offsets[i].x, 1000.f * offsets[i].y, glm::mat2(texelSigma * texelSigma)); } },
+				{ "surface",
+					[&](int i, const glm::vec3& g) {
+						glm::vec3 u = glm::normalize(glm::cross(normals[i], glm::vec3(0.3f, 0.5f, 0.8f)));
+						glm::vec3 v = glm::cross(normals[i], u);
+						return setupFreeNoise.noiseFloat(positions[i] + sigma * (g.x * u + g.y * v), normals[i]);
+					},
+					[&](int i) {
+						glm::vec3 u = glm::normalize(glm::cross(normals[i], glm::vec3(0.3f, 0.5f, 0.8f)));
+						glm::vec3 v = glm::cross(normals[i], u);
+						return setupFreeNoise.noiseFloat(positions[i], normals[i], sigma * sigma * (glm::outerProduct(u, u) + glm::outerProduct(v, v)));
+					} },
+				{ "solid",
+					[&](int i, const glm::vec3& g) { return solid3DNoise.noiseFloat(positions[i] + sigma * g); },
+					[&](int i) { return solid3DNoise.noiseFloat(positions[i], glm::mat3(sigma * sigma)); } }
+			};
+			for (const FilteringCase& filteringCase : cases) {
+				FilteringErrors errors = filteringErrors(filteringCase, numOfFilteringPoints, options.numOfReferenceSamples, seed);
+				std::ostringstream footprint;
+				footprint << wavelengths << " wavel.";
+				std::cout << std::setw(16) << filteringCase.name << std::setw(8) << (isIsotropic ? "iso" : "aniso") << std::setw(14) << footprint.str()
+					<< std::fixed << std::setprecision(3) << std::setw(10) << errors.pointSample << std::setw(10) << errors.supersampled
+					<< std::setw(10) << errors.filtered << std::endl;
+				isWithinSupersampling = isWithinSupersampling && errors.filtered <= FILTERING_TOLERANCE * errors.supersampled;
+			}
+		}
+	}
+	if (!isWithinSupersampling) {
+		std::cerr << "A filtered noise is further from the reference than " << FILTERING_TOLERANCE << " times 16 spp" << std::endl;
+		return EXIT_FAILURE;
+	}
+
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,216 @@
+// ----------------------------------------------
+// End-to-end rendering benchmark of the built-in scenes, with fixed seeds, as JSON.
+//
+// Usage: RenderBenchmark [options], see usage ().
+// ----------------------------------------------
+
+#include <cstdlib>
+#include <iostream>
+#include <fstream>
+#include <sstream>
+#include <iomanip>
+#include <string>
+#include <vector>
+#include <memory>
+#include <chrono>
+#include <thread>
+#include <algorithm>
+#include <numeric>
+
+#include "Sources/Resources.h"
+#include "Sources/Console.h"
+#include "Sources/Scene.h"
+#include "Sources/Scenes.h"
+#include "Sources/RayTracer.h"
+
+#ifndef DEFAULT_RESOURCES_DIR
+#define DEFAULT_RESOURCES_DIR "."
+#endif
+
+struct Options {
+	std::vector<int> scenes = { 0, 1, 2 };
+	std::vector<std::pair<int, int>> resolutions = { { 320, 240 }, { 640, 480 } };
+	std::vector<int> threads = { 1, static_cast<int>(std::max(1u, std::thread::hardware_concurrency())) };
+	int samplesPerPixel = 1;
+	int warmup = 1;
+	int repeat = 3;
+	unsigned int seed = 1;
+	std::string basePath = DEFAULT_RESOURCES_DIR;
+	std::string output; // standard output if empty
+	bool verbose = false;
+};
+
+static void usage(const char* command) {
+	std::cerr << "Usage : " << command << " [options]\n"
+		<< "\t--scenes <i,j,...>            scenes to render (default 0,1,2)\n"
+		<< "\t--resolutions <wxh,wxh,...>   image sizes (default 320x240,640x480)\n"
+		<< "\t--threads <n,m,...>           thread counts (default 1 and all cores)\n"
+		<< "\t--spp <n>                     samples per pixel (default 1)\n"
+		<< "\t--warmup <n>                  untimed renders before the measures (default 1)\n"
+		<< "\t--repeat <n>                  timed renders per configuration (default 3)\n"
+		<< "\t--seed <n>                    seed of the scenes and of the sampling (default 1)\n"
+		<< "\t--resources <dir>             directory containing the Resources folder\n"
+		<< "\t--output <file.json>          report file (default: standard output)\n"
+		<< "\t--verbose                     keep the renderer messages" << std::endl;
+	std::exit(EXIT_FAILURE);
+}
+
+static std::vector<std::string> split(const std::string& text, char separator) {
+	std::vector<std::string> result;
+	std::istringstream stream(text);
+	std::string item;
+	while (std::getline(stream, item, separator))
+		result.push_back(item);
+	return result;
+}
+
+static Options parseCommandLine(int argc, char** argv) {
+	Options options;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (argument == "--verbose") {
+			options.verbose = true;
+			continue;
+		}
+		if (i + 1 >= argc)
+			usage(argv[0]);
+		std::string value = argv[++i];
+		try {
+			if (argument == "--scenes") {
+				options.scenes.clear();
+				for (const std::string& item : split(value, ','))
+					options.scenes.push_back(std::stoi(item));
+			} else if (argument == "--resolutions") {
+				options.resolutions.clear();
+				for (const std::string& item : split(value, ',')) {
+					std::vector<std::string> size = split(item, 'x');
+					if (size.size() != 2)
+						usage(argv[0]);
+					options.resolutions.push_back({ std::stoi(size[0]), std::stoi(size[1]) });
+				}
+			} else if (argument == "--threads") {
+				options.threads.clear();
+				for (const std::string& item : split(value, ','))
+					options.threads.push_back(std::stoi(item));
+			} else if (argument == "--spp")
+				options.samplesPerPixel = std::stoi(value);
+			else if (argument == "--warmup")
+				options.warmup = std::stoi(value);
+			else if (argument == "--repeat")
+				options.repeat = std::stoi(value);
+			else if (argument == "--seed")
+				options.seed = static_cast<unsigned int>(std::stoul(value));
+			else if (argument == "--resources")
+				options.basePath = value;
+			else if (argument == "--output")
+				options.output = value;
+			else
+				usage(argv[0]);
+		} catch (std::exception&) {
+			usage(argv[0]);
+		}
+	}
+	for (int scene : options.scenes)
+		if (scene < 0 || scene >= Scenes::NUM_OF_SCENES)
+			usage(argv[0]);
+	if (options.repeat < 1 || options.warmup < 0 || options.resolutions.empty() || options.threads.empty())
+		usage(argv[0]);
+	return options;
+}
+
+static double median(std::vector<double> values) {
+	std::sort(values.begin(), values.end());
+	size_t middle = values.size() / 2;
+	return values.size() % 2 ? values[middle] : 0.5 * (values[middle - 1] + values[middle]);
+}
+
+int main(int argc, char** argv) {
+	Options options = parseCommandLine(argc, argv);
+	Console::toggleVerbose(options.verbose);
+	typedef std::chrono::high_resolution_clock Clock;
+
+	std::ostringstream json;
+	json << std::fixed << std::setprecision(3);
+	json << "{\n"
+		<< "  \"seed\": " << options.seed << ",\n"
+		<< "  \"spp\": " << options.samplesPerPixel << ",\n"
+		<< "  \"warmup\": " << options.warmup << ",\n"
+		<< "  \"repeat\": " << options.repeat << ",\n"
+		<< "  \"hardwareThreads\": " << std::thread::hardware_concurrency() << ",\n"
+		<< "  \"scenes\": [";
+	for (size_t sceneIndex = 0; sceneIndex < options.scenes.size(); sceneIndex++) {
+		int scene = options.scenes[sceneIndex];
+		std::cerr << "Scene " << scene << ": building" << std::endl;
+		Scenes::Settings settings = { options.basePath, options.basePath + "/" + DEFAULT_MESH_FILENAME, 4.f / 3.f, options.seed };
+		Clock::time_point start = Clock::now();
+		std::shared_ptr<Scene> scenePtr = Scenes::build(scene, settings);
+		double buildTime = std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+
+		json << (sceneIndex ? "," : "") << "\n    {\n"
+			<< "      \"scene\": " << scene << ",\n"
+			<< "      \"triangles\": " << scenePtr->numOfTriangles() << ",\n"
+			<< "      \"sceneBuildMs\": " << buildTime << ",\n"
+			<< "      \"textureGenerationMs\": " << scenePtr->textureLoadingTime() << ",\n"
+			<< "      \"bvhBuildMs\": " << scenePtr->bvhBuildTime() << ",\n"
+			<< "      \"runs\": [";
+		bool firstRun = true;
+		for (const std::pair<int, int>& resolution : options.resolutions) {
+			scenePtr->camera()->setAspectRatio(static_cast<float>(resolution.first) / static_cast<float>(resolution.second));
+			for (int numOfThreads : options.threads) {
+				std::cerr << "Scene " << scene << ": " << resolution.first << "x" << resolution.second << ", " << numOfThreads << " threads" << std::endl;
+				RayTracer rayTracer;
+				rayTracer.setResolution(resolution.first, resolution.second);
+				rayTracer.setSamplesPerPixel(options.samplesPerPixel);
+				rayTracer.setNumOfThreads(numOfThreads);
+				rayTracer.setSeed(options.seed);
+				rayTracer.init(scenePtr);
+				for (int i = 0; i < options.warmup; i++)
+					rayTracer.render(scenePtr);
+				std::vector<double> times;
+				for (int i = 0; i < options.repeat; i++) {
+					start = Clock::now();
+					rayTracer.render(scenePtr);
+					times.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+				}
+				double medianTime = median(times);
+				size_t numOfRays = rayTracer.numOfRays();
+				// Same image from the primary hits kept by a last render
+				rayTracer.setGBufferEnabled(true);
+				rayTracer.render(scenePtr);
+				std::vector<double> relightTimes;
+				for (int i = 0; i < options.repeat; i++) {
+					start = Clock::now();
+					rayTracer.relight(scenePtr);
+					relightTimes.push_back(std::chrono::duration<double, std::milli>(Clock::now() - start).count());
+				}
+				json << (firstRun ? "" : ",") << "\n        {"
+					<< " \"width\": " << resolution.first
+					<< ", \"height\": " << resolution.second
+					<< ", \"threads\": " << numOfThreads
+					<< ", \"rays\": " << numOfRays
+					<< ", \"wallMsMin\": " << *std::min_element(times.begin(), times.end())
+					<< ", \"wallMsMedian\": " << medianTime
+					<< ", \"wallMsMean\": " << std::accumulate(times.begin(), times.end(), 0.0) / times.size()
+					<< ", \"raysPerSecond\": " << numOfRays / (medianTime * 1e-3)
+					<< ", \"relightMsMedian\": " << median(relightTimes)
+					<< " }";
+				firstRun = false;
+			}
+		}
+		json << "\n      ]\n    }";
+	}
+	json << "\n  ]\n}\n";
+
+	Console::flush();
+	if (options.output.empty()) {
+		std::cout << json.str();
+	} else {
+		std::ofstream out(options.output);
+		if (!out) {
+			std::cerr << "Cannot open file " << options.output << std::endl;
+			return EXIT_FAILURE;
+		}
+		out << json.str();
+	}
+	return EXIT_SUCCESS;
+}
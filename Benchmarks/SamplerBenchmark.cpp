@@ -0,0 +1,131 @@
+// ----------------------------------------------
+// Convergence and throughput of the samplers: error of the pixel estimates of test integrands over the number of
+// samples, against their exact values, and sample generation rate.
+//
+// Usage: SamplerBenchmark [options], see usage ().
+// ----------------------------------------------
+
+#include <cstdlib>
+#include <cmath>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <vector>
+#include <string>
+#include <functional>
+
+#include "Sources/Sampler.h"
+
+typedef std::chrono::high_resolution_clock Clock;
+
+struct Options {
+	int numOfPixels = 64; // per side
+	int maxSamples = 256;
+	int numOfThroughputSamples = 4000000;
+};
+
+struct Integrand {
+	std::string name;
+	std::function<float(const glm::vec2&)> function;
+	double integral;
+};
+
+static void usage(const char* command) {
+	std::cerr << "Usage : " << command << " [options]\n"
+		<< "\t--pixels <n>           side of the pixel grid, each pixel being an independent estimate (default 64)\n"
+		<< "\t--max-samples <n>      largest sample count, from 1 by powers of 2 (default 256)\n"
+		<< "\t--throughput <n>       samples generated per throughput measure (default 4000000)" << std::endl;
+	std::exit(EXIT_FAILURE);
+}
+
+static Options parseCommandLine(int argc, char** argv) {
+	Options options;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (i + 1 >= argc)
+			usage(argv[0]);
+		std::string value = argv[++i];
+		try {
+			if (argument == "--pixels")
+				options.numOfPixels = std::stoi(value);
+			else if (argument == "--max-samples")
+				options.maxSamples = std::stoi(value);
+			else if (argument == "--throughput")
+				options.numOfThroughputSamples = std::stoi(value);
+			else
+				usage(argv[0]);
+		} catch (std::exception&) {
+			usage(argv[0]);
+		}
+	}
+	if (options.numOfPixels <= 0 || options.maxSamples <= 0 || options.numOfThroughputSamples <= 0)
+		usage(argv[0]);
+	return options;
+}
+
+int main(int argc, char** argv) {
+	Options options = parseCommandLine(argc, argv);
+	const SamplerType types[] = { SamplerType::Random, SamplerType::Halton, SamplerType::Sobol, SamplerType::BlueNoise };
+	// An edge (pixel covered by a disk), a slanted edge and a smooth function
+	static const float pi = 3.14159265358979f;
+	const std::vector<Integrand> integrands = {
+		{ "disk", [](const glm::vec2& p) { return glm::length(p - glm::vec2(0.5f)) < 0.4f ? 1.f : 0.f; }, pi * 0.4 * 0.4 },
+		{ "slanted edge", [](const glm::vec2& p) { return p.y < 0.3f * p.x + 0.2f ? 1.f : 0.f; }, 0.35 },
+		{ "smooth", [](const glm::vec2& p) { return std::sin(pi * p.x) * std::sin(pi * p.y); }, 4.0 / (pi * pi) }
+	};
+
+	auto before = Clock::now();
+	Sampler::blueNoiseTile();
+	std::cout << "Blue noise tile of " << Sampler::BLUE_NOISE_TILE_SIZE << "x" << Sampler::BLUE_NOISE_TILE_SIZE << " generated in "
+		<< std::chrono::duration_cast<std::chrono::milliseconds>(Clock::now() - before).count() << "ms" << std::endl;
+
+	// RMS error over the pixels, each integrating the function with its own sequence
+	bool outOfRange = false;
+	for (const Integrand& integrand : integrands) {
+		std::cout << "\nRMS error, " << integrand.name << std::endl << std::setw(8) << "samples";
+		for (SamplerType type : types)
+			std::cout << std::setw(12) << Sampler::name(type);
+		std::cout << std::endl;
+		for (int numOfSamples = 1; numOfSamples <= options.maxSamples; numOfSamples *= 2) {
+			std::cout << std::setw(8) << numOfSamples;
+			for (SamplerType type : types) {
+				Sampler sampler(type, 0);
+				double squaredErrors = 0.0;
+				for (int y = 0; y < options.numOfPixels; y++)
+					for (int x = 0; x < options.numOfPixels; x++) {
+						double sum = 0.0;
+						for (int i = 0; i < numOfSamples; i++) {
+							glm::vec2 p = sampler.get2D(x, y, i);
+							outOfRange |= p.x < 0.f || p.x >= 1.f || p.y < 0.f || p.y >= 1.f;
+							sum += integrand.function(p);
+						}
+						double error = sum / numOfSamples - integrand.integral;
+						squaredErrors += error * error;
+					}
+				std::cout << std::scientific << std::setprecision(2) << std::setw(12)
+					<< std::sqrt(squaredErrors / (double(options.numOfPixels) * options.numOfPixels)) << std::defaultfloat;
+			}
+			std::cout << std::endl;
+		}
+	}
+
+	std::cout << "\nThroughput (M samples/s, one thread)" << std::endl;
+	double checksum = 0.0;
+	for (SamplerType type : types) {
+		Sampler sampler(type, 0);
+		glm::vec2 sum(0.f);
+		before = Clock::now();
+		for (int i = 0; i < options.numOfThroughputSamples; i++)
+			sum += sampler.get2D(i & 255, (i >> 8) & 255, i >> 16);
+		double seconds = std::chrono::duration<double>(Clock::now() - before).count();
+		checksum += sum.x + sum.y;
+		std::cout << std::setw(12) << Sampler::name(type) << std::fixed << std::setprecision(1) << std::setw(10)
+			<< options.numOfThroughputSamples / seconds * 1e-6 << std::defaultfloat << std::endl;
+	}
+	std::cout << "checksum " << checksum << std::endl;
+	if (outOfRange) {
+		std::cout << "FAILED: samples out of [0, 1)" << std::endl;
+		return EXIT_FAILURE;
+	}
+	return EXIT_SUCCESS;
+}
@@ -0,0 +1,139 @@
+// ----------------------------------------------
+// Texture fetch throughput of the CPU mip pyramid, for each memory layout and storage format.
+//
+// Usage: TextureBenchmark [options], see usage ().
+// ----------------------------------------------
+
+#include <cstdlib>
+#include <iostream>
+#include <iomanip>
+#include <chrono>
+#include <random>
+#include <vector>
+#include <string>
+#include <memory>
+#include <cmath>
+
+#include "Sources/Texture.h"
+
+struct Options {
+	int resolution = 2048;
+	int numOfFetches = 4000000;
+};
+
+static void usage(const char* command) {
+	std::cerr << "Usage : " << command << " [options]\n"
+		<< "\t--resolution <n>       side of the square texture, in texels (default 2048)\n"
+		<< "\t--fetches <n>          trilinear fetches per measure, rounded down to a square (default 4000000)" << std::endl;
+	std::exit(EXIT_FAILURE);
+}
+
+static Options parseCommandLine(int argc, char** argv) {
+	Options options;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (i + 1 >= argc)
+			usage(argv[0]);
+		std::string value = argv[++i];
+		try {
+			if (argument == "--resolution")
+				options.resolution = std::stoi(value);
+			else if (argument == "--fetches")
+				options.numOfFetches = std::stoi(value);
+			else
+				usage(argv[0]);
+		} catch (std::exception&) {
+			usage(argv[0]);
+		}
+	}
+	if (options.resolution <= 0 || options.numOfFetches <= 0)
+		usage(argv[0]);
+	return options;
+}
+
+static const char* layoutName(TextureLayout layout) {
+	switch (layout) {
+	case TextureLayout::Tiled:
+		return "tiled";
+	case TextureLayout::Morton:
+		return "morton";
+	default:
+		return "linear";
+	}
+}
+
+static const char* formatName(TextureFormat format) {
+	switch (format) {
+	case TextureFormat::RGB16F:
+		return "rgb16f";
+	case TextureFormat::RGBA8:
+		return "rgba8";
+	case TextureFormat::SRGBA8:
+		return "srgba8";
+	case TextureFormat::BC1:
+		return "bc1";
+	default:
+		return "rgb32f";
+	}
+}
+
+/// Millions of fetches per second over the given uv sequence.
+static double measure(const Texture& texture, const std::vector<glm::vec2>& uvs, glm::vec2 duv, glm::vec3& checksum) {
+	auto start = std::chrono::high_resolution_clock::now();
+	for (const glm::vec2& uv : uvs)
+		checksum += texture.fetch(uv, duv, glm::vec2(0.f, duv.y), TextureFilter::Trilinear);
+	auto end = std::chrono::high_resolution_clock::now();
+	return uvs.size() / std::chrono::duration<double, std::micro>(end - start).count();
+}
+
+int main(int argc, char** argv) {
+	Options options = parseCommandLine(argc, argv);
+	int resolution = options.resolution;
+
+	std::mt19937 rng(1234);
+	std::uniform_real_distribution<float> uniform(0.f, 1.f);
+
+	// Coherent: scanlines of a screen showing the texture rotated, i.e. neighbouring fetches cross texel rows as on a
+	// surface seen by a camera; random: uniform uv
+	int side = static_cast<int>(std::sqrt(double(options.numOfFetches)));
+	glm::mat2 rotation(std::cos(0.5f), std::sin(0.5f), -std::sin(0.5f), std::cos(0.5f));
+	std::vector<glm::vec2> coherent, incoherent;
+	for (int y = 0; y < side; y++)
+		for (int x = 0; x < side; x++)
+			coherent.push_back(rotation * glm::vec2((x + 0.5f) / side, (y + 0.5f) / side));
+	for (size_t i = 0; i < coherent.size(); i++)
+		incoherent.push_back(glm::vec2(uniform(rng), uniform(rng)));
+	glm::vec2 duv(1.f / side);
+
+	std::cout << "Texture " << resolution << "x" << resolution << ", " << coherent.size() << " trilinear fetches (Mfetch/s)" << std::endl << std::endl;
+	std::vector<float> source(size_t(resolution) * resolution * 3);
+	for (float& value : source)
+		value = uniform(rng);
+	// Ownership of the data goes to the texture
+	auto makeTexture = [&](TextureFormat format, TextureLayout layout) {
+		float* data = new float[source.size()];
+		std::copy(source.begin(), source.end(), data);
+		return std::make_unique<Texture>(0, resolution, resolution, 3, data, true, format, layout);
+	};
+
+	glm::vec3 checksum(0.f);
+	std::cout << std::setw(8) << "layout" << std::setw(12) << "coherent" << std::setw(12) << "random" << std::endl;
+	for (TextureLayout layout : { TextureLayout::Linear, TextureLayout::Tiled, TextureLayout::Morton }) {
+		auto texture = makeTexture(TextureFormat::RGB32F, layout);
+		std::cout << std::setw(8) << layoutName(layout) << std::fixed << std::setprecision(2)
+			<< std::setw(12) << measure(*texture, coherent, duv, checksum)
+			<< std::setw(12) << measure(*texture, incoherent, duv, checksum) << std::endl;
+	}
+
+	std::cout << std::endl << std::setw(8) << "format" << std::setw(12) << "MB" << std::setw(12) << "coherent" << std::setw(12) << "random" << std::endl;
+	for (TextureFormat format : { TextureFormat::RGB32F, TextureFormat::RGB16F, TextureFormat::RGBA8, TextureFormat::SRGBA8, TextureFormat::BC1 }) {
+		auto texture = makeTexture(format, TextureLayout::Tiled);
+		std::cout << std::setw(8) << formatName(format) << std::fixed << std::setprecision(2)
+			<< std::setw(12) << texture->memorySize() / (1024.0 * 1024.0)
+			<< std::setw(12) << measure(*texture, coherent, duv, checksum)
+			<< std::setw(12) << measure(*texture, incoherent, duv, checksum) << std::endl;
+	}
+	std::cout << "checksum " << checksum.x + checksum.y + checksum.z << std::endl;
+
+	return EXIT_SUCCESS;
+}
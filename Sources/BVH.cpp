@@ -82,7 +82,7 @@ BVH::BVH(const std::vector<Triangle>& triangles, std::vector<int>& indices) {
 			{
 				for (int i = 0; i < s / 2; i++) {
 					leftIndices.push_back(rightIndices.back());
-					leftIndices.pop_back();
+					rightIndices.pop_back();
 				}
 			}
 		}
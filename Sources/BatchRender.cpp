@@ -0,0 +1,221 @@
+// ----------------------------------------------
+// Headless ray tracing of a built-in scene to an image file, no window nor OpenGL context.
+//
+// Usage: BatchRender [options], see usage ().
+// ----------------------------------------------
+
+#include <cstdlib>
+#include <string>
+#include <memory>
+#include <chrono>
+#include <sstream>
+#include <filesystem>
+
+namespace fs = std::filesystem;
+
+#include <glm/glm.hpp>
+
+#include "Resources.h"
+#include "Console.h"
+#include "Profiler.h"
+#include "Scene.h"
+#include "Scenes.h"
+#include "Camera.h"
+#include "RayTracer.h"
+
+struct Options {
+	int scene = 1;
+	int width = 800;
+	int height = 600;
+	int samplesPerPixel = 1;
+	int maxSamplesPerPixel = 1; // adaptive sampling if above samplesPerPixel
+	float adaptiveThreshold = 0.02f;
+	SamplerType samplerType = SamplerType::Sobol;
+	float lightCutoff = 0.f;
+	int numOfLightSamples = 0;
+	int numOfThreads = 0;
+	unsigned int seed = 0;
+	bool hasTranslation = false;
+	glm::vec3 translation = glm::vec3 (0.f);
+	bool hasRotation = false;
+	glm::vec3 rotation = glm::vec3 (0.f); // degrees
+	float fov = 0.f; // 0 keeps the one of the scene
+	std::string output = "render.ppm";
+	CostMetric costMetric = CostMetric::None;
+	std::string trace; // no capture if empty
+	std::string basePath;
+	std::string meshFilename;
+};
+
+static void usage (const char * command) {
+	Console::print ("Usage : " + std::string (command) + " [options]\n"
+		+ "\t--scene <0|1|2>           built-in scene (default 1)\n"
+		+ "\t--resolution <w>x<h>      image size (default 800x600)\n"
+		+ "\t--spp <n>                 samples per pixel (default 1), or per batch of adaptive sampling (at least 2)\n"
+		+ "\t--adaptive <max spp>      adaptive supersampling up to this many samples per pixel\n"
+		+ "\t--threshold <t>           adaptive sampling stops once the standard error of a pixel luminance falls\n"
+		+ "\t                          below t times its mean (default 0.02)\n"
+		+ "\t--sampler <random|halton|sobol|bluenoise>  sample positions of the supersampling (default sobol)\n"
+		+ "\t--light-cutoff <r>        skip the point lights whose radiance falls below r at a point (default 0: none)\n"
+		+ "\t--light-samples <n>       point lights sampled per point by importance, ignoring the cutoff (default 0: all lights in range)\n"
+		+ "\t--threads <n>             rendering threads, 0 for all cores (default 0)\n"
+		+ "\t--seed <n>                seed of the scene noises and of the sampling (default 0)\n"
+		+ "\t--camera <x>,<y>,<z>      camera position\n"
+		+ "\t--rotation <x>,<y>,<z>    camera rotation, in degrees\n"
+		+ "\t--fov <degrees>           camera vertical field of view\n"
+		+ "\t--output <file.ppm>       output image (default render.ppm)\n"
+		+ "\t--cost <time|nodes|impulses|samples>  also write the per pixel cost heatmap to <output>_cost.ppm\n"
+		+ "\t                          (nodes and impulses require a build with RENDERER_STATS)\n"
+		+ "\t--trace <file.json>       profile the scene building and the render, as a Chrome trace\n"
+		+ "\t--resources <dir>         directory containing the Resources folder (default: next to the executable)\n"
+		+ "\t--mesh <file.off>         main mesh of scene 0, relative to the resources directory");
+	std::exit (EXIT_FAILURE);
+}
+
+static glm::vec3 parseVec3 (const std::string & text, const char * command) {
+	glm::vec3 result;
+	char separator1, separator2;
+	std::istringstream stream (text);
+	if (!(stream >> result.x >> separator1 >> result.y >> separator2 >> result.z) || separator1 != ',' || separator2 != ',')
+		usage (command);
+	return result;
+}
+
+static Options parseCommandLine (int argc, char ** argv) {
+	Options options;
+	options.basePath = fs::path (argv[0]).parent_path ().string ();
+	std::string mesh = DEFAULT_MESH_FILENAME;
+	for (int i = 1; i < argc; i++) {
+		std::string argument = argv[i];
+		if (i + 1 >= argc)
+			usage (argv[0]);
+		std::string value = argv[++i];
+		try {
+			if (argument == "--scene")
+				options.scene = std::stoi (value);
+			else if (argument == "--resolution") {
+				size_t separator = value.find ('x');
+				if (separator == std::string::npos)
+					usage (argv[0]);
+				options.width = std::stoi (value.substr (0, separator));
+				options.height = std::stoi (value.substr (separator + 1));
+			} else if (argument == "--spp")
+				options.samplesPerPixel = std::stoi (value);
+			else if (argument == "--adaptive")
+				options.maxSamplesPerPixel = std::stoi (value);
+			else if (argument == "--threshold")
+				options.adaptiveThreshold = std::stof (value);
+			else if (argument == "--sampler") {
+				int type = 0;
+				while (type <= static_cast<int> (SamplerType::BlueNoise) && value != Sampler::name (static_cast<SamplerType> (type)))
+					type++;
+				if (type > static_cast<int> (SamplerType::BlueNoise))
+					usage (argv[0]);
+				options.samplerType = static_cast<SamplerType> (type);
+			}
+			else if (argument == "--light-cutoff")
+				options.lightCutoff = std::stof (value);
+			else if (argument == "--light-samples")
+				options.numOfLightSamples = std::stoi (value);
+			else if (argument == "--threads")
+				options.numOfThreads = std::stoi (value);
+			else if (argument == "--seed")
+				options.seed = static_cast<unsigned int> (std::stoul (value));
+			else if (argument == "--camera") {
+				options.hasTranslation = true;
+				options.translation = parseVec3 (value, argv[0]);
+			} else if (argument == "--rotation") {
+				options.hasRotation = true;
+				options.rotation = parseVec3 (value, argv[0]);
+			} else if (argument == "--fov")
+				options.fov = std::stof (value);
+			else if (argument == "--output")
+				options.output = value;
+			else if (argument == "--cost") {
+				if (value == "time")
+					options.costMetric = CostMetric::Time;
+				else if (value == "nodes")
+					options.costMetric = CostMetric::NodesVisited;
+				else if (value == "impulses")
+					options.costMetric = CostMetric::NoiseImpulses;
+				else if (value == "samples")
+					options.costMetric = CostMetric::Samples;
+				else
+					usage (argv[0]);
+			}
+			else if (argument == "--trace")
+				options.trace = value;
+			else if (argument == "--resources")
+				options.basePath = value;
+			else if (argument == "--mesh")
+				mesh = value;
+			else
+				usage (argv[0]);
+		} catch (std::exception &) {
+			usage (argv[0]);
+		}
+	}
+	if (options.scene < 0 || options.scene >= Scenes::NUM_OF_SCENES || options.width <= 0 || options.height <= 0)
+		usage (argv[0]);
+	if (options.basePath.empty ())
+		options.basePath = ".";
+	options.meshFilename = options.basePath + "/" + mesh;
+	return options;
+}
+
+int main (int argc, char ** argv) {
+	Options options = parseCommandLine (argc, argv);
+	if (!options.trace.empty ())
+		Profiler::start ();
+	std::chrono::high_resolution_clock clock;
+
+	std::chrono::time_point<std::chrono::high_resolution_clock> before = clock.now ();
+	Scenes::Settings settings = { options.basePath, options.meshFilename, static_cast<float> (options.width) / static_cast<float> (options.height), options.seed };
+	std::shared_ptr<Scene> scenePtr = Scenes::build (options.scene, settings);
+	std::shared_ptr<Camera> cameraPtr = scenePtr->camera ();
+	if (options.hasTranslation)
+		cameraPtr->setTranslation (options.translation);
+	if (options.hasRotation)
+		cameraPtr->setRotation (glm::radians (options.rotation));
+	if (options.fov > 0.f)
+		cameraPtr->setFoV (options.fov);
+	double sceneTime = std::chrono::duration<double, std::milli> (clock.now () - before).count ();
+
+	RayTracer rayTracer;
+	rayTracer.setResolution (options.width, options.height);
+	rayTracer.setSamplesPerPixel (options.samplesPerPixel);
+	rayTracer.setAdaptiveSampling (options.maxSamplesPerPixel, options.adaptiveThreshold);
+	rayTracer.setSamplerType (options.samplerType);
+	rayTracer.setLightCutoff (options.lightCutoff);
+	rayTracer.setNumOfLightSamples (options.numOfLightSamples);
+	rayTracer.setNumOfThreads (options.numOfThreads);
+	rayTracer.setSeed (options.seed);
+	rayTracer.setCostMetric (options.costMetric);
+	rayTracer.init (scenePtr);
+	before = clock.now ();
+	rayTracer.render (scenePtr);
+	double renderTime = std::chrono::duration<double, std::milli> (clock.now () - before).count ();
+
+	// The ray traced image is stored bottom-up
+	rayTracer.image ()->flipVertically ();
+	if (!rayTracer.image ()->savePPM (options.output)) {
+		Console::log (Console::Severity::Error, "Cannot write " + options.output);
+		return EXIT_FAILURE;
+	}
+	if (options.costMetric != CostMetric::None) {
+		fs::path costOutput (options.output);
+		costOutput.replace_filename (costOutput.stem ().string () + "_cost" + costOutput.extension ().string ());
+		rayTracer.costHeatmap ()->flipVertically ();
+		if (!rayTracer.costHeatmap ()->savePPM (costOutput.string ())) {
+			Console::log (Console::Severity::Error, "Cannot write " + costOutput.string ());
+			return EXIT_FAILURE;
+		}
+	}
+	if (!options.trace.empty ()) {
+		Profiler::stop ();
+		if (!Profiler::saveChromeTrace (options.trace))
+			Console::log (Console::Severity::Error, "Cannot write " + options.trace);
+	}
+	Console::print ("Scene built in " + std::to_string (sceneTime) + "ms, rendered in " + std::to_string (renderTime) + "ms, saved to " + options.output);
+	return EXIT_SUCCESS;
+}
@@ -9,12 +9,168 @@
 #include "Console.h"
 
 #include <iostream>
+#include <chrono>
+#include <condition_variable>
+#include <mutex>
+#include <thread>
 
 using namespace std;
 
-bool Console::sm_verbose = true;
+namespace {
 
-std::ostream * Console::sm_output = &std::cout;
+int64_t nowInNanoseconds () {
+    return chrono::duration_cast<chrono::nanoseconds> (chrono::steady_clock::now ().time_since_epoch ()).count ();
+}
+
+struct Message {
+    Message * next;
+    Console::Severity severity;
+    bool prefix;
+    std::string text;
+};
+
+/// Multi-producer, single-consumer message queue: producers push onto a lock-free stack, that the writer thread
+/// takes as a whole and reverses to write the messages in the order they were pushed.
+class Logger {
+public:
+    Logger () : m_output (&std::cout) {}
+
+    ~Logger () {
+        {
+            std::lock_guard<std::mutex> lock (m_mutex);
+            m_stop = true;
+        }
+        m_wakeWriter.notify_one ();
+        if (m_writer.joinable ())
+            m_writer.join ();
+    }
+
+    /// Returns false if the message was dropped because too many are pending.
+    bool push (Console::Severity severity, std::string && text, bool prefix) {
+        if (severity <= Console::Severity::Info && m_numOfPending.load (std::memory_order_relaxed) >= Console::MAX_PENDING_MESSAGES) {
+            m_numOfDropped.fetch_add (1, std::memory_order_relaxed);
+            return false;
+        }
+        std::call_once (m_writerStarted, [this] () { m_writer = std::thread (&Logger::write, this); });
+        Message * message = new Message { nullptr, severity, prefix, std::move (text) };
+        m_numOfPending.fetch_add (1, std::memory_order_relaxed);
+        m_numOfEnqueued.fetch_add (1, std::memory_order_relaxed);
+        message->next = m_stack.load (std::memory_order_relaxed);
+        while (!m_stack.compare_exchange_weak (message->next, message, std::memory_order_release, std::memory_order_relaxed));
+        // Only the first message of a batch wakes the writer up. Without holding the mutex, the notification may be
+        // missed by a writer about to wait, which then waits for the timeout.
+        if (!message->next)
+            m_wakeWriter.notify_one ();
+        return true;
+    }
+
+    void flush () {
+        size_t target = m_numOfEnqueued.load ();
+        if (m_numOfWritten.load () >= target)
+            return;
+        m_wakeWriter.notify_one ();
+        std::unique_lock<std::mutex> lock (m_mutex);
+        m_written.wait (lock, [&] () { return m_numOfWritten.load () >= target; });
+    }
+
+    std::ostream & output () { return *m_output.load (); }
+
+    void setOutput (std::ostream * stream) { m_output.store (stream); }
+
+private:
+    void write () {
+        std::unique_lock<std::mutex> lock (m_mutex);
+        while (true) {
+            m_wakeWriter.wait_for (lock, chrono::milliseconds (10), [this] () {
+                return m_stop || m_stack.load (std::memory_order_relaxed);
+            });
+            bool stop = m_stop;
+            lock.unlock ();
+            writeBatch ();
+            lock.lock ();
+            m_written.notify_all ();
+            if (stop && !m_stack.load ())
+                return;
+        }
+    }
+
+    void writeBatch () {
+        Message * reversed = m_stack.exchange (nullptr, std::memory_order_acquire);
+        Message * ordered = nullptr;
+        while (reversed) {
+            Message * next = reversed->next;
+            reversed->next = ordered;
+            ordered = reversed;
+            reversed = next;
+        }
+        std::ostream & out = output ();
+        size_t numOfMessages = 0;
+        while (ordered) {
+            writeMessage (out, ordered->severity, ordered->text, ordered->prefix);
+            Message * next = ordered->next;
+            delete ordered;
+            ordered = next;
+            numOfMessages++;
+        }
+        size_t numOfDropped = m_numOfDropped.exchange (0, std::memory_order_relaxed);
+        if (numOfDropped)
+            writeMessage (out, Console::Severity::Warning, std::to_string (numOfDropped) + " messages dropped, the console could not keep up", true);
+        if (numOfMessages || numOfDropped)
+            out << std::flush;
+        m_numOfPending.fetch_sub (numOfMessages, std::memory_order_relaxed);
+        m_numOfWritten.fetch_add (numOfMessages);
+    }
+
+    static void writeMessage (std::ostream & out, Console::Severity severity, const std::string & text, bool prefix) {
+        static const char * severityPrefixes[] = { "[MyRenderer][Debug] ", "[MyRenderer] ", "[MyRenderer][Warning] ", "[MyRenderer][Error] " };
+        if (prefix)
+            out << severityPrefixes[static_cast<int> (severity)];
+        out << text;
+        if (prefix)
+            out << '\n';
+    }
+
+    std::atomic<Message *> m_stack { nullptr };
+    std::atomic<size_t> m_numOfPending { 0 };
+    std::atomic<size_t> m_numOfEnqueued { 0 };
+    std::atomic<size_t> m_numOfWritten { 0 };
+    std::atomic<size_t> m_numOfDropped { 0 };
+    std::atomic<std::ostream *> m_output;
+    std::once_flag m_writerStarted;
+    std::thread m_writer;
+    std::mutex m_mutex; // only guards the writer sleep and m_stop
+    std::condition_variable m_wakeWriter;
+    std::condition_variable m_written;
+    bool m_stop = false;
+};
+
+/// Destroyed at exit, after writing the pending messages.
+Logger & logger () {
+    static Logger instance;
+    return instance;
+}
+
+}
+
+std::atomic<bool> Console::sm_verbose (true);
+
+std::atomic<int> Console::sm_minSeverity (static_cast<int> (Console::Severity::Debug));
+
+Console::RateLimiter::RateLimiter (double intervalInSeconds)
+    : m_interval (static_cast<int64_t> (intervalInSeconds * 1e9)), m_next (0), m_suppressed (0) {}
+
+bool Console::RateLimiter::allow () {
+    int64_t now = nowInNanoseconds ();
+    int64_t next = m_next.load (std::memory_order_relaxed);
+    if (now >= next && m_next.compare_exchange_strong (next, now + m_interval, std::memory_order_relaxed))
+        return true;
+    m_suppressed.fetch_add (1, std::memory_order_relaxed);
+    return false;
+}
+
+size_t Console::RateLimiter::takeSuppressed () {
+    return m_suppressed.exchange (0, std::memory_order_relaxed);
+}
 
 void Console::toggleVerbose (bool verbose) {
     sm_verbose = verbose;
@@ -24,24 +180,45 @@ bool Console::isVerbose () {
     return sm_verbose;
 }
 
+void Console::setMinSeverity (Severity severity) {
+    sm_minSeverity = static_cast<int> (severity);
+}
+
 void Console::print (const std::string & message, bool prefix) {
-    if (Console::isVerbose ()) {
-        if (prefix)
-            *sm_output << "[MyRenderer] ";
-        *sm_output << message; 
-        if (prefix)
-            *sm_output << std::endl;
-        *sm_output << std::flush;
+    if (Console::isVerbose () && sm_minSeverity.load (std::memory_order_relaxed) <= static_cast<int> (Severity::Info))
+        enqueue (Severity::Info, std::string (message), prefix);
+}
+
+void Console::log (Severity severity, const std::string & message, RateLimiter * limiter) {
+    if (!Console::isVerbose () || static_cast<int> (severity) < sm_minSeverity.load (std::memory_order_relaxed))
+        return;
+    if (limiter == nullptr) {
+        enqueue (severity, std::string (message), true);
+        return;
     }
+    if (!limiter->allow ())
+        return;
+    size_t numOfSuppressed = limiter->takeSuppressed ();
+    enqueue (severity, numOfSuppressed ? message + " (" + std::to_string (numOfSuppressed) + " similar messages suppressed)" : std::string (message), true);
+}
+
+void Console::enqueue (Severity severity, std::string && message, bool prefix) {
+    logger ().push (severity, std::move (message), prefix);
+    // Errors are written before returning, as the program may not survive them
+    if (severity == Severity::Error)
+        logger ().flush ();
+}
+
+void Console::flush () {
+    logger ().flush ();
 }
 
 void Console::clear () {
-    sm_output->clear ();
+    flush ();
+    logger ().output ().clear ();
 }
 
 void Console::setStream (std::ostream * stream) {
-    if (stream == nullptr)
-        Console::sm_output = &std::cout;
-    else
-        Console::sm_output = stream;
+    flush ();
+    logger ().setOutput (stream == nullptr ? &std::cout : stream);
 }
@@ -10,28 +10,64 @@
 
 #include <string>
 #include <iostream>
+#include <atomic>
+#include <cstdint>
 
 /// Provides a basic TTI service. Fire message on the standard output by default.
+/// Messages are queued without locks by any thread and written by a background thread, in the order of the queue:
+/// printing never waits for the output stream. When too many messages are pending, the debug and info ones are
+/// dropped (and counted) rather than growing the queue.
 class Console {
 public:
 
+    enum class Severity { Debug, Info, Warning, Error };
+
+    /// Lets through at most one message per interval, e.g. as a static instance at a call site of a hot path.
+    /// The next message let through tells how many were suppressed.
+    class RateLimiter {
+    public:
+        explicit RateLimiter (double intervalInSeconds);
+        /// True if a message may be printed now. Otherwise, counts it as suppressed.
+        bool allow ();
+        /// Messages suppressed since the last one allowed, reset by the call.
+        size_t takeSuppressed ();
+
+    private:
+        int64_t m_interval;
+        std::atomic<int64_t> m_next;
+        std::atomic<size_t> m_suppressed;
+    };
+
     /// Print a message on output stream.
     static void print (const std::string & message, bool prefix = true);
 
+    /// Print a prefixed message of the given severity, skipped below the minimum severity or when 'limiter' refuses it.
+    static void log (Severity severity, const std::string & message, RateLimiter * limiter = nullptr);
+
+    /// Messages below this severity are skipped. Debug by default.
+    static void setMinSeverity (Severity severity);
+
     /// Toggle message firing. On by default.
     static void toggleVerbose (bool verbose);
 
     /// Indicate whether message are effectively fired
     static bool isVerbose ();
 
+    /// Waits until the messages queued so far are written.
+    static void flush ();
+
     /// Erase all previous messages
     static void clear ();
 
-    /// Change the output stream of the console. Reset to standard output if stream is null.
+    /// Change the output stream of the console, once the pending messages are written. Reset to standard output if stream is null.
     static void setStream (std::ostream * stream);
 
+    /// Maximum number of messages waiting for the output, beyond which debug and info messages are dropped.
+    static constexpr size_t MAX_PENDING_MESSAGES = 1 << 14;
+
 private:
-    static bool sm_verbose;
-    static std::ostream * sm_output;
-};
+    static void enqueue (Severity severity, std::string && message, bool prefix);
 
+    static std::atomic<bool> sm_verbose;
+    static std::atomic<int> sm_minSeverity;
+};
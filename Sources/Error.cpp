@@ -65,20 +65,24 @@ void debugMessageCallback (GLenum source,
 	else if (type == GL_DEBUG_TYPE_OTHER)
 		typeString = "Other";
 
-	Console::print (std::string("\n\t----------------") + "\n"
+	// Non critical messages may be fired at every frame
+	static Console::RateLimiter limiter (1.0);
+	Console::log (type == GL_DEBUG_TYPE_ERROR ? Console::Severity::Error : Console::Severity::Warning,
+				  std::string("\n\t----------------") + "\n"
 			  		+ "\t[OpenGL Callback Message]: " + ( type == GL_DEBUG_TYPE_ERROR ? std::string ("** CRITICAL **") : std::string ("** NON CRITICAL **") ) + "\n"
 			  		+ "\t    source = " + sourceString + "\n"
 			  		+ "\t    type = " + typeString + "\n"
 			  		+ "\t    severity = " + severityString + "\n"
 			  		+ "\t    message = " + message + "\n" + "\n"
-					+ std::string("\t----------------") + "\n");  
+					+ std::string("\t----------------") + "\n",
+				  type == GL_DEBUG_TYPE_ERROR ? nullptr : &limiter);
 	
 	if (type == GL_DEBUG_TYPE_ERROR) 
 		std::exit (EXIT_FAILURE);
 }
 
 void exitOnCriticalError (const std::string & message) {
-	Console::print (std::string("[Critical error]") + message +"\n");
+	Console::log (Console::Severity::Error, std::string("[Critical error]") + message +"\n");
 	//std::cerr << "> [Clearing resources]" << std::endl;
 	Console::print (std::string("[Quit]\n"));
 	std::exit (EXIT_FAILURE);
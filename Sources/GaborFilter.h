@@ -0,0 +1,52 @@
+/*
+    analytical filtering of the Gabor kernel, following section 5 of the "Procedural Noise using Sparse Gabor Convolution" article
+*/
+
+#pragma once
+
+#define _USE_MATH_DEFINES
+#include <cmath>
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#ifndef M_PI
+#  define M_PI 3.14159265358979323846
+#endif
+
+/// Gabor kernel K exp(-pi a^2 |x|^2) cos(2 pi <f, x>) convolved with a gaussian pixel filter of covariance 'footprint'.
+/// The spectrum of the kernel is made of two gaussian bumps at +-f, so the product with the (gaussian) spectrum of the
+/// filter is again a pair of gaussian bumps: the filtered kernel is still a Gabor kernel, with an anisotropic envelope,
+/// a shifted frequency and a reduced magnitude. Evaluating the noise with it gives the band-limited value directly,
+/// without supersampling. A null footprint gives back the unfiltered kernel.
+/// The footprint is expressed in kernel coordinates, i.e. in the space where the envelope is exp(-pi a^2 |x|^2).
+template <glm::length_t L>
+class FilteredGabor {
+public:
+	using vec = glm::vec<L, float, glm::defaultp>;
+	using mat = glm::mat<L, L, float, glm::defaultp>;
+
+	FilteredGabor(float a, const mat& footprint) {
+		// Covariance of each spectral bump of the unfiltered kernel
+		float kernelSpectralVariance = float(a * a / (2.0 * M_PI));
+		mat kernelPrecision = mat(1.0f / kernelSpectralVariance);
+		m_spectralCovariance = glm::inverse(kernelPrecision + float(4.0 * M_PI * M_PI) * footprint);
+		m_frequencyTransform = m_spectralCovariance * kernelPrecision;
+		m_frequencyDamping = kernelPrecision - kernelPrecision * m_spectralCovariance * kernelPrecision;
+		m_magnitudeScale = std::sqrt(glm::determinant(m_spectralCovariance) / std::pow(kernelSpectralVariance, float(L)));
+	}
+
+	/// Filtered kernel of magnitude K and frequency vector f, evaluated at x.
+	inline float operator()(float K, const vec& f, const vec& x) const {
+		vec filteredFrequency = m_frequencyTransform * f;
+		float damping = std::exp(-0.5f * glm::dot(f, m_frequencyDamping * f));
+		float gaussianEnvelop = std::exp(float(-2.0 * M_PI * M_PI) * glm::dot(x, m_spectralCovariance * x));
+		float sinusoidalCarrier = std::cos(float(2.0 * M_PI) * glm::dot(filteredFrequency, x));
+		return K * m_magnitudeScale * damping * gaussianEnvelop * sinusoidalCarrier;
+	}
+
+private:
+	mat m_spectralCovariance;
+	mat m_frequencyTransform;
+	mat m_frequencyDamping;
+	float m_magnitudeScale;
+};
@@ -15,10 +15,12 @@
 #include <algorithm>
 
 #include "Console.h"
+#include "Profiler.h"
 
 using namespace std;
 
 std::shared_ptr<Mesh> IO::loadOFFMesh (const std::string & filename, int index, bool sphericalUV) {
+    PROFILE_SCOPE ("IO::loadOFFMesh");
     Console::print ("Start loading mesh <" + filename + ">");
     auto meshPtr = std::make_shared<Mesh>(index);
     ifstream in (filename.c_str ());
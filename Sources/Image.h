@@ -48,12 +48,17 @@ public:
 				m_pixels[y*m_width+x] = color;
 	}
 
-	inline void savePPM (const std::string & filename) {
+	/// Swap the rows, e.g. to write bottom-up images (as displayed by OpenGL) to top-down files.
+	inline void flipVertically () {
+		for (size_t y = 0; y < m_height / 2; y++)
+			std::swap_ranges (m_pixels.begin () + y*m_width, m_pixels.begin () + (y+1)*m_width, m_pixels.begin () + (m_height-1-y)*m_width);
+	}
+
+	/// Returns false if the file cannot be written.
+	inline bool savePPM (const std::string & filename) {
 		std::ofstream out (filename.c_str ());
-    	if (!out) {
-        	std::cerr << "Cannot open file " << filename.c_str() << std::endl;
-        	std::exit (1);
-    	}
+    	if (!out)
+        	return false;
     	out << "P3" << std::endl
     		<< m_width << " " << m_height << std::endl
     		<< "255" << std::endl;
@@ -65,6 +70,7 @@ public:
 			}
 			out << std::endl;
     	out.close ();
+    	return !out.fail ();
 	}
 
 private:
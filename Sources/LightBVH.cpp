@@ -0,0 +1,115 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#include "LightBVH.h"
+
+#include <algorithm>
+#include <cmath>
+#include <limits>
+
+#include <glm/ext.hpp>
+
+/// Radiance of a light at unit attenuation, in its brightest channel (see RayTracer::lightRadiance).
+static inline float lightPower(const LightSource& light) {
+	glm::vec3 color = light.color();
+	return light.intensity() * glm::pi<float>() * std::max(color.r, std::max(color.g, color.b));
+}
+
+LightBVH::LightBVH(const std::vector<std::shared_ptr<LightSource>>& lights, float cutoff) {
+	std::vector<int> pointLights;
+	std::vector<float> ranges(lights.size(), 0.f);
+	for (int i = 0; i < static_cast<int>(lights.size()); i++) {
+		if (lights[i]->type() == LightType::DirectionalLight) {
+			m_directionalLights.push_back(i);
+			continue;
+		}
+		ranges[i] = range(*lights[i], cutoff);
+		// Out of range everywhere
+		if (ranges[i] > 0.f)
+			pointLights.push_back(i);
+	}
+	if (!pointLights.empty())
+		m_root = std::make_unique<Node>(lights, ranges, pointLights);
+}
+
+float LightBVH::range(const LightSource& light, float cutoff) {
+	if (cutoff <= 0.f)
+		return std::numeric_limits<float>::infinity();
+	// Solves c + l d + q d^2 = power / cutoff, for the attenuation (c, l, q)
+	glm::vec3 attenuation = light.attenuation();
+	float c = attenuation.x - lightPower(light) / cutoff;
+	float l = attenuation.y;
+	float q = attenuation.z;
+	if (c >= 0.f)
+		return 0.f;
+	if (q > 0.f)
+		return (-l + std::sqrt(l * l - 4.f * q * c)) / (2.f * q);
+	if (l > 0.f)
+		return -c / l;
+	return std::numeric_limits<float>::infinity();
+}
+
+int LightBVH::sampleLight(const glm::vec3& position, const glm::vec3& n, float u, float& pdf) const {
+	pdf = 1.f;
+	if (!m_root || !m_root->mayReach(position, n))
+		return -1;
+	const Node* node = m_root.get();
+	while (node->lightIndex() < 0) {
+		float leftImportance = node->left()->importance(position, n);
+		float rightImportance = node->right()->importance(position, n);
+		if (leftImportance + rightImportance <= 0.f)
+			return -1;
+		float leftProbability = leftImportance / (leftImportance + rightImportance);
+		// 'u' is rescaled to [0, 1) within the chosen interval, for the next choices
+		if (u < leftProbability) {
+			node = node->left();
+			pdf *= leftProbability;
+			u = u / leftProbability;
+		} else {
+			node = node->right();
+			pdf *= 1.f - leftProbability;
+			u = (u - leftProbability) / (1.f - leftProbability);
+		}
+		u = std::min(u, 1.f - std::numeric_limits<float>::epsilon());
+	}
+	return node->lightIndex();
+}
+
+LightBVH::Node::Node(const std::vector<std::shared_ptr<LightSource>>& lights, const std::vector<float>& ranges, std::vector<int>& indices)
+	: m_power(0.f), m_range(0.f), m_attenuation(std::numeric_limits<float>::max()), m_lightIndex(-1) {
+	m_bounds.init(lights[indices[0]]->center());
+	for (int index : indices) {
+		m_bounds.extendTo(lights[index]->center());
+		m_power += lightPower(*lights[index]);
+		m_range = std::max(m_range, ranges[index]);
+		m_attenuation = glm::min(m_attenuation, lights[index]->attenuation());
+	}
+	if (indices.size() == 1) {
+		m_lightIndex = indices[0];
+		return;
+	}
+	size_t axis = m_bounds.dominantAxis();
+	std::vector<int>::iterator middle = indices.begin() + indices.size() / 2;
+	std::nth_element(indices.begin(), middle, indices.end(), [&](int a, int b) {
+		return lights[a]->center()[axis] < lights[b]->center()[axis];
+	});
+	std::vector<int> leftIndices(indices.begin(), middle);
+	std::vector<int> rightIndices(middle, indices.end());
+	m_left = std::make_unique<Node>(lights, ranges, leftIndices);
+	m_right = std::make_unique<Node>(lights, ranges, rightIndices);
+}
+
+float LightBVH::Node::importance(const glm::vec3& position, const glm::vec3& n) const {
+	if (!mayReach(position, n))
+		return 0.f;
+	// Upper bound of the attenuated power, at the nearest point of the node with the weakest attenuation of its lights.
+	// Bounding rather than estimating keeps the probability of a light reaching the point from getting much lower than
+	// its share of the lighting, which would show as outliers.
+	float d = glm::distance(glm::clamp(position, m_bounds.min(), m_bounds.max()), position);
+	return m_power / std::max(m_attenuation.x + m_attenuation.y * d + m_attenuation.z * d * d, 1e-4f);
+}
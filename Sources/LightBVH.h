@@ -0,0 +1,106 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#pragma once
+
+#include <memory>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "BoundingBox.h"
+#include "LightSource.h"
+
+/// Bounding volume hierarchy of the point lights of a scene, splitting their positions at the median along the dominant
+/// axis as the triangle BVH does. Each node bounds the power of its lights and their range: the distance beyond which
+/// their attenuated radiance falls below a cutoff. Shading points then find the lights reaching them, or sample a few
+/// lights by importance, without looping over all of them. Directional lights reach everywhere and are only listed.
+class LightBVH {
+public:
+	LightBVH() = delete;
+
+	/// Hierarchy of the point lights of 'lights', with ranges for the given radiance cutoff (infinite if not positive).
+	LightBVH(const std::vector<std::shared_ptr<LightSource>>& lights, float cutoff);
+
+	/// Indices of the directional lights.
+	inline const std::vector<int>& directionalLights() const { return m_directionalLights; }
+
+	/// Calls visit(lightIndex) for each point light within range of 'position' and above its tangent plane (normal 'n').
+	template <typename Visitor>
+	void visitLights(const glm::vec3& position, const glm::vec3& n, const Visitor& visit) const;
+
+	/// Selects a point light with a probability proportional to a bound of its contribution at 'position', by
+	/// descending the hierarchy with the uniform number 'u' in [0, 1). Returns its index and sets 'pdf' to its
+	/// probability, or returns -1 if no light reaches the point.
+	/// The lights out of range are never selected: the estimate misses their contribution unless the hierarchy was
+	/// built without a cutoff, as RayTracer does when sampling.
+	int sampleLight(const glm::vec3& position, const glm::vec3& n, float u, float& pdf) const;
+
+	/// Distance beyond which the radiance of a point light falls below 'cutoff', infinite if the cutoff is not positive.
+	static float range(const LightSource& light, float cutoff);
+
+private:
+	class Node;
+
+	std::vector<int> m_directionalLights;
+	std::unique_ptr<Node> m_root;
+};
+
+class LightBVH::Node {
+public:
+	Node(const std::vector<std::shared_ptr<LightSource>>& lights, const std::vector<float>& ranges, std::vector<int>& indices);
+
+	/// Bound of the contribution of the lights of the node at 'position', 0 if none of them reaches it.
+	float importance(const glm::vec3& position, const glm::vec3& n) const;
+
+	/// False if no light of the node can reach the point.
+	inline bool mayReach(const glm::vec3& position, const glm::vec3& n) const {
+		glm::vec3 nearest = glm::clamp(position, m_bounds.min(), m_bounds.max());
+		if (glm::distance(nearest, position) > m_range)
+			return false;
+		// Lights below the tangent plane, i.e. all the corners of the box
+		for (int corner = 0; corner < 8; corner++) {
+			glm::vec3 p((corner & 1) ? m_bounds.max().x : m_bounds.min().x, (corner & 2) ? m_bounds.max().y : m_bounds.min().y,
+				(corner & 4) ? m_bounds.max().z : m_bounds.min().z);
+			if (dot(p - position, n) > 0.f)
+				return true;
+		}
+		return false;
+	}
+
+	template <typename Visitor>
+	void visit(const glm::vec3& position, const glm::vec3& n, const Visitor& visitor) const {
+		if (!mayReach(position, n))
+			return;
+		if (m_lightIndex >= 0) {
+			visitor(m_lightIndex);
+			return;
+		}
+		m_left->visit(position, n, visitor);
+		m_right->visit(position, n, visitor);
+	}
+
+	inline const Node* left() const { return m_left.get(); }
+	inline const Node* right() const { return m_right.get(); }
+	inline int lightIndex() const { return m_lightIndex; }
+
+private:
+	BoundingBox m_bounds; // of the light positions
+	float m_power; // sum of the radiances of the lights at unit attenuation
+	float m_range; // largest range of the lights
+	glm::vec3 m_attenuation; // weakest attenuation coefficients of the lights, per coefficient
+	std::unique_ptr<Node> m_left;
+	std::unique_ptr<Node> m_right;
+	int m_lightIndex; // of a leaf, -1 for an internal node
+};
+
+template <typename Visitor>
+void LightBVH::visitLights(const glm::vec3& position, const glm::vec3& n, const Visitor& visit) const {
+	if (m_root)
+		m_root->visit(position, n, visit);
+}
@@ -16,9 +16,12 @@ public:
 	inline const LightType type() const { return m_type; }
 	inline const glm::vec3 color() const { return m_color; }
 	inline  glm::vec3 color() { return m_color; }
+	inline void setColor(const glm::vec3& color) { m_color = color; }
+	inline const glm::vec3 attenuation() const { return m_attenuation; }
 	inline  glm::vec3 attenuation() { return m_attenuation; }
 	inline const float intensity() const { return m_intensity; }
 	inline  float intensity() { return m_intensity; }
+	inline void setIntensity(float intensity) { m_intensity = intensity; }
 private:
 	LightType m_type;
 	Transform m_transform;
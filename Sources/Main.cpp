@@ -18,10 +18,12 @@
 #include <vector>
 #include <string>
 #include <cmath>
+#include <ctime>
 #include <memory>
 #include <algorithm>
 #include <exception>
 #include <filesystem>
+#include <thread>
 
 namespace fs = std::filesystem;
 
@@ -32,18 +34,14 @@ namespace fs = std::filesystem;
 #include "Resources.h"
 #include "Error.h"
 #include "Console.h"
-#include "IO.h"
-#include "Material.h"
-#include "Texture.h"
-#include "Model.h"
+#include "Profiler.h"
 #include "Scene.h"
+#include "Scenes.h"
 #include "Image.h"
 #include "Rasterizer.h"
 #include "RayTracer.h"
-#include "LightSource.h"
-#include "SetupFreeNoise.h"
-#include "Solid3DNoise.h"
-#include "Texture2DNoise.h"
+#include "RenderJob.h"
+#include "ResolutionController.h"
 
 using namespace std;
 
@@ -52,14 +50,13 @@ static GLFWwindow * windowPtr = nullptr;
 static std::shared_ptr<Scene> scenePtr;
 static std::shared_ptr<Rasterizer> rasterizerPtr;
 static std::shared_ptr<RayTracer> rayTracerPtr;
+static std::shared_ptr<RenderJob> renderJobPtr;
 
 int current_scene = 1;
 bool swap_scene = false;
 
 // Camera control variables
-static glm::vec3 center = glm::vec3 (0.0); // To update based on the mesh position
-static float meshScale = 1.0; // To update based on the mesh size, so that navigation runs at scale
-static float setScale = 2.5f; 
+static float setScale = Scenes::SCALE; // so that navigation runs at the scale of the scenes
 static bool isRotating (false);
 static bool isPanning (false);
 static bool isZooming (false);
@@ -73,11 +70,18 @@ static std::string meshFilename;
 
 // Raytraced rendering
 static bool isDisplayRaytracing (false);
+static bool isDisplayCost (false);
+
+// Ray traced viewport: while the view changes, frames are ray traced at the resolution meeting the frame time budget;
+// once it stops, a progressive render converges to the full resolution in the background
+static ResolutionController resolutionController (33.f);
+static bool isViewChanged (false);
+static bool isViewConverging (false);
+// Light edits relight the last render from its G-buffer, displayed until the next render
+static bool isLightingChanged (false);
+static bool isDisplayRelit (false);
 
 void clear ();
-void initScene1();
-void initScene2();
-void initScene3();
 
 void printHelp () {
 	Console::print (std::string ("Help:\n") 
@@ -91,19 +95,65 @@ void printHelp () {
    			  + "\t* F12: reload GPU shaders\n"
    			  + "\t* F: decrease field of view\n"
    			  + "\t* G: increase field of view\n"
-   			  + "\t* TAB: switch between rasterization and ray tracing display\n"
+   			  + "\t* TAB: switch between rasterization and the ray traced viewport (scaled to 33ms per frame while the view changes)\n"
    			  + "\t* B: activate BVH\n"
    			  + "\t* N: deactivate BVH\n"
+   			  + "\t* D: toggle ray differentials (filtered texture and noise lookups)\n"
+   			  + "\t* T: cycle CPU texture filtering (bilinear, trilinear, anisotropic)\n"
+   			  + "\t* A: toggle adaptive supersampling (batches of 4 samples, up to 32 per pixel) of the single pass renders\n"
+   			  + "\t* C: cycle the per pixel cost recorded by the ray tracer (none, time, BVH nodes, noise impulses, samples)\n"
+   			  + "\t* V: toggle the display of the cost heatmap instead of the ray traced image\n"
+   			  + "\t* P: start / stop a profiling capture, saved to trace.json (Chrome trace format)\n"
+   			  + "\t* M: cycle the reprojection of the ray traced viewport while the camera moves (off, reuse hits, reuse colors)\n"
+   			  + "\t* L: cycle the color of the lights (relights the last ray traced image without retracing it)\n"
+   			  + "\t* R: toggle progressive ray tracing (coarse preview refined up to 64 spp) or single pass\n"
    			  + "\t* S: swap scene\n"
-   			  + "\t* SPACE: execute ray tracing\n");
+   			  + "\t* SPACE: execute ray tracing in the background (cancelled by camera, scene or settings changes)\n");
 }
 
-/// Adjust the ray tracer target resolution and runs it.
+/// Starts ray tracing in the background at the window resolution.
 void raytrace() {
 	int width, height;
 	glfwGetWindowSize(windowPtr, &width, &height);
-	rayTracerPtr->setResolution (width, height);
-	rayTracerPtr->render (scenePtr);
+	isViewConverging = false;
+	isDisplayRelit = false;
+	renderJobPtr->start (scenePtr, width, height);
+}
+
+/// Ray traces a frame of the viewport within the frame time budget if the view changed, or starts converging to the full
+/// resolution once it stopped. Returns true if a frame was rendered, to display instead of the background render.
+bool updateRayTracedViewport () {
+	int width, height;
+	glfwGetWindowSize (windowPtr, &width, &height);
+	if (isLightingChanged) {
+		isLightingChanged = false;
+		// Also detaches the job from the ray tracer: the relit tiles are displayed from its image, not copied to the job one
+		renderJobPtr->cancel ();
+		if (rayTracerPtr->relight (scenePtr)) {
+			isDisplayRelit = true;
+			return true;
+		}
+		isViewChanged = true;
+	}
+	if (isViewChanged) {
+		isViewChanged = false;
+		isDisplayRelit = false;
+		isViewConverging = true;
+		renderJobPtr->cancel ();
+		glm::ivec2 resolution = resolutionController.resolution (width, height);
+		rayTracerPtr->setResolution (resolution.x, resolution.y);
+		rayTracerPtr->setVerbose (false);
+		double before = glfwGetTime ();
+		rayTracerPtr->render (scenePtr);
+		rayTracerPtr->setVerbose (true);
+		resolutionController.addFrame (resolution.x, resolution.y, static_cast<float> (1000.0 * (glfwGetTime () - before)));
+		return true;
+	}
+	if (isViewConverging) {
+		isViewConverging = false;
+		renderJobPtr->start (scenePtr, width, height, rayTracerPtr->image ());
+	}
+	return false;
 }
 
 /// Executed each time a key is entered.
@@ -116,17 +166,79 @@ void keyCallback (GLFWwindow * windowPtr, int key, int scancode, int action, int
 		} else if (action == GLFW_PRESS && key == GLFW_KEY_F12) {
 			rasterizerPtr->loadShaderProgram (basePath);
 		} else if (action == GLFW_PRESS && key == GLFW_KEY_F) {
+			renderJobPtr->cancel ();
 			scenePtr->camera()->setFoV (std::max (5.f, scenePtr->camera()->getFoV () - 5.f));
+			isViewChanged = true;
 		} else if (action == GLFW_PRESS && key == GLFW_KEY_G) {
+			renderJobPtr->cancel ();
 			scenePtr->camera()->setFoV (std::min (120.f, scenePtr->camera()->getFoV () + 5.f));
+			isViewChanged = true;
 		} else if (action == GLFW_PRESS && key == GLFW_KEY_TAB) {
 			isDisplayRaytracing = !isDisplayRaytracing;
+			isViewChanged = isDisplayRaytracing;
 		} else if (action == GLFW_PRESS && key == GLFW_KEY_B) {
+			renderJobPtr->cancel ();
+			isViewChanged = true;
 			rayTracerPtr->activateBVH(true);
 			Console::print("activate BVH");
 		} else if (action == GLFW_PRESS && key == GLFW_KEY_N) {
+			renderJobPtr->cancel ();
+			isViewChanged = true;
 			rayTracerPtr->activateBVH(false);
 			Console::print("deactivate BVH");
+		} else if (action == GLFW_PRESS && key == GLFW_KEY_D) {
+			renderJobPtr->cancel ();
+			isViewChanged = true;
+			rayTracerPtr->activateRayDifferentials(!rayTracerPtr->rayDifferentialsAreActive());
+			Console::print(rayTracerPtr->rayDifferentialsAreActive() ? "activate ray differentials" : "deactivate ray differentials");
+		} else if (action == GLFW_PRESS && key == GLFW_KEY_T) {
+			renderJobPtr->cancel ();
+			isViewChanged = true;
+			static const char* filterNames[] = { "bilinear", "trilinear", "anisotropic" };
+			int filter = (static_cast<int>(rayTracerPtr->textureFilter()) + 1) % 3;
+			rayTracerPtr->setTextureFilter(static_cast<TextureFilter>(filter));
+			Console::print(std::string("CPU texture filtering: ") + filterNames[filter]);
+		} else if (action == GLFW_PRESS && key == GLFW_KEY_A) {
+			renderJobPtr->cancel ();
+			isViewChanged = true;
+			bool adaptive = !rayTracerPtr->adaptiveSamplingIsActive ();
+			rayTracerPtr->setSamplesPerPixel (adaptive ? 4 : 1);
+			rayTracerPtr->setAdaptiveSampling (adaptive ? 32 : 1, rayTracerPtr->adaptiveThreshold ());
+			Console::print (adaptive ? "activate adaptive supersampling" : "deactivate adaptive supersampling");
+		} else if (action == GLFW_PRESS && key == GLFW_KEY_C) {
+			renderJobPtr->cancel ();
+			static const char* metricNames[] = { "none", "time", "BVH nodes visited", "noise impulses", "samples" };
+			int metric = (static_cast<int>(rayTracerPtr->costMetric()) + 1) % 5;
+			rayTracerPtr->setCostMetric(static_cast<CostMetric>(metric));
+			Console::print(std::string("Per pixel cost: ") + metricNames[metric]);
+		} else if (action == GLFW_PRESS && key == GLFW_KEY_V) {
+			isDisplayCost = !isDisplayCost;
+			Console::print(isDisplayCost ? "display cost heatmap" : "display ray traced image");
+		} else if (action == GLFW_PRESS && key == GLFW_KEY_P) {
+			if (Profiler::isRecording ()) {
+				Profiler::stop ();
+				Console::print (Profiler::saveChromeTrace ("trace.json") ? "profiling capture saved to trace.json" : "cannot write trace.json");
+			} else {
+				Profiler::start ();
+				Console::print ("profiling capture started");
+			}
+		} else if (action == GLFW_PRESS && key == GLFW_KEY_M) {
+			static const char* reprojectionNames[] = { "off", "reuse the hits and materials", "reuse the colors" };
+			renderJobPtr->cancel ();
+			int mode = (static_cast<int>(rayTracerPtr->reprojectionMode()) + 1) % 3;
+			rayTracerPtr->setReprojectionMode(static_cast<ReprojectionMode>(mode));
+			Console::print(std::string("Viewport reprojection: ") + reprojectionNames[mode]);
+		} else if (action == GLFW_PRESS && key == GLFW_KEY_L) {
+			static const glm::vec3 lightColors[] = { glm::vec3 (1.f), glm::vec3 (1.f, 0.8f, 0.6f), glm::vec3 (0.6f, 0.8f, 1.f) };
+			static int lightColor = 0;
+			lightColor = (lightColor + 1) % 3;
+			renderJobPtr->cancel ();
+			for (size_t i = 0; i < scenePtr->numOfLights (); i++)
+				scenePtr->light (i)->setColor (lightColors[lightColor]);
+			isLightingChanged = true;
+		} else if (action == GLFW_PRESS && key == GLFW_KEY_R) {
+			renderJobPtr->setProgressive (!renderJobPtr->isProgressive ());
+			Console::print (renderJobPtr->isProgressive () ? "progressive ray tracing" : "single pass ray tracing");
 		} else if (action == GLFW_PRESS && key == GLFW_KEY_SPACE) {
 			raytrace ();
 		}
@@ -146,6 +258,10 @@ void cursorPosCallback(GLFWwindow* window, double xpos, double ypos) {
 	float normalizer = static_cast<float> ((width + height)/2);
 	float dx = static_cast<float> ((baseX - xpos) / normalizer);
 	float dy = static_cast<float> ((ypos - baseY) / normalizer);
+	if (isRotating || isPanning || isZooming) {
+		renderJobPtr->cancel ();
+		isViewChanged = true;
+	}
 	if (isRotating) {
 		glm::vec3 dRot (-dy * M_PI, dx * M_PI, 0.0);
 		scenePtr->camera()->setRotation (baseRot + dRot);
@@ -187,6 +303,8 @@ void mouseButtonCallback (GLFWwindow * window, int button, int action, int mods)
 
 /// Executed each time the window is resized. Adjust the aspect ratio and the rendering viewport to the current window. 
 void windowSizeCallback (GLFWwindow * windowPtr, int width, int height) {
+	renderJobPtr->cancel ();
+	isViewChanged = true;
 	scenePtr->camera()->setAspectRatio (static_cast<float>(width) / static_cast<float>(height));
 	rasterizerPtr->setResolution (width, height);
 	rayTracerPtr->setResolution (width, height);
@@ -195,7 +313,7 @@ void windowSizeCallback (GLFWwindow * windowPtr, int width, int height) {
 void initGLFW () {
 	// Initialize GLFW, the library responsible for window management
 	if (!glfwInit ()) {
-		Console::print ("ERROR: Failed to init GLFW");
+		Console::log (Console::Severity::Error, "Failed to init GLFW");
 		std::exit (EXIT_FAILURE);
 	}
 
@@ -209,7 +327,7 @@ void initGLFW () {
 	// Create the window
 	windowPtr = glfwCreateWindow (800, 600, BASE_WINDOW_TITLE.c_str (), nullptr, nullptr);
 	if (!windowPtr) {
-		Console::print ("ERROR: Failed to open window");
+		Console::log (Console::Severity::Error, "Failed to open window");
 		glfwTerminate ();
 		std::exit (EXIT_FAILURE);
 	}
@@ -224,461 +342,27 @@ void initGLFW () {
 	glfwSetMouseButtonCallback (windowPtr, mouseButtonCallback);
 }
 
-void initScene1 () {
-	Console::print("init scene 1");
-	
-	scenePtr->clear();
-	
-	Console::print("Scene1 : albedo textures generated using noise (planar uv for walls and spherical uv for others)");
-	scenePtr = std::make_shared<Scene> ();
-	scenePtr->setBackgroundColor (glm::vec3 (0.1f, 0.5f, 0.95f));
-
-	// Meshes
-	auto monkeyMeshPtr = IO::loadOFFMesh(meshFilename, 0, true);
-	auto appleMeshPtr = IO::loadOFFMesh(basePath + "/Resources/Models/Apple.off", 1, true);
-	auto killerooMeshPtr = IO::loadOFFMesh(basePath + "/Resources/Models/killeroo.off", 2, true);
-	auto planMeshPtr = IO::loadOFFMesh(basePath + "/Resources/Models/wall.off", 3, false);
-
-	scenePtr->addMesh(monkeyMeshPtr);
-	scenePtr->addMesh(appleMeshPtr);
-	scenePtr->addMesh(killerooMeshPtr);
-	scenePtr->addMesh(planMeshPtr);
-
-	// ### Textures
-	float K_ = 1.0;
-	float a_ = 0.1;
-	float F_0_ = 0.04;
-	float omega_0_ = M_PI / 4.0;
-	float number_of_impulses_per_kernel = 56.0;
-	unsigned random_offset = std::time(0);
-	prng gen;
-	gen.seed(random_offset);
-	
-	Texture2Dnoise isotropic_Noise1(true, K_, a_ * 1.3f, F_0_ * 4, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999));
-	Texture2Dnoise isotropic_Noise2(true, K_, a_ * 1.3f, F_0_ * 4, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999));
-	Texture2Dnoise anisotropic_Noise1(false, K_, a_ * 1.3f, F_0_ * 4, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999));
-	Texture2Dnoise anisotropic_Noise2(false, K_, a_ * 1.3f, F_0_ * 4, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999));
-	
-	std::vector<glm::vec3> colorMap1 = { glm::vec3(1.0, 1.0, 0.0), glm::vec3(0.0, 1.0, 0.0), glm::vec3(0.0, 0.1, 1.0) };
-	std::vector<glm::vec3> colorMap2 = { glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.0, 0.1, 0.0), glm::vec3(0.0, 0.0, 1.0) };
-	std::vector<glm::vec3> colorMap3 = { glm::vec3(1.0 ,0.0, 1.0), glm::vec3(1.0 ,0.0, 0.0), glm::vec3(0.0 ,0.0, 1.0), glm::vec3(0.0, 1.0, 1.0), glm::vec3(1.0, 1.0, 1.0)};
-	std::vector<glm::vec3> colorMap4 = { glm::vec3(0.99 ,0.98, 0.1), glm::vec3(0.95 ,0.93, 0.1), glm::vec3(0.89 ,0.82, 0.0), glm::vec3(0.7, 0.62, 0.1)};
-	
-	// Textures generated using gabor Noise
-	Console::print("Generating textures and loading them to GPU using Gabor Noise");
-	std::chrono::high_resolution_clock clock;
-	std::chrono::time_point<std::chrono::high_resolution_clock> before = clock.now();
-	TextureBundle textureBundle11 = scenePtr->loadTextureBundle(256, isotropic_Noise1, colorMap1);
-	std::chrono::time_point<std::chrono::high_resolution_clock> after = clock.now();
-	double elapsedTime = (double)std::chrono::duration_cast<std::chrono::milliseconds>(after - before).count();
-	Console::print("Wall Texture: resolution = 256, isotropic gabor noise generated and loaded in " + std::to_string(elapsedTime) + "ms");
-	TextureBundle textureBundle12 = scenePtr->loadTextureBundle(256, anisotropic_Noise1, colorMap1);
-	after = clock.now();
-	elapsedTime = (double)std::chrono::duration_cast<std::chrono::milliseconds>(after - before).count();
-	Console::print("Ground Texture: resolution = 256, anisotropic gabor noise generated and loaded in " + std::to_string(elapsedTime) + "ms");
-	before = clock.now();
-	TextureBundle textureBundle2 = scenePtr->loadTextureBundle(256, isotropic_Noise2, colorMap2); 
-	after = clock.now();
-	elapsedTime = (double)std::chrono::duration_cast<std::chrono::milliseconds>(after - before).count();
-	Console::print("Texture 2 : resolution = 256, isotropic gabor noise generated and loaded in " + std::to_string(elapsedTime) + "ms");
-	before = clock.now();
-	TextureBundle textureBundle3 = scenePtr->loadTextureBundle(256, anisotropic_Noise2, colorMap3);
-	after = clock.now();
-	elapsedTime = (double)std::chrono::duration_cast<std::chrono::milliseconds>(after - before).count();
-	Console::print("Texture 3 : resolution = 256, anisotropic gabor noise generated and loaded in " + std::to_string(elapsedTime) + "ms");
-	TextureBundle textureBundle4 = scenePtr->loadTextureBundle(256, isotropic_Noise2, colorMap4);
-	after = clock.now();
-	elapsedTime = (double)std::chrono::duration_cast<std::chrono::milliseconds>(after - before).count();
-	Console::print("Texture 4 : resolution = 256, isotropic gabor noise generated and loaded in " + std::to_string(elapsedTime) + "ms");
-	Console::print("Textures generation ended");
-
-	// ---------------------------------
-	
-	// ### Materials
-	auto materialPtr11 = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(1,1,0.0), 0.8, 0.05, textureBundle11);
-	scenePtr->addMaterial(materialPtr11);
-	auto materialPtr12 = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(1,1,0.0), 0.8, 0.05, textureBundle12);
-	scenePtr->addMaterial(materialPtr12);
-	auto materialPtr2 = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.2, 0.8), 0.1, 0.1, textureBundle2);
-	scenePtr->addMaterial(materialPtr2);
-	auto materialPtr3 = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(0.8, 1.0, 0.3), 0.1, 0.1, textureBundle3);
-	scenePtr->addMaterial(materialPtr3);
-	auto materialPtr4 = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(0.9, 0.8, 0.2), 0.8, 0.2, textureBundle4);
-	scenePtr->addMaterial(materialPtr4);
-
-	// ---------------------------------
-	
-	// ### Models
-	auto wallPtr = std::make_shared<Model>();
-	wallPtr->transform().setTranslation({ 0 , 0, -7 });
-	wallPtr->transform().setScale(7);
-	wallPtr->useMesh(planMeshPtr->getId());
-	wallPtr->useMaterial(materialPtr11->getId());
-	scenePtr->addModel(wallPtr);
-
-	auto groundlPtr = std::make_shared<Model>();
-	groundlPtr->transform().setTranslation({ 0 , -7, 0 });
-	groundlPtr->transform().setRotation(glm::vec3(glm::radians(-90.0f), 0, 0));
-	groundlPtr->transform().setScale(7);
-	groundlPtr->useMesh(planMeshPtr->getId());
-	groundlPtr->useMaterial(materialPtr12->getId());
-	scenePtr->addModel(groundlPtr);
-	
-	for (int i = 0; i <= 4; i+=2) {
-		for (int j = 0; j <= 4; j+=2) {
-			auto modelPtr = std::make_shared<Model>();
-			modelPtr->transform().setTranslation({ -4 + 2 * j, -4 + 2 * i, ((2 * i + j) % 3 == 0) ? -2.0f : ((2 * i + j) % 3 == 1) ? 2 : 0 });
-			modelPtr->useMesh(((i * 4 + j) % 3 == 0) ? monkeyMeshPtr->getId() : (((i * 4 + j) % 3 == 1) ? appleMeshPtr->getId() : killerooMeshPtr->getId()));
-			modelPtr->useMaterial(((i + j * 4) % 3 == 0)? materialPtr2->getId() : (((i*4+j) % 3 == 1)? materialPtr3->getId() : materialPtr4->getId()));
-			modelPtr->transform().setScale(setScale / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
-			scenePtr->addModel(modelPtr);
-		}
-	}
-
-	// ---------------------------------
-	
-	// ### Light
-	auto pointLight1 = std::make_shared<LightSource>(LightType::PointLight, glm::vec3(1, 1, 1), 70);
-	pointLight1->transform().setTranslation(glm::vec3(-15, 1, 0));
-	scenePtr->addLight(pointLight1);
-
-	auto pointLight2 = std::make_shared<LightSource>(LightType::PointLight, glm::vec3(1, 1, 1), 70);
-	pointLight2->transform().setTranslation(glm::vec3(15, 1, 0));
-	scenePtr->addLight(pointLight2);
-
-	auto dirtectionalLight2 = std::make_shared<LightSource>(LightType::DirectionalLight, glm::vec3(1.0, 1.0, 1.0), 1.5f);
-	dirtectionalLight2->transform().setRotation(glm::vec3(glm::radians(45.0f), glm::radians(180.0f), glm::radians(0.0f)));
-	scenePtr->addLight(dirtectionalLight2);
-	// ---------------------------------
-	
-	// Preprocess scene (apply model transforms & calculate AABB)  // should be called in render for dynamic scenes
-	scenePtr->preprocessScene();
-	// ---------------------------------
-
-	// Camera
-	int width, height;
-	glfwGetWindowSize (windowPtr, &width, &height);
-	auto cameraPtr = std::make_shared<Camera> ();
-	cameraPtr->setAspectRatio (static_cast<float>(width) / static_cast<float>(height));
-	cameraPtr->setTranslation (center + glm::vec3 (0.0, 0.0, 5.f * setScale));
-	cameraPtr->setNear (0.1f);
-	cameraPtr->setFar (100.f * setScale);
-	scenePtr->set (cameraPtr);
-	std::cout << "meshscale " << meshScale << std::endl;
-}
-
-void initScene2() {
-	Console::print("init scene 2");
-	Console::print("Scene2 (Ray tracing should be activated) : texture(spherical uv) / surface / solid  ");
-	scenePtr = std::make_shared<Scene>();
-	scenePtr->setBackgroundColor(glm::vec3(0.1f, 0.5f, 0.95f));
-
-	// Meshes
-	auto planMeshPtr = IO::loadOFFMesh(basePath + "/Resources/Models/wall.off", scenePtr->numOfMeshes(), false);
-	scenePtr->addMesh(planMeshPtr);
-	auto rhinoMeshPtr = IO::loadOFFMesh(basePath + "/Resources/Models/rhino.off", scenePtr->numOfMeshes(), true);
-	scenePtr->addMesh(rhinoMeshPtr);
-
-	// ### Textures
-	float K_ = 1.0;
-	float a_ = 0.1;
-	float F_0_ = 0.04;
-	float omega_0_ = M_PI / 4.0;
-	float number_of_impulses_per_kernel = 56.0;
-	unsigned random_offset = std::time(0);
-	prng gen;
-	gen.seed(random_offset);
-
-
-	Texture2Dnoise isotropic_Noise(true, K_, a_ * 2, F_0_ * 3, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999));
-	Texture2Dnoise anisotropic_Noise(false, K_, a_ * 2, F_0_ * 3, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999));
-
-	std::vector<glm::vec3> colorMap = { glm::vec3(1.0 ,0.0, 1.0), glm::vec3(1.0 ,0.0, 0.0), glm::vec3(0.0 ,0.0, 1.0), glm::vec3(0.0, 1.0, 1.0), glm::vec3(1.0, 1.0, 1.0) };
-
-	// Textures generated using gabor Noise
-	Console::print("Generating textures and loading them to GPU using Gabor Noise");
-	TextureBundle anisotropicTextureBundle = scenePtr->loadTextureBundle(256, anisotropic_Noise, colorMap);
-	TextureBundle isotropicTextureBundle = scenePtr->loadTextureBundle(256, isotropic_Noise, colorMap);
-	Console::print("Textures generation ended");
-	// ---------------------------------
-
-	// ### Materials
-	TextureBundle textureBundleEmpty = { -1, -1, -1, -1 }; // used as a  control  sample
-	auto controlMaterialPtr = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(0.7, 0.7, 0.7), 0.5, 0.5, textureBundleEmpty);
-	scenePtr->addMaterial(controlMaterialPtr);
-	
-	auto isotropicTextureMaterialPtr = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.4, 0.4, isotropicTextureBundle);
-	scenePtr->addMaterial(isotropicTextureMaterialPtr);
-	auto anisotropicTextureMaterialPtr = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.4, 0.4, anisotropicTextureBundle);
-	scenePtr->addMaterial(anisotropicTextureMaterialPtr);
-
-
-	auto isotropicSurfaceMaterialPtr = std::make_shared<SurfaceNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.1, 0.1, textureBundleEmpty);
-	isotropicSurfaceMaterialPtr->setGen(std::make_shared<SetupFreeNoise>(true, K_, a_ * 1.2f, F_0_ * 4, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999)));
-	isotropicSurfaceMaterialPtr->addColor(colorMap);
-	scenePtr->addMaterial(isotropicSurfaceMaterialPtr);
-	auto anisotropicSurfaceMaterialPtr = std::make_shared<SurfaceNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.1, 0.1, textureBundleEmpty);
-	anisotropicSurfaceMaterialPtr->setGen(std::make_shared<SetupFreeNoise>(false, K_, a_ * 1.2f, F_0_ * 4, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999)));
-	anisotropicSurfaceMaterialPtr->addColor(colorMap);
-	scenePtr->addMaterial(anisotropicSurfaceMaterialPtr);
-	
-	auto isotropicSolidMaterialPtr = std::make_shared<SolidNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.1, 0.1, textureBundleEmpty);
-	isotropicSolidMaterialPtr->setGen(std::make_shared<Solid3DNoise>(true, K_, a_ * 1.2f, F_0_ * 4, glm::vec3(1.0,0.0,0.0), number_of_impulses_per_kernel * 1.2f, gen.uniform(0, 99999999)));
-	isotropicSolidMaterialPtr->addColor(colorMap);
-	scenePtr->addMaterial(isotropicSolidMaterialPtr);
-	auto anisotropicSolidMaterialPtr = std::make_shared<SolidNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.1, 0.1, textureBundleEmpty);
-	anisotropicSolidMaterialPtr->setGen(std::make_shared<Solid3DNoise>(false, K_, a_ * 1.2f, F_0_ * 4, glm::vec3(1.0, 0.0, 0.0), number_of_impulses_per_kernel * 1.2f, gen.uniform(0, 99999999)));
-	anisotropicSolidMaterialPtr->addColor(colorMap);
-	scenePtr->addMaterial(anisotropicSolidMaterialPtr);
-
-	// ---------------------------------
-
-	// ### Models
-	auto wallPtr = std::make_shared<Model>();
-	wallPtr->transform().setTranslation({ 0 , 0, -6 });
-	wallPtr->transform().setScale(6);
-	wallPtr->useMesh(planMeshPtr->getId());
-	wallPtr->useMaterial(controlMaterialPtr->getId());
-	scenePtr->addModel(wallPtr);
-
-	auto groundlPtr = std::make_shared<Model>();
-	groundlPtr->transform().setTranslation({ 0 , -6, 0 });
-	groundlPtr->transform().setRotation(glm::vec3(glm::radians(-90.0f), 0, 0));
-	groundlPtr->transform().setScale(6);
-	groundlPtr->useMesh(planMeshPtr->getId());
-	groundlPtr->useMaterial(controlMaterialPtr->getId());
-	scenePtr->addModel(groundlPtr);
-
-	// Top Row : isotropic
-	Console::print("(Top Left) :isotropic albedo noise texture resolution = 256, isotropic gabor noise ");
-	auto modelPtr = std::make_shared<Model>();
-	modelPtr->transform().setTranslation({ -3.2, 2, 0 });
-	modelPtr->transform().setRotation({ 0, M_PI / 4, 0 });
-	modelPtr->useMesh(rhinoMeshPtr->getId());
-	modelPtr->useMaterial(isotropicTextureMaterialPtr->getId());
-	modelPtr->transform().setScale(1.5f * setScale / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
-	scenePtr->addModel(modelPtr);
-
-	Console::print("(Top center) : isotropic surface noise");
-	modelPtr = std::make_shared<Model>();
-	modelPtr->transform().setTranslation({ 0, 2, 0 });
-	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
-	modelPtr->useMesh(rhinoMeshPtr->getId());
-	modelPtr->useMaterial(isotropicSurfaceMaterialPtr->getId());
-	modelPtr->transform().setScale(1.5f * setScale / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
-	scenePtr->addModel(modelPtr);
-
-	Console::print("(Top Right) : isotropic solid noise");
-	modelPtr = std::make_shared<Model>();
-	modelPtr->transform().setTranslation({ 3.2, 2, 0 });
-	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
-	modelPtr->useMesh(rhinoMeshPtr->getId());
-	modelPtr->useMaterial(isotropicSolidMaterialPtr->getId());
-	modelPtr->transform().setScale(1.5f * setScale / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
-	scenePtr->addModel(modelPtr);
-
-	// Bottom row : anistotropic
-	
-	Console::print("(Bottom Left) : anisotropic albedo noise texture resolution = 256, isotropic gabor noise ");
-	modelPtr = std::make_shared<Model>();
-	modelPtr->transform().setTranslation({ -3.2, -2, 2 });
-	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
-	modelPtr->useMesh(rhinoMeshPtr->getId());
-	modelPtr->useMaterial(anisotropicTextureMaterialPtr->getId());
-	modelPtr->transform().setScale(1.5f * setScale / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
-	scenePtr->addModel(modelPtr);
-
-	Console::print("(Bottom center) : anisotropic surface noise");
-	modelPtr = std::make_shared<Model>();
-	modelPtr->transform().setTranslation({ 0, -2, 2 });
-	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
-	modelPtr->useMesh(rhinoMeshPtr->getId());
-	modelPtr->useMaterial(anisotropicSurfaceMaterialPtr->getId());
-	modelPtr->transform().setScale(1.5f * setScale / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
-	scenePtr->addModel(modelPtr);
-
-	Console::print("(Bottom Right) : anisotropic solid noise");
-	modelPtr = std::make_shared<Model>();
-	modelPtr->transform().setTranslation({ 3.2, -2, 2 });
-	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
-	modelPtr->useMesh(rhinoMeshPtr->getId());
-	modelPtr->useMaterial(anisotropicSolidMaterialPtr->getId());
-	modelPtr->transform().setScale(1.5f * setScale / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
-	scenePtr->addModel(modelPtr);
-
-	// ---------------------------------
-
-	// ### Light
-	auto pointLight1 = std::make_shared<LightSource>(LightType::PointLight, glm::vec3(1, 1, 1), 150);
-	pointLight1->transform().setTranslation(glm::vec3(-30, 0, 0));
-	scenePtr->addLight(pointLight1);
-
-	auto pointLight2 = std::make_shared<LightSource>(LightType::PointLight, glm::vec3(1, 1, 1), 150);
-	pointLight2->transform().setTranslation(glm::vec3(30, 0, 0));
-	scenePtr->addLight(pointLight2);
-
-	auto dirtectionalLight2 = std::make_shared<LightSource>(LightType::DirectionalLight, glm::vec3(1.0, 1.0, 1.0), 1.2f);
-	dirtectionalLight2->transform().setRotation(glm::vec3(glm::radians(45.0f), glm::radians(180.0f), glm::radians(0.0f)));
-	scenePtr->addLight(dirtectionalLight2);
-
-	// Preprocess scene (apply model transforms & calculate AABB)  // should be called in render for dynamic scenes
-	scenePtr->preprocessScene();
-	// ---------------------------------
-
-	// Camera
-	int width, height;
-	glfwGetWindowSize(windowPtr, &width, &height);
-	auto cameraPtr = std::make_shared<Camera>();
-	cameraPtr->setAspectRatio(static_cast<float>(width) / static_cast<float>(height));
-	cameraPtr->setTranslation(center + glm::vec3(0.0, 0.0, 10.f * setScale));
-	cameraPtr->setNear(0.1f);
-	cameraPtr->setFar(100.f * setScale);
-	scenePtr->set(cameraPtr);
-	std::cout << "meshscale " << meshScale << std::endl;
-}
-
-void initScene3() {
-	Console::print("init scene 3");
-	Console::print("Scene3 (Ray tracing should be activated) : albedo / roughness / metalicness  ");
-	scenePtr = std::make_shared<Scene>();
-	scenePtr->setBackgroundColor(glm::vec3(0.1f, 0.5f, 0.95f));
-
-	// Meshes
-	auto planMeshPtr = IO::loadOFFMesh(basePath + "/Resources/Models/wall.off", scenePtr->numOfMeshes(), false);
-	scenePtr->addMesh(planMeshPtr);
-	auto rhinoMeshPtr = IO::loadOFFMesh(basePath + "/Resources/Models/rhino.off", scenePtr->numOfMeshes(), true);
-	scenePtr->addMesh(rhinoMeshPtr);
-
-	// ### Textures
-	float K_ = 1.0;
-	float a_ = 0.1;
-	float F_0_ = 0.04;
-	float omega_0_ = M_PI / 4.0;
-	float number_of_impulses_per_kernel = 56.0;
-	unsigned random_offset = std::time(0);
-	prng gen;
-	gen.seed(random_offset);
-
-
-	std::vector<glm::vec3> colorMap = { glm::vec3(1.0 ,0.0, 1.0), glm::vec3(1.0 ,0.0, 0.0), glm::vec3(0.0 ,0.0, 1.0), glm::vec3(0.0, 1.0, 1.0), glm::vec3(1.0, 1.0, 1.0) };
-
-	// ---------------------------------
-
-	// ### Materials
-	TextureBundle textureBundleEmpty = { -1, -1, -1, -1 }; // used as a  control  sample
-	auto controlMaterialPtr = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(0.7, 0.7, 0.7), 0.4, 0.4, textureBundleEmpty);
-	scenePtr->addMaterial(controlMaterialPtr);
-
-	auto albedo_isotropicSolidMaterialPtr = std::make_shared<SolidNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.4, 0.4, textureBundleEmpty);
-	albedo_isotropicSolidMaterialPtr->setGen(std::make_shared<Solid3DNoise>(true, K_, a_ * 1.4f, F_0_ * 5, glm::vec3(1.0, 0.0, 0.0), number_of_impulses_per_kernel * 1.2f, gen.uniform(0, 99999999)));
-	albedo_isotropicSolidMaterialPtr->addColor(colorMap);
-	albedo_isotropicSolidMaterialPtr->setmask(true,false,false);
-	scenePtr->addMaterial(albedo_isotropicSolidMaterialPtr);
-
-	auto roughness_isotropicSolidMaterialPtr = std::make_shared<SolidNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.2, 0.1, textureBundleEmpty);
-	roughness_isotropicSolidMaterialPtr->setGen(std::make_shared<Solid3DNoise>(true, K_, a_ * 1.4f, F_0_ * 5, glm::vec3(1.0, 0.0, 0.0), number_of_impulses_per_kernel * 1.2f, gen.uniform(0, 99999999)));
-	roughness_isotropicSolidMaterialPtr->addColor(colorMap);
-	roughness_isotropicSolidMaterialPtr->setmask(false, true, false);
-	scenePtr->addMaterial(roughness_isotropicSolidMaterialPtr);
-
-	auto metalic_isotropicSolidMaterialPtr = std::make_shared<SolidNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.1, 0.1, textureBundleEmpty);
-	metalic_isotropicSolidMaterialPtr->setGen(std::make_shared<Solid3DNoise>(true, K_, a_ * 1.4f, F_0_ * 5, glm::vec3(1.0, 0.0, 0.0), number_of_impulses_per_kernel * 1.2f, gen.uniform(0, 99999999)));
-	metalic_isotropicSolidMaterialPtr->addColor(colorMap);
-	metalic_isotropicSolidMaterialPtr->setmask(false, false, true);
-	scenePtr->addMaterial(metalic_isotropicSolidMaterialPtr);
-
-	// ---------------------------------
-
-	// ### Models
-	auto wallPtr = std::make_shared<Model>();
-	wallPtr->transform().setTranslation({ 0 , 0, -4 });
-	wallPtr->transform().setScale(4);
-	wallPtr->useMesh(planMeshPtr->getId());
-	wallPtr->useMaterial(controlMaterialPtr->getId());
-	scenePtr->addModel(wallPtr);
-
-	auto groundlPtr = std::make_shared<Model>();
-	groundlPtr->transform().setTranslation({ 0 , -4, 0 });
-	groundlPtr->transform().setRotation(glm::vec3(glm::radians(-90.0f), 0, 0));
-	groundlPtr->transform().setScale(4);
-	groundlPtr->useMesh(planMeshPtr->getId());
-	groundlPtr->useMaterial(controlMaterialPtr->getId());
-	scenePtr->addModel(groundlPtr);
-
-
-
-	auto modelPtr = std::make_shared<Model>();
-	modelPtr->transform().setTranslation({ -2.4, 1, 0 });
-	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
-	modelPtr->useMesh(rhinoMeshPtr->getId());
-	modelPtr->useMaterial(albedo_isotropicSolidMaterialPtr->getId());
-	modelPtr->transform().setScale(1.5f * setScale / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
-	scenePtr->addModel(modelPtr);
-
-	modelPtr = std::make_shared<Model>();
-	modelPtr->transform().setTranslation({ 0, 1, 0 });
-	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
-	modelPtr->useMesh(rhinoMeshPtr->getId());
-	modelPtr->useMaterial(roughness_isotropicSolidMaterialPtr->getId());
-	modelPtr->transform().setScale(1.5f * setScale / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
-	scenePtr->addModel(modelPtr);
-
-	modelPtr = std::make_shared<Model>();
-	modelPtr->transform().setTranslation({ 2.4, 1, 0 });
-	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
-	modelPtr->useMesh(rhinoMeshPtr->getId());
-	modelPtr->useMaterial(metalic_isotropicSolidMaterialPtr->getId());
-	modelPtr->transform().setScale(1.5f * setScale / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
-	scenePtr->addModel(modelPtr);
-
-	// ---------------------------------
-
-	// ### Light
-	auto pointLight1 = std::make_shared<LightSource>(LightType::PointLight, glm::vec3(1, 1, 1), 150);
-	pointLight1->transform().setTranslation(glm::vec3(-30, 0, 0));
-	scenePtr->addLight(pointLight1);
-
-	auto pointLight2 = std::make_shared<LightSource>(LightType::PointLight, glm::vec3(1, 1, 1), 150);
-	pointLight2->transform().setTranslation(glm::vec3(30, 0, 0));
-	scenePtr->addLight(pointLight2);
-
-	auto dirtectionalLight2 = std::make_shared<LightSource>(LightType::DirectionalLight, glm::vec3(1.0, 1.0, 1.0), 1.2f);
-	dirtectionalLight2->transform().setRotation(glm::vec3(glm::radians(45.0f), glm::radians(180.0f), glm::radians(0.0f)));
-	scenePtr->addLight(dirtectionalLight2);
-
-	// Preprocess scene (apply model transforms & calculate AABB)  // should be called in render for dynamic scenes
-	scenePtr->preprocessScene();
-	// ---------------------------------
-
-	// Camera
-	int width, height;
-	glfwGetWindowSize(windowPtr, &width, &height);
-	auto cameraPtr = std::make_shared<Camera>();
-	cameraPtr->setAspectRatio(static_cast<float>(width) / static_cast<float>(height));
-	cameraPtr->setTranslation(center + glm::vec3(0.0, 0.0, 10.f * setScale));
-	cameraPtr->setNear(0.1f);
-	cameraPtr->setFar(100.f * setScale);
-	scenePtr->set(cameraPtr);
-	std::cout << "meshscale " << meshScale << std::endl;
-}
-
 void init (int scene) {
 	initGLFW (); // Windowing system
 	if (!gladLoadGLLoader ((GLADloadproc)glfwGetProcAddress)) // Load extensions for modern OpenGL
 		exitOnCriticalError ("[Failed to initialize OpenGL context]");
-	if (scene == 0)
-		initScene1();
-	else if (scene == 1)
-		initScene2();
-	else if (scene == 2)
-		initScene3();
+	int width, height;
+	glfwGetWindowSize (windowPtr, &width, &height);
+	Scenes::Settings settings = { basePath, meshFilename, static_cast<float>(width) / static_cast<float>(height), static_cast<unsigned int>(std::time (0)) };
+	scenePtr = Scenes::build (scene, settings);
 	rasterizerPtr = make_shared<Rasterizer>();
 	rasterizerPtr->init (basePath, scenePtr); // Mut be called before creating the scene, to generate an OpenGL context and allow mesh VBOs
 	rayTracerPtr = make_shared<RayTracer>();
 	rayTracerPtr->init (scenePtr);
+	// Leaves a core to the interactive loop while rendering in the background
+	rayTracerPtr->setNumOfThreads (std::max (1, static_cast<int> (std::thread::hardware_concurrency ()) - 1));
+	rayTracerPtr->setGBufferEnabled (true);
+	renderJobPtr = make_shared<RenderJob> (rayTracerPtr);
+	renderJobPtr->setProgressive (true);
 }
 
 void clear () {
+	renderJobPtr.reset (); // cancels the render in flight
 	glfwDestroyWindow (windowPtr);
 	glfwTerminate ();
 }
@@ -686,8 +370,16 @@ void clear () {
 
 // The main rendering call
 void render () {
+	bool isViewportFrame = isDisplayRaytracing && updateRayTracedViewport ();
 	if (isDisplayRaytracing)
+		renderJobPtr->updateImage ();
+	// The heatmap is replaced at the end of a render
+	if (isDisplayRaytracing && isDisplayCost && !renderJobPtr->isRunning () && rayTracerPtr->costHeatmap ())
+		rasterizerPtr->display (rayTracerPtr->costHeatmap ());
+	else if (isViewportFrame || isDisplayRelit)
 		rasterizerPtr->display (rayTracerPtr->image ());
+	else if (isDisplayRaytracing)
+		rasterizerPtr->display (renderJobPtr->image ());
 	else
 		rasterizerPtr->render (scenePtr);
 }
@@ -709,6 +401,9 @@ void update (float currentTime) {
 		fpsTime = currentTime;
 	}
 	std::string titleWithFPS = BASE_WINDOW_TITLE + " - " + std::to_string (FPS) + "FPS";
+	if (renderJobPtr->isRunning ())
+		titleWithFPS += " - ray tracing " + std::to_string (static_cast<int> (100.f * renderJobPtr->progress ())) + "%"
+						+ (renderJobPtr->samplesPerPixel () ? " (" + std::to_string (renderJobPtr->samplesPerPixel ()) + " spp)" : "");
 	glfwSetWindowTitle (windowPtr, titleWithFPS.c_str ());
 	lastTime = currentTime;
 	frameCount++;
@@ -732,6 +427,7 @@ int main (int argc, char ** argv) {
 	parseCommandLine (argc, argv);
 	init (current_scene);
 	while (!glfwWindowShouldClose (windowPtr)) {
+		PROFILE_SCOPE ("frame");
 		update (static_cast<float> (glfwGetTime ()));
 		render ();
 		glfwSwapBuffers (windowPtr);
@@ -741,6 +437,7 @@ int main (int argc, char ** argv) {
 			current_scene = (current_scene + 1) % 3;
 			init(current_scene);
 			swap_scene = false;
+			isViewChanged = true;
 		}
 	}
 	clear ();
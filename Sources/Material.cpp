@@ -27,4 +27,14 @@ float& Material::roughness(const glm::vec3& pos, const glm::vec3& normal) {
 }
 float& Material::metallicness(const glm::vec3& pos, const glm::vec3& normal) {
 	return m_metallicness;
+}
+
+glm::vec3 Material::albedo(const glm::vec3& /*pos*/, const glm::vec3& /*normal*/, const glm::mat3& /*footprint*/) const {
+	return m_albedo;
+}
+float Material::roughness(const glm::vec3& /*pos*/, const glm::vec3& /*normal*/, const glm::mat3& /*footprint*/) const {
+	return m_roughness;
+}
+float Material::metallicness(const glm::vec3& /*pos*/, const glm::vec3& /*normal*/, const glm::mat3& /*footprint*/) const {
+	return m_metallicness;
 }
\ No newline at end of file
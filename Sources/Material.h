@@ -8,6 +8,14 @@
 
 #include "Texture.h"
 
+/// Material parameters evaluated at a surface point.
+struct MaterialSample {
+	glm::vec3 albedo;
+	float roughness;
+	float metallicness;
+	float ambientOcclusion;
+};
+
 class Material
 {
 public:
@@ -19,6 +27,10 @@ public:
 	virtual glm::vec3& albedo(const glm::vec3& pos, const glm::vec3& normal);
 	virtual float& roughness(const glm::vec3& pos, const glm::vec3& normal);
 	virtual float& metallicness(const glm::vec3& pos, const glm::vec3& normal);
+	/// Evaluation without side effects, band-limited to the pixel footprint (covariance in the space of 'pos', null for a point sample).
+	virtual glm::vec3 albedo(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const;
+	virtual float roughness(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const;
+	virtual float metallicness(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const;
 	inline const int& getId() const { return m_id; }
 	inline const TextureBundle& getTextureBundle() const { return m_textureBundle; }
 	inline const bool hasAlbedoTexture() const { return m_textureBundle.m_albedoTexId != -1; }
@@ -54,4 +54,174 @@ inline glm::vec3 BRDF (glm::vec3 L, glm::vec3 V, glm::vec3 N,  glm::vec3 albedo,
 	glm::vec3 fs = F * D * G / (4.0f);
 
 	return (fd + fs);
-}
\ No newline at end of file
+}
+// <---- Batched evaluation ---->
+
+/// Shading samples of a BRDF batch, the width of an AVX2 register.
+static const int BRDF_BATCH_SIZE = 8;
+
+/// Bound of the error of BRDFBatch against BRDF, relative to the scalar value, on every channel of every sample. It comes
+/// from the polynomial exp2 of the Fresnel term, the other operations being those of BRDF in the same order.
+static const float BRDF_BATCH_TOLERANCE = 1e-6f;
+
+/// Inputs of BRDFBatch as a structure of arrays: component c of vector v of sample i is v[c][i]. L, V and N are
+/// normalized, as for BRDF.
+struct alignas(32) BRDFSamples {
+	float L[3][BRDF_BATCH_SIZE];
+	float V[3][BRDF_BATCH_SIZE];
+	float N[3][BRDF_BATCH_SIZE];
+	float albedo[3][BRDF_BATCH_SIZE];
+	float roughness[BRDF_BATCH_SIZE];
+	float metallic[BRDF_BATCH_SIZE];
+};
+
+#if defined(__AVX2__)
+#include <immintrin.h>
+#elif defined(__SSE2__) || defined(_M_X64)
+#include <emmintrin.h>
+#endif
+
+/// Vector lanes of the instruction set the renderer is built for (see the RENDERER_AVX2 option).
+namespace BRDFLanes {
+
+#if defined(__AVX2__)
+
+static const char * const INSTRUCTION_SET = "AVX2";
+static const int WIDTH = 8;
+typedef __m256 Float;
+typedef __m256i Int;
+inline Float load (const float * p) { return _mm256_loadu_ps (p); }
+inline void store (float * p, Float x) { _mm256_storeu_ps (p, x); }
+inline Float set (float x) { return _mm256_set1_ps (x); }
+inline Float add (Float a, Float b) { return _mm256_add_ps (a, b); }
+inline Float sub (Float a, Float b) { return _mm256_sub_ps (a, b); }
+inline Float mul (Float a, Float b) { return _mm256_mul_ps (a, b); }
+inline Float div (Float a, Float b) { return _mm256_div_ps (a, b); }
+inline Float max (Float a, Float b) { return _mm256_max_ps (a, b); }
+inline Float min (Float a, Float b) { return _mm256_min_ps (a, b); }
+inline Float sqrt (Float x) { return _mm256_sqrt_ps (x); }
+inline Float greaterEqual (Float a, Float b) { return _mm256_cmp_ps (a, b, _CMP_GE_OQ); }
+inline Float lessEqual (Float a, Float b) { return _mm256_cmp_ps (a, b, _CMP_LE_OQ); }
+/// a where the mask is set, b elsewhere.
+inline Float select (Float mask, Float a, Float b) { return _mm256_blendv_ps (b, a, mask); }
+inline Int toInt (Float x) { return _mm256_cvtps_epi32 (x); }
+inline Float toFloat (Int x) { return _mm256_cvtepi32_ps (x); }
+/// 2^n, for n in [-126, 127].
+inline Float pow2 (Int n) { return _mm256_castsi256_ps (_mm256_slli_epi32 (_mm256_add_epi32 (n, _mm256_set1_epi32 (127)), 23)); }
+
+#elif defined(__SSE2__) || defined(_M_X64)
+
+static const char * const INSTRUCTION_SET = "SSE2";
+static const int WIDTH = 4;
+typedef __m128 Float;
+typedef __m128i Int;
+inline Float load (const float * p) { return _mm_loadu_ps (p); }
+inline void store (float * p, Float x) { _mm_storeu_ps (p, x); }
+inline Float set (float x) { return _mm_set1_ps (x); }
+inline Float add (Float a, Float b) { return _mm_add_ps (a, b); }
+inline Float sub (Float a, Float b) { return _mm_sub_ps (a, b); }
+inline Float mul (Float a, Float b) { return _mm_mul_ps (a, b); }
+inline Float div (Float a, Float b) { return _mm_div_ps (a, b); }
+inline Float max (Float a, Float b) { return _mm_max_ps (a, b); }
+inline Float min (Float a, Float b) { return _mm_min_ps (a, b); }
+inline Float sqrt (Float x) { return _mm_sqrt_ps (x); }
+inline Float greaterEqual (Float a, Float b) { return _mm_cmpge_ps (a, b); }
+inline Float lessEqual (Float a, Float b) { return _mm_cmple_ps (a, b); }
+inline Float select (Float mask, Float a, Float b) { return _mm_or_ps (_mm_and_ps (mask, a), _mm_andnot_ps (mask, b)); }
+inline Int toInt (Float x) { return _mm_cvtps_epi32 (x); }
+inline Float toFloat (Int x) { return _mm_cvtepi32_ps (x); }
+inline Float pow2 (Int n) { return _mm_castsi128_ps (_mm_slli_epi32 (_mm_add_epi32 (n, _mm_set1_epi32 (127)), 23)); }
+
+#else
+
+static const char * const INSTRUCTION_SET = "scalar";
+
+#endif
+
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+
+/// 2^x = 2^n 2^f, n being x rounded to the nearest integer and |f| <= 1/2: 2^f = e^(f ln 2) by its Taylor series to
+/// degree 6, of relative error below 2e-7.
+inline Float exp2 (Float x) {
+	x = min (max (x, set (-126.f)), set (127.f));
+	Int n = toInt (x);
+	Float t = mul (sub (x, toFloat (n)), set (0.69314718f));
+	Float p = set (1.f / 720.f);
+	p = add (set (1.f / 120.f), mul (t, p));
+	p = add (set (1.f / 24.f), mul (t, p));
+	p = add (set (1.f / 6.f), mul (t, p));
+	p = add (set (0.5f), mul (t, p));
+	p = add (set (1.f), mul (t, p));
+	p = add (set (1.f), mul (t, p));
+	return mul (p, pow2 (n));
+}
+
+/// BRDF of the samples [first, first + WIDTH), with the operations of BRDF in the same order.
+inline void evaluate (const BRDFSamples & samples, float result[3][BRDF_BATCH_SIZE], int first) {
+	Float L[3], V[3], N[3], albedo[3];
+	for (int c = 0; c < 3; c++) {
+		L[c] = load (&samples.L[c][first]);
+		V[c] = load (&samples.V[c][first]);
+		N[c] = load (&samples.N[c][first]);
+		albedo[c] = load (&samples.albedo[c][first]);
+	}
+	Float roughness = load (&samples.roughness[first]);
+	Float metallic = load (&samples.metallic[first]);
+	auto dot = [] (const Float * a, const Float * b) { return add (add (mul (a[0], b[0]), mul (a[1], b[1])), mul (a[2], b[2])); };
+	const Float zero = set (0.f);
+	const Float one = set (1.f);
+
+	Float NdotL = max (zero, dot (N, L));
+	Float NdotV = max (zero, dot (N, V));
+
+	Float H[3] = { add (L[0], V[0]), add (L[1], V[1]), add (L[2], V[2]) };
+	Float inverseLength = div (one, sqrt (dot (H, H)));
+	for (int c = 0; c < 3; c++)
+		H[c] = mul (H[c], inverseLength);
+	Float NdotH = max (zero, dot (N, H));
+	Float VdotH = max (zero, dot (V, H));
+
+	// GGX
+	Float alpha = mul (roughness, roughness);
+	Float tmp = div (alpha, max (set (1e-8f), add (mul (mul (NdotH, NdotH), sub (mul (alpha, alpha), one)), one)));
+	Float D = select (greaterEqual (roughness, one), set (glm::one_over_pi<float> ()), mul (mul (tmp, tmp), set (glm::one_over_pi<float> ())));
+
+	// Schlick Fresnel, geometry
+	Float sphg = exp2 (mul (sub (mul (set (-5.55473f), VdotH), set (6.98316f)), VdotH));
+	Float k = mul (mul (roughness, roughness), set (0.5f));
+	Float G = mul (div (one, add (mul (NdotL, sub (one, k)), k)), div (one, add (mul (NdotV, sub (one, k)), k)));
+
+	Float belowHorizon = lessEqual (NdotL, zero);
+	Float oneMinusMetallic = sub (one, metallic);
+	for (int c = 0; c < 3; c++) {
+		Float diffuseColor = mul (albedo[c], oneMinusMetallic);
+		Float specularColor = add (set (0.08f), mul (metallic, sub (albedo[c], set (0.08f))));
+		Float F = add (specularColor, mul (sub (one, specularColor), sphg));
+		Float fd = div (mul (diffuseColor, sub (one, specularColor)), set (glm::pi<float> ()));
+		Float fs = div (mul (mul (F, D), G), set (4.f));
+		store (&result[c][first], select (belowHorizon, zero, add (fd, fs)));
+	}
+}
+
+#endif
+
+}
+
+/// BRDF of the BRDF_BATCH_SIZE samples, result[c][i] being channel c of sample i: the vectorized counterpart of BRDF for
+/// batched shading, on the lanes of BRDFLanes, within BRDF_BATCH_TOLERANCE of it.
+inline void BRDFBatch (const BRDFSamples & samples, float result[3][BRDF_BATCH_SIZE]) {
+#if defined(__AVX2__) || defined(__SSE2__) || defined(_M_X64)
+	for (int first = 0; first < BRDF_BATCH_SIZE; first += BRDFLanes::WIDTH)
+		BRDFLanes::evaluate (samples, result, first);
+#else
+	for (int i = 0; i < BRDF_BATCH_SIZE; i++) {
+		glm::vec3 value = BRDF (glm::vec3 (samples.L[0][i], samples.L[1][i], samples.L[2][i]),
+								glm::vec3 (samples.V[0][i], samples.V[1][i], samples.V[2][i]),
+								glm::vec3 (samples.N[0][i], samples.N[1][i], samples.N[2][i]),
+								glm::vec3 (samples.albedo[0][i], samples.albedo[1][i], samples.albedo[2][i]),
+								samples.roughness[i], samples.metallic[i]);
+		for (int c = 0; c < 3; c++)
+			result[c][i] = value[c];
+	}
+#endif
+}
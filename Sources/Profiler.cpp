@@ -0,0 +1,115 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#include "Profiler.h"
+
+#include <algorithm>
+#include <chrono>
+#include <fstream>
+#include <memory>
+#include <mutex>
+#include <vector>
+
+namespace {
+
+struct Event {
+	const char * name;
+	int64_t start;
+	int64_t end;
+	int64_t arg;
+};
+
+/// Events of one thread, only written by it. Kept alive by the registry after the thread ends.
+struct ThreadBuffer {
+	int threadIndex;
+	std::vector<Event> events;
+	size_t numOfEvents = 0; // total since the last start, the buffer holding the last RING_BUFFER_SIZE ones
+};
+
+std::mutex registryMutex;
+std::vector<std::shared_ptr<ThreadBuffer>> registry;
+
+ThreadBuffer & threadBuffer () {
+	thread_local std::shared_ptr<ThreadBuffer> buffer;
+	if (!buffer) {
+		buffer = std::make_shared<ThreadBuffer> ();
+		buffer->events.resize (Profiler::RING_BUFFER_SIZE);
+		std::lock_guard<std::mutex> lock (registryMutex);
+		buffer->threadIndex = static_cast<int> (registry.size ());
+		registry.push_back (buffer);
+	}
+	return *buffer;
+}
+
+const std::chrono::steady_clock::time_point epoch = std::chrono::steady_clock::now ();
+
+void writeEscaped (std::ostream & out, const char * text) {
+	for (const char * c = text; *c; c++) {
+		if (*c == '"' || *c == '\\')
+			out << '\\';
+		out << *c;
+	}
+}
+
+}
+
+std::atomic<bool> Profiler::sm_recording (false);
+
+void Profiler::start () {
+	{
+		std::lock_guard<std::mutex> lock (registryMutex);
+		for (auto & buffer : registry)
+			buffer->numOfEvents = 0;
+	}
+	sm_recording.store (true);
+}
+
+void Profiler::stop () {
+	sm_recording.store (false);
+}
+
+int64_t Profiler::now () {
+	return std::chrono::duration_cast<std::chrono::nanoseconds> (std::chrono::steady_clock::now () - epoch).count ();
+}
+
+void Profiler::record (const char * name, int64_t start, int64_t end, int64_t arg) {
+	ThreadBuffer & buffer = threadBuffer ();
+	buffer.events[buffer.numOfEvents % RING_BUFFER_SIZE] = { name, start, end, arg };
+	buffer.numOfEvents++;
+}
+
+bool Profiler::saveChromeTrace (const std::string & filename) {
+	std::ofstream out (filename.c_str ());
+	if (!out)
+		return false;
+	std::lock_guard<std::mutex> lock (registryMutex);
+	out << "{\"displayTimeUnit\":\"ms\",\"traceEvents\":[\n";
+	bool first = true;
+	for (const auto & buffer : registry) {
+		if (!buffer->numOfEvents)
+			continue;
+		out << (first ? "" : ",\n") << "{\"name\":\"thread_name\",\"ph\":\"M\",\"pid\":0,\"tid\":" << buffer->threadIndex
+			<< ",\"args\":{\"name\":\"thread " << buffer->threadIndex << "\"}}";
+		first = false;
+		size_t numOfKept = std::min (buffer->numOfEvents, RING_BUFFER_SIZE);
+		for (size_t i = buffer->numOfEvents - numOfKept; i < buffer->numOfEvents; i++) {
+			const Event & event = buffer->events[i % RING_BUFFER_SIZE];
+			// Timestamps in microseconds
+			out << ",\n{\"name\":\"";
+			writeEscaped (out, event.name);
+			out << "\",\"ph\":\"X\",\"pid\":0,\"tid\":" << buffer->threadIndex
+				<< ",\"ts\":" << event.start / 1000 << "." << (event.start % 1000) / 100
+				<< ",\"dur\":" << (event.end - event.start) / 1000 << "." << ((event.end - event.start) % 1000) / 100;
+			if (event.arg != NO_ARG)
+				out << ",\"args\":{\"value\":" << event.arg << "}";
+			out << "}";
+		}
+	}
+	out << "\n]}\n";
+	return static_cast<bool> (out);
+}
@@ -0,0 +1,72 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#pragma once
+
+#include <atomic>
+#include <string>
+#include <cstdint>
+
+/// Scoped timers recorded in per-thread ring buffers, exported in the Chrome trace event format (chrome://tracing,
+/// Perfetto). Recording is off by default: a scope then costs a single relaxed atomic load.
+///
+///     PROFILE_SCOPE ("Scene::preprocessScene");
+///     PROFILE_SCOPE_ARG ("render tile", tileIndex);
+///
+/// Scope names must be string literals (or outlive the capture).
+class Profiler {
+public:
+	/// Events kept per thread, the oldest ones being overwritten.
+	static constexpr size_t RING_BUFFER_SIZE = 1 << 16;
+
+	/// Argument of the events recorded without one.
+	static constexpr int64_t NO_ARG = INT64_MIN;
+
+	/// Clears the buffers and starts recording.
+	static void start ();
+
+	/// Stops recording. The scopes still open are not recorded.
+	static void stop ();
+
+	static inline bool isRecording () { return sm_recording.load (std::memory_order_relaxed); }
+
+	/// Writes the recorded events as Chrome trace JSON. Call it while no thread records, e.g. after stop ().
+	static bool saveChromeTrace (const std::string & filename);
+
+	/// Nanoseconds since the first use of the profiler.
+	static int64_t now ();
+
+	/// Adds a complete event to the buffer of the calling thread.
+	static void record (const char * name, int64_t start, int64_t end, int64_t arg);
+
+	class Scope {
+	public:
+		inline Scope (const char * name, int64_t arg = NO_ARG) : m_name (isRecording () ? name : nullptr), m_arg (arg) {
+			if (m_name)
+				m_start = now ();
+		}
+
+		inline ~Scope () {
+			if (m_name && isRecording ())
+				record (m_name, m_start, now (), m_arg);
+		}
+
+	private:
+		const char * m_name;
+		int64_t m_arg;
+		int64_t m_start = 0;
+	};
+
+private:
+	static std::atomic<bool> sm_recording;
+};
+
+#define PROFILE_CONCATENATE_(a, b) a##b
+#define PROFILE_CONCATENATE(a, b) PROFILE_CONCATENATE_(a, b)
+#define PROFILE_SCOPE(name) Profiler::Scope PROFILE_CONCATENATE(profileScope, __LINE__) (name)
+#define PROFILE_SCOPE_ARG(name, arg) Profiler::Scope PROFILE_CONCATENATE(profileScope, __LINE__) (name, static_cast<int64_t> (arg))
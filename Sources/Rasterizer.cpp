@@ -7,6 +7,11 @@
 // All rights reserved.
 // ----------------------------------------------
 #include "Rasterizer.h"
+#include "Profiler.h"
+#include "Console.h"
+
+#include <algorithm>
+#include <numeric>
 
 void Rasterizer::init (const std::string & basePath, const std::shared_ptr<Scene> scenePtr) {
 	glEnable (GL_DEBUG_OUTPUT); // Modern error callback functionnality
@@ -52,6 +57,7 @@ void Rasterizer::loadShaderProgram (const std::string & basePath) {
 }
 
 void Rasterizer::updateDisplayedImageTexture (std::shared_ptr<Image> imagePtr) {
+	PROFILE_SCOPE ("GL upload: displayed image");
 	glBindTexture (GL_TEXTURE_2D, m_displayImageTex);
    	// Uploading the image data to GPU memory
 	glTexImage2D (
@@ -84,19 +90,19 @@ void Rasterizer::initDisplayedImage () {
 void Rasterizer::bindTextures(const std::shared_ptr<Scene> scenePtr, const TextureBundle& textureBundle) {
 	if (textureBundle.m_albedoTexId != -1){
 		glActiveTexture(GL_TEXTURE0);
-		glBindTexture(GL_TEXTURE_2D, scenePtr->texture(textureBundle.m_albedoTexId)->getContextId());
+		glBindTexture(GL_TEXTURE_2D, textureContextId(scenePtr, textureBundle.m_albedoTexId));
 	}
 	if (textureBundle.m_roughnessTexId != -1) {
 		glActiveTexture(GL_TEXTURE0 + 1);
-		glBindTexture(GL_TEXTURE_2D, scenePtr->texture(textureBundle.m_roughnessTexId)->getContextId());
+		glBindTexture(GL_TEXTURE_2D, textureContextId(scenePtr, textureBundle.m_roughnessTexId));
 	}
 	if (textureBundle.m_metallicTexId != -1) {
 		glActiveTexture(GL_TEXTURE0 + 2);
-		glBindTexture(GL_TEXTURE_2D, scenePtr->texture(textureBundle.m_metallicTexId)->getContextId());
+		glBindTexture(GL_TEXTURE_2D, textureContextId(scenePtr, textureBundle.m_metallicTexId));
 	}
 	if (textureBundle.m_ambientOcclusionTexId != -1) {
 		glActiveTexture(GL_TEXTURE0 + 3);
-		glBindTexture(GL_TEXTURE_2D, scenePtr->texture(textureBundle.m_ambientOcclusionTexId)->getContextId());
+		glBindTexture(GL_TEXTURE_2D, textureContextId(scenePtr, textureBundle.m_ambientOcclusionTexId));
 	}
 }
 
@@ -107,10 +113,24 @@ void Rasterizer::render (std::shared_ptr<Scene> scenePtr) {
 	glm::mat4 projectionMatrix = scenePtr->camera()->computeProjectionMatrix();
 	m_pbrShaderProgramPtr->set("projectionMat", projectionMatrix); // Compute the projection matrix of the camera and pass it to the GPU program
 	glm::mat4 viewMatrix = scenePtr->camera()->computeViewMatrix();	
-	size_t numOfLights = scenePtr->numOfLights();
-	m_pbrShaderProgramPtr->set("numOfLights", (int)numOfLights);
-	for (size_t lightId = 0; lightId < numOfLights; lightId++) {
-		m_pbrShaderProgramPtr->set(scenePtr->light(lightId), viewMatrix, lightId);
+	std::vector<size_t> lightIds (scenePtr->numOfLights ());
+	std::iota (lightIds.begin (), lightIds.end (), 0);
+	if (lightIds.size () > MAX_NUM_OF_LIGHTS) {
+		static Console::RateLimiter limiter (10.0);
+		Console::log (Console::Severity::Warning, "Rasterizer: drawing the " + std::to_string (MAX_NUM_OF_LIGHTS) + " most powerful of "
+			+ std::to_string (lightIds.size ()) + " lights", &limiter);
+		auto power = [&] (size_t lightId) {
+			const LightSource & light = *scenePtr->light (lightId);
+			return light.intensity () * glm::dot (light.color (), glm::vec3 (1.f));
+		};
+		std::partial_sort (lightIds.begin (), lightIds.begin () + MAX_NUM_OF_LIGHTS, lightIds.end (), [&] (size_t a, size_t b) {
+			return power (a) > power (b);
+		});
+		lightIds.resize (MAX_NUM_OF_LIGHTS);
+	}
+	m_pbrShaderProgramPtr->set("numOfLights", (int)lightIds.size ());
+	for (size_t i = 0; i < lightIds.size (); i++) {
+		m_pbrShaderProgramPtr->set(scenePtr->light(lightIds[i]), viewMatrix, (int)i);
 	}
 	size_t numOfModels = scenePtr->numOfModels ();
 	for (size_t modelId = 0; modelId < numOfModels; modelId++) {
@@ -151,6 +171,12 @@ void Rasterizer::clear () {
 		glDeleteVertexArrays (1, &vao);
 	}
 	m_vaos.clear ();
+	for (unsigned int i = 0; i < m_textures.size (); i++) {
+		GLuint tex = m_textures[i];
+		if (tex != 0)
+			glDeleteTextures (1, &tex);
+	}
+	m_textures.clear ();
 }
 
 GLuint Rasterizer::genGPUBuffer (size_t elementSize, size_t numElements, const void * data) {
@@ -185,6 +211,7 @@ GLuint Rasterizer::genGPUVertexArray (GLuint posVbo, GLuint ibo, bool hasNormals
 }
 
 GLuint Rasterizer::toGPU (std::shared_ptr<Mesh> meshPtr) {
+	PROFILE_SCOPE ("GL upload: mesh");
 	GLuint posVbo = genGPUBuffer (3 * sizeof (float), meshPtr->vertexPositions().size(), meshPtr->vertexPositions().data ()); // Position GPU vertex buffer
 	GLuint normalVbo = genGPUBuffer (3 * sizeof (float), meshPtr->vertexNormals().size(), meshPtr->vertexNormals().data ()); // Normal GPU vertex buffer
 	GLuint textCoordVbo = genGPUBuffer (2 * sizeof (float), meshPtr->vertexTexCoords().size(), meshPtr->vertexTexCoords().data ()); // Normal GPU vertex buffer
@@ -193,6 +220,40 @@ GLuint Rasterizer::toGPU (std::shared_ptr<Mesh> meshPtr) {
 	return vao;
 }
 
+GLuint Rasterizer::toGPU (std::shared_ptr<Texture> texturePtr) {
+	PROFILE_SCOPE ("GL upload: texture");
+	GLuint texID;
+	glGenTextures (1, &texID);
+	glBindTexture (GL_TEXTURE_2D, texID);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
+	glTexParameteri (GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
+	// Uploading the decoded CPU mip pyramid, single channel maps being fetched as (r, 0, 0)
+	for (int level = 0; level < texturePtr->numOfLevels (); level++) {
+		std::vector<glm::vec3> texels = texturePtr->texels (level);
+		glTexImage2D (GL_TEXTURE_2D,
+			level,
+			GL_RGB16F,
+			texturePtr->level (level).width,
+			texturePtr->level (level).height,
+			0,
+			GL_RGB,
+			GL_FLOAT,
+			texels.data ());
+	}
+	glBindTexture (GL_TEXTURE_2D, 0);
+	return texID;
+}
+
+GLuint Rasterizer::textureContextId (const std::shared_ptr<Scene> scenePtr, int textureId) {
+	if (m_textures.size () < scenePtr->numOfTextures ())
+		m_textures.resize (scenePtr->numOfTextures (), 0);
+	if (m_textures[textureId] == 0)
+		m_textures[textureId] = toGPU (scenePtr->texture (textureId));
+	return m_textures[textureId];
+}
+
 void Rasterizer::initScreeQuad () {
 	std::vector<float> pData = {-1.0, -1.0, 0.0, 1.0, -1.0, 0.0, 1.0, 1.0, 0.0, -1.0, 1.0, 0.0};
 	std::vector<unsigned int> iData = {0, 1, 2, 0, 2, 3};
@@ -21,6 +21,8 @@
 
 class Rasterizer {
 public:
+	/// Size of the light array of the PBR fragment shader. The most powerful lights are drawn beyond it.
+	static const size_t MAX_NUM_OF_LIGHTS = 50;
 
 	inline Rasterizer () {}
 
@@ -42,6 +44,9 @@ private:
 	GLuint genGPUBuffer (size_t elementSize, size_t numElements, const void * data);
 	GLuint genGPUVertexArray (GLuint posVbo, GLuint ibo, bool hasNormals, GLuint normalVbo, bool hasTextCoords, GLuint textCoordVbo);
 	GLuint toGPU (std::shared_ptr<Mesh> meshPtr);
+	GLuint toGPU (std::shared_ptr<Texture> texturePtr);
+	/// GPU copy of a scene texture, uploaded on first use.
+	GLuint textureContextId (const std::shared_ptr<Scene> scenePtr, int textureId);
 	void initScreeQuad ();
 	void draw (size_t meshId, size_t triangleCount);
 
@@ -52,4 +57,5 @@ private:
 	GLuint m_screenQuadVao;  // Full-screen quad drawn when displaying an image (no scene rasterization) 
 
 	std::vector<GLuint> m_vaos;
+	std::vector<GLuint> m_textures; // 0 until uploaded
 };
\ No newline at end of file
@@ -7,6 +7,7 @@
 // All rights reserved.
 // ----------------------------------------------
 #include "Ray.h"
+#include "RenderStats.h"
 
 using namespace std;
 
@@ -80,13 +81,16 @@ std::shared_ptr<RayHit> Ray::intersectBVH(const std::vector<Triangle>& triangles
 	const BoundingBox& box = bvh->root();
 	float a, b;
 
+	RenderStats::count(RenderStats::BoxTests);
 	if (!boxIntersect(box, a, b))
 		return nullptr;
+	RenderStats::count(RenderStats::NodesVisited);
 
 	if (bvh->left() == nullptr && bvh->right() == nullptr)
 	{
 		int trIndex = box.triangleIndex();
 		const Triangle triangle = triangles[trIndex];
+		RenderStats::count(RenderStats::TriangleTests);
 		std::shared_ptr<RayHit> hit = triangleIntersect(triangle.p0, triangle.p1, triangle.p2);
 		if (hit) {
 			hit->setTriangleData(trIndex);
@@ -111,4 +115,60 @@ std::shared_ptr<RayHit> Ray::intersectBVH(const std::vector<Triangle>& triangles
 
 	return (distLeft < distRight) ? hitLeft : hitRight;
 
-}
\ No newline at end of file
+}
+
+std::shared_ptr<RayHit> Ray::intersectTriangles(const std::vector<Triangle>& triangles) const {
+	std::shared_ptr<RayHit> nearestRayHit = nullptr;
+	RenderStats::count(RenderStats::TriangleTests, triangles.size());
+	for (int triangleIndex = 0; triangleIndex < triangles.size(); triangleIndex++) {
+		const Triangle& triangle = triangles[triangleIndex];
+		std::shared_ptr<RayHit> currentHit = triangleIntersect(triangle.p0, triangle.p1, triangle.p2);
+
+		if (currentHit) {
+			if (!nearestRayHit || currentHit->distance() < nearestRayHit->distance()) {
+				nearestRayHit = currentHit;
+				nearestRayHit->setTriangleData(triangleIndex);
+			}
+		}
+	}
+	return nearestRayHit;
+}
+
+SurfaceDifferentials Ray::surfaceDifferentials(const Triangle& triangle, const RayHit& hit) const {
+	SurfaceDifferentials result;
+	if (!m_hasDifferentials)
+		return result;
+
+	const glm::vec3 e0 = triangle.p1 - triangle.p0;
+	const glm::vec3 e1 = triangle.p2 - triangle.p0;
+	const glm::vec3 n = cross(e0, e1);
+	const glm::vec2& b = hit.uv_coord();
+	const glm::vec3 p = (1 - b.x - b.y) * triangle.p0 + b.x * triangle.p1 + b.y * triangle.p2;
+
+	// Offset rays are intersected with the plane of the triangle
+	float rxDotN = dot(m_differentials.rxDirection, n);
+	float ryDotN = dot(m_differentials.ryDirection, n);
+	if (abs(rxDotN) < 0.00000001f || abs(ryDotN) < 0.00000001f)
+		return result;
+	float tx = dot(p - m_differentials.rxOrigin, n) / rxDotN;
+	float ty = dot(p - m_differentials.ryOrigin, n) / ryDotN;
+	result.dpdx = m_differentials.rxOrigin + tx * m_differentials.rxDirection - p;
+	result.dpdy = m_differentials.ryOrigin + ty * m_differentials.ryDirection - p;
+
+	// Barycentric derivatives, least squares solution of [e0 e1] db = dp
+	float e00 = dot(e0, e0), e01 = dot(e0, e1), e11 = dot(e1, e1);
+	float det = e00 * e11 - e01 * e01;
+	if (abs(det) < 0.00000001f)
+		return result;
+	const glm::vec2 duv0 = triangle.uv1 - triangle.uv0;
+	const glm::vec2 duv1 = triangle.uv2 - triangle.uv0;
+	auto uvDerivative = [&](const glm::vec3& dp) {
+		float r0 = dot(e0, dp), r1 = dot(e1, dp);
+		float db0 = (e11 * r0 - e01 * r1) / det;
+		float db1 = (e00 * r1 - e01 * r0) / det;
+		return db0 * duv0 + db1 * duv1;
+	};
+	result.duvdx = uvDerivative(result.dpdx);
+	result.duvdy = uvDerivative(result.dpdy);
+	return result;
+}
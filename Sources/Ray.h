@@ -39,14 +39,36 @@ private:
 	int m_triangleIndex;
 };
 
+/// Auxiliary rays shot through the next pixel along x and along y, used to estimate the pixel footprint at the hit point.
+struct RayDifferential {
+	glm::vec3 rxOrigin;
+	glm::vec3 rxDirection;
+	glm::vec3 ryOrigin;
+	glm::vec3 ryDirection;
+};
+
+/// Change of the hit position and texture coordinates from one pixel to the next (null if the ray carries no differentials).
+struct SurfaceDifferentials {
+	glm::vec3 dpdx = glm::vec3(0.f);
+	glm::vec3 dpdy = glm::vec3(0.f);
+	glm::vec2 duvdx = glm::vec2(0.f);
+	glm::vec2 duvdy = glm::vec2(0.f);
+
+	/// Covariance of the pixel footprint on the surface, assuming a box pixel filter.
+	inline glm::mat3 footprint() const { return (glm::outerProduct(dpdx, dpdx) + glm::outerProduct(dpdy, dpdy)) / 12.f; }
+};
+
 class Ray {
 public:
 
 	Ray(const glm::vec3& origin, const glm::vec3& direction)
-		:m_origin(origin), m_direction(direction) {};
+		:m_origin(origin), m_direction(direction), m_hasDifferentials(false), m_differentials() {};
 	virtual ~Ray() {};
 	inline const glm::vec3& origin() const { return m_origin; }
 	inline const glm::vec3& direction() const { return m_direction; }
+	inline bool hasDifferentials() const { return m_hasDifferentials; }
+	inline const RayDifferential& differentials() const { return m_differentials; }
+	inline void setDifferentials(const RayDifferential& differentials) { m_differentials = differentials; m_hasDifferentials = true; }
 	
 	std::shared_ptr<RayHit> triangleIntersect(const glm::vec3& p0,
 		const glm::vec3& p1,
@@ -56,7 +78,15 @@ public:
 	
 	std::shared_ptr<RayHit> intersectBVH(const std::vector<Triangle>& triangles, const std::shared_ptr<BVH>& bvh) const;
 
+	/// Nearest hit by testing every triangle, the reference of the accelerated traversals (the first one wins ties).
+	std::shared_ptr<RayHit> intersectTriangles(const std::vector<Triangle>& triangles) const;
+
+	/// Propagates the differentials to the hit point on 'triangle', at barycentric coordinates 'hit.uv_coord()'.
+	SurfaceDifferentials surfaceDifferentials(const Triangle& triangle, const RayHit& hit) const;
+
 private:
 	glm::vec3 m_origin;
 	glm::vec3 m_direction;
+	bool m_hasDifferentials;
+	RayDifferential m_differentials;
 };
\ No newline at end of file
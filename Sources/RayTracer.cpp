@@ -10,10 +10,80 @@
 
 #include "RayTracer.h"
 
+#include <omp.h>
+#include <cstring>
+
+#include "Profiler.h"
+#if defined(_MSC_VER)
+#include <intrin.h>
+#elif defined(__x86_64__) || defined(__i386__)
+#include <x86intrin.h>
+#endif
+
+static const int TILE_SIZE = 16;
+
+/// Rays traced by the current thread, primary and shadow ones.
+static thread_local size_t t_numOfRays = 0;
+
+/// Camera samples rendered by the current thread.
+static thread_local size_t t_numOfSamples = 0;
+
+/// Adaptive sampling stops refining a pixel once the standard error of its luminance is below the threshold times
+/// its mean luminance, the mean being clamped to this value in the dark.
+static const float MIN_ADAPTIVE_LUMINANCE = 0.05f;
+
+/// A reprojected hit is rejected if a neighbor hit lies off its tangent plane by more than this fraction of its depth,
+/// or if their normals differ by more than the angle of this cosine.
+static const float REPROJECTION_DEPTH_TOLERANCE = 0.01f;
+static const float REPROJECTION_NORMAL_TOLERANCE = 0.9f;
+/// Neighbors of a reprojected hit which may have received no hit.
+static const int MAX_REPROJECTION_HOLES = 2;
+
+/// Hash of the bits of a position, e.g. to draw random numbers per shading point.
+static inline uint32_t pointKey(const glm::vec3& position) {
+	uint32_t bits[3];
+	std::memcpy(bits, &position, sizeof(bits));
+	return Sampler::hash(bits[0] ^ Sampler::hash(bits[1] ^ Sampler::hash(bits[2])));
+}
+
+static inline float luminance(const glm::vec3& color) {
+	return glm::dot(color, glm::vec3(0.2126f, 0.7152f, 0.0722f));
+}
+
+/// Time stamp counter, in cycles where available.
+static inline uint64_t cycleCount() {
+#if defined(_MSC_VER) || defined(__x86_64__) || defined(__i386__)
+	return __rdtsc();
+#else
+	return std::chrono::duration_cast<std::chrono::nanoseconds>(std::chrono::steady_clock::now().time_since_epoch()).count();
+#endif
+}
+
+/// Current value of the counter of a cost metric, for the calling thread.
+static inline uint64_t costCounter(CostMetric metric) {
+	switch (metric) {
+	case CostMetric::Time:
+		return cycleCount();
+	case CostMetric::Samples:
+		return t_numOfSamples;
+#ifdef RENDERER_STATS
+	case CostMetric::NodesVisited:
+		return RenderStats::t_statistics[RenderStats::NodesVisited];
+	case CostMetric::NoiseImpulses:
+		return RenderStats::t_statistics[RenderStats::NoiseImpulses];
+#endif
+	default:
+		return 0;
+	}
+}
+
 // ### Textures
 
 RayTracer::RayTracer() :
-	m_imagePtr(std::make_shared<Image>()), BVHisActive(true) {
+	m_imagePtr(std::make_shared<Image>()), BVHisActive(true), m_useRayDifferentials(true), m_textureFilter(TextureFilter::Trilinear),
+	m_samplesPerPixel(1), m_maxSamplesPerPixel(1), m_adaptiveThreshold(0.02f), m_numOfThreads(0), m_seed(0), m_sampler(SamplerType::Sobol, 0), m_isVerbose(true), m_numOfRays(0), m_numOfSamples(0),
+	m_costMetric(CostMetric::None), m_isGBufferEnabled(false),
+	m_reprojectionMode(ReprojectionMode::Off), m_numOfReprojectedPixels(0), m_lightCutoff(0.f), m_numOfLightSamples(0), m_cancellationRequested(false), m_numOfCompletedTiles(0), m_numOfTiles(0) {
 	float K_ = 1.0;
 	float a_ = 0.1;
 	float F_0_ = 0.0625;
@@ -23,174 +93,567 @@ RayTracer::RayTracer() :
 
 RayTracer::~RayTracer() {}
 
-void RayTracer::init(const std::shared_ptr<Scene> scenePtr) {
+void RayTracer::init(const std::shared_ptr<Scene>& scenePtr) {
 }
 
-void RayTracer::render(const std::shared_ptr<Scene> scenePtr) {
-	size_t width = m_imagePtr->width();
-	size_t height = m_imagePtr->height();
+bool RayTracer::render(const std::shared_ptr<Scene>& scenePtr) {
+	PROFILE_SCOPE("RayTracer::render");
+	int width = static_cast<int>(m_imagePtr->width());
+	int height = static_cast<int>(m_imagePtr->height());
+	int numOfThreads = m_numOfThreads > 0 ? m_numOfThreads : omp_get_max_threads();
 	std::chrono::high_resolution_clock clock;
-	Console::print("Start ray tracing at " + std::to_string(width) + "x" + std::to_string(height) + " resolution...");
-	BVHisActive ? Console::print("BVH is active") : Console::print("BVH is not active");
+	if (m_isVerbose) {
+		Console::print("Start ray tracing at " + std::to_string(width) + "x" + std::to_string(height) + " resolution, "
+			+ std::to_string(m_samplesPerPixel) + " spp, " + std::to_string(numOfThreads) + " threads...");
+		BVHisActive ? Console::print("BVH is active") : Console::print("BVH is not active");
+		m_useRayDifferentials ? Console::print("Ray differentials are active") : Console::print("Ray differentials are not active");
+	}
 	std::chrono::time_point<std::chrono::high_resolution_clock> before = clock.now();
 	m_imagePtr->clear(scenePtr->backgroundColor());
+	bool recordsCost = m_costMetric != CostMetric::None;
+	if (recordsCost)
+		m_costImagePtr = std::make_shared<Image>(width, height);
+	if ((m_costMetric == CostMetric::NodesVisited || m_costMetric == CostMetric::NoiseImpulses) && !RenderStats::ENABLED)
+		Console::log(Console::Severity::Warning, "Counting the nodes visited or the noise impulses per pixel requires a build with RENDERER_STATS");
+	GBuffer previousGBuffer;
+	std::vector<int> reprojectedHits;
+	if (m_reprojectionMode != ReprojectionMode::Off && m_gBuffer.isValid && m_samplesPerPixel == 1 && !adaptiveSamplingIsActive()) {
+		previousGBuffer = std::move(m_gBuffer);
+		reprojectedHits = reproject(previousGBuffer, scenePtr);
+	}
+	m_numOfReprojectedPixels = std::count_if(reprojectedHits.begin(), reprojectedHits.end(), [](int hit) { return hit >= 0; });
+	beginGBuffer(scenePtr, adaptiveSamplingIsActive() ? 0 : m_samplesPerPixel);
+
+	bool completed = renderTiles(scenePtr, [&](int xMin, int yMin, int xMax, int yMax, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera) {
+		glm::vec3 eye = glm::vec3(frameMatrix[3]);
+		for (int y = yMin; y < yMax; y++)
+			for (int x = xMin; x < xMax; x++) {
+				uint64_t costBefore = costCounter(m_costMetric);
+				int hit = reprojectedHits.empty() ? -1 : reprojectedHits[size_t(y) * width + x];
+				m_imagePtr->operator()(x, y) = hit >= 0 ?
+					renderReprojectedPixel(scenePtr, x, y, previousGBuffer.points[hit], eye) :
+					renderPixel(scenePtr, x, y, frameMatrix, camera);
+				if (recordsCost)
+					m_costImagePtr->operator()(x, y) = glm::vec3(static_cast<float>(costCounter(m_costMetric) - costBefore));
+			}
+	});
+
+	std::chrono::time_point<std::chrono::high_resolution_clock> after = clock.now();
+	double elapsedTime = (double)std::chrono::duration_cast<std::chrono::milliseconds>(after - before).count();
+	m_gBuffer.isValid = m_gBuffer.isRecording && completed;
+	m_gBuffer.isRecording = false;
+	if (!completed) {
+		if (m_isVerbose)
+			Console::print("Ray tracing cancelled after " + std::to_string(elapsedTime) + "ms, " + std::to_string(m_numOfCompletedTiles)
+			+ " of " + std::to_string(m_numOfTiles) + " tiles rendered");
+		return false;
+	}
+	if (m_isVerbose && !reprojectedHits.empty())
+		Console::print("Ray tracing executed in " + std::to_string(elapsedTime) + "ms, "
+			+ std::to_string(100.0 * m_numOfReprojectedPixels / (double(width) * height)) + "% of the pixels reprojected");
+	else if (m_isVerbose && adaptiveSamplingIsActive())
+		Console::print("Ray tracing executed in " + std::to_string(elapsedTime) + "ms, "
+			+ std::to_string(double(m_numOfSamples) / (double(width) * height)) + " samples per pixel on average");
+	else if (m_isVerbose)
+		Console::print("Ray tracing executed in " + std::to_string(elapsedTime) + "ms");
+	if (RenderStats::ENABLED && m_isVerbose)
+		Console::print(m_statistics.report());
+	if (recordsCost)
+		updateCostHeatmap();
+	return true;
+}
+
+bool RayTracer::renderPass(const std::shared_ptr<Scene>& scenePtr, int pass) {
+	PROFILE_SCOPE_ARG("RayTracer::renderPass", pass);
+	int width = static_cast<int>(m_imagePtr->width());
+	int height = static_cast<int>(m_imagePtr->height());
+	if (pass == 0) {
+		m_accumulatedImagePtr = std::make_shared<Image>(width, height);
+		beginGBuffer(scenePtr, 1);
+	}
+	glm::vec2 pixelDifferential(1.f / width, -1.f / height);
+	bool completed = renderTiles(scenePtr, [&](int xMin, int yMin, int xMax, int yMax, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera) {
+		if (pass >= NUM_OF_COARSE_PASSES) {
+			// One more jittered sample in the running average
+			int sample = pass - NUM_OF_COARSE_PASSES + 1;
+			for (int y = yMin; y < yMax; y++)
+				for (int x = xMin; x < xMax; x++) {
+					glm::vec2 offset = m_sampler.get2D(x, y, sample);
+					glm::vec3& sum = m_accumulatedImagePtr->operator()(x, y);
+					sum += renderSample(scenePtr, x, y, offset, pixelDifferential, frameMatrix, camera);
+					m_imagePtr->operator()(x, y) = sum / float(sample + 1);
+				}
+			return;
+		}
+		// Pixel centers on a grid of spacing 8, 4, 2 then 1, each filling its block until a finer pass splits it.
+		// The pixels of the coarser grids are already rendered.
+		int stride = 1 << (NUM_OF_COARSE_PASSES - 1 - pass);
+		for (int y = yMin; y < yMax; y += stride)
+			for (int x = xMin; x < xMax; x += stride) {
+				if (pass > 0 && x % (2 * stride) == 0 && y % (2 * stride) == 0)
+					continue;
+				glm::vec3 color = renderSample(scenePtr, x, y, glm::vec2(0.5f), pixelDifferential, frameMatrix, camera, gBufferPoint(x, y, 0));
+				m_accumulatedImagePtr->operator()(x, y) = color;
+				for (int blockY = y; blockY < std::min(y + stride, yMax); blockY++)
+					for (int blockX = x; blockX < std::min(x + stride, xMax); blockX++)
+						m_imagePtr->operator()(blockX, blockY) = color;
+			}
+	});
+	// The G-buffer holds the pixel centers, complete with the last coarse pass
+	if (pass == NUM_OF_COARSE_PASSES - 1) {
+		m_gBuffer.isValid = m_gBuffer.isRecording && completed;
+		m_gBuffer.isRecording = false;
+	} else if (!completed)
+		m_gBuffer.isRecording = false;
+	return completed;
+}
+
+bool RayTracer::canRelight(const std::shared_ptr<Scene>& scenePtr) const {
+	std::shared_ptr<Camera> camera = scenePtr->camera();
+	return m_gBuffer.isValid
+		&& m_gBuffer.width == static_cast<int>(m_imagePtr->width()) && m_gBuffer.height == static_cast<int>(m_imagePtr->height())
+		&& m_gBuffer.frameMatrix == inverse(camera->computeViewMatrix())
+		&& m_gBuffer.fov == camera->getFoV() && m_gBuffer.aspectRatio == camera->getAspectRatio();
+}
+
+bool RayTracer::relight(const std::shared_ptr<Scene>& scenePtr, bool materialsChanged) {
+	PROFILE_SCOPE("RayTracer::relight");
+	if (!canRelight(scenePtr))
+		return false;
+	std::chrono::high_resolution_clock clock;
+	std::chrono::time_point<std::chrono::high_resolution_clock> before = clock.now();
+	int samplesPerPixel = m_gBuffer.samplesPerPixel;
+	bool completed = renderTiles(scenePtr, [&](int xMin, int yMin, int xMax, int yMax, const glm::mat4&, const std::shared_ptr<Camera>&) {
+		for (int y = yMin; y < yMax; y++)
+			for (int x = xMin; x < xMax; x++) {
+				SurfacePoint* point = &m_gBuffer.points[(size_t(y) * m_gBuffer.width + x) * samplesPerPixel];
+				glm::vec3 color(0.f);
+				for (int sample = 0; sample < samplesPerPixel; sample++, point++) {
+					if (materialsChanged)
+						point->isMaterialSampled = false;
+					if (point->triangleIndex >= 0) {
+						point->radiance = shade(scenePtr, *point);
+						color += point->radiance;
+					} else
+						color += scenePtr->backgroundColor();
+				}
+				m_imagePtr->operator()(x, y) = color / float(samplesPerPixel);
+			}
+	});
+	if (m_isVerbose && completed)
+		Console::print("Relighting executed in " + std::to_string((double)std::chrono::duration_cast<std::chrono::milliseconds>(clock.now() - before).count())
+			+ "ms, " + std::to_string(samplesPerPixel) + " spp");
+	return completed;
+}
+
+std::vector<int> RayTracer::reproject(const GBuffer& previous, const std::shared_ptr<Scene>& scenePtr) const {
+	PROFILE_SCOPE("RayTracer::reproject");
+	int width = static_cast<int>(m_imagePtr->width());
+	int height = static_cast<int>(m_imagePtr->height());
+	std::shared_ptr<Camera> camera = scenePtr->camera();
+	glm::mat4 frameMatrix = inverse(camera->computeViewMatrix());
+	glm::vec3 eye = glm::vec3(frameMatrix[3]);
+	glm::vec3 viewRight = normalize(glm::vec3(frameMatrix[0]));
+	glm::vec3 viewUp = normalize(glm::vec3(frameMatrix[1]));
+	glm::vec3 viewDir = -normalize(glm::vec3(frameMatrix[2]));
+	float w = 2.0 * float(tan(glm::radians(camera->getFoV() / 2.0)));
+
+	// Forward reprojection: each hit lands on the pixel nearest to its projection, the nearest hit winning (inverse of
+	// rayDirectionAt)
+	std::vector<int> landedHits(size_t(width) * height, -1);
+	std::vector<float> depths(landedHits.size(), std::numeric_limits<float>::max());
+	for (size_t i = 0; i < previous.points.size(); i++) {
+		const SurfacePoint& point = previous.points[i];
+		// Retraced after MAX_REPROJECTION_AGE / 2 to MAX_REPROJECTION_AGE renders, spread over the renders
+		int maxAge = MAX_REPROJECTION_AGE / 2 + static_cast<int>(Sampler::hash(uint32_t(i)) % uint32_t(MAX_REPROJECTION_AGE / 2 + 1));
+		if (point.triangleIndex < 0 || point.age >= maxAge)
+			continue;
+		glm::vec3 toPoint = point.position - eye;
+		float depth = dot(toPoint, viewDir);
+		if (depth <= 0.f || dot(point.normal, toPoint) >= 0.f)
+			continue;
+		int x = static_cast<int>(std::floor((dot(toPoint, viewRight) / (depth * camera->getAspectRatio() * w) + 0.5f) * width));
+		int y = static_cast<int>(std::floor((dot(toPoint, viewUp) / (depth * w) + 0.5f) * height));
+		if (x < 0 || x >= width || y < 0 || y >= height)
+			continue;
+		size_t pixel = size_t(y) * width + x;
+		if (depth < depths[pixel]) {
+			depths[pixel] = depth;
+			landedHits[pixel] = static_cast<int>(i);
+		}
+	}
+
+	// Confidence: the 3x3 neighborhood must be covered by hits on the same smooth surface. Depth or normal discontinuities
+	// mark silhouettes, and holes disocclusions, where a hit from behind could show through (ghosting). Isolated holes,
+	// left by the forward reprojection itself, are tolerated.
+	std::vector<int> hits(landedHits.size(), -1);
+	#pragma omp parallel for num_threads(m_numOfThreads > 0 ? m_numOfThreads : omp_get_max_threads())
+	for (int y = 1; y < height - 1; y++)
+		for (int x = 1; x < width - 1; x++) {
+			int hit = landedHits[size_t(y) * width + x];
+			if (hit < 0)
+				continue;
+			const SurfacePoint& point = previous.points[hit];
+			float tolerance = REPROJECTION_DEPTH_TOLERANCE * depths[size_t(y) * width + x];
+			bool isConsistent = true;
+			int numOfHoles = 0;
+			for (int dy = -1; dy <= 1 && isConsistent; dy++)
+				for (int dx = -1; dx <= 1 && isConsistent; dx++) {
+					int neighborHit = landedHits[size_t(y + dy) * width + x + dx];
+					if (neighborHit < 0) {
+						isConsistent = ++numOfHoles <= MAX_REPROJECTION_HOLES;
+						continue;
+					}
+					const SurfacePoint& neighbor = previous.points[neighborHit];
+					isConsistent = std::abs(dot(neighbor.position - point.position, point.normal)) <= tolerance
+						&& dot(neighbor.normal, point.normal) >= REPROJECTION_NORMAL_TOLERANCE;
+				}
+			if (isConsistent)
+				hits[size_t(y) * width + x] = hit;
+		}
+	return hits;
+}
+
+glm::vec3 RayTracer::renderReprojectedPixel(const std::shared_ptr<Scene>& scenePtr, int x, int y, const SurfacePoint& previousPoint, const glm::vec3& eye) {
+	SurfacePoint& point = *gBufferPoint(x, y, 0);
+	point = previousPoint;
+	point.age++;
+	point.wo = glm::normalize(eye - point.position);
+	if (m_reprojectionMode == ReprojectionMode::Shading)
+		point.radiance = shade(scenePtr, point);
+	return point.radiance;
+}
+
+void RayTracer::beginGBuffer(const std::shared_ptr<Scene>& scenePtr, int samplesPerPixel) {
+	m_gBuffer.isValid = false;
+	m_gBuffer.isRecording = (m_isGBufferEnabled || m_reprojectionMode != ReprojectionMode::Off) && samplesPerPixel > 0;
+	if (!m_gBuffer.isRecording)
+		return;
+	std::shared_ptr<Camera> camera = scenePtr->camera();
+	m_gBuffer.width = static_cast<int>(m_imagePtr->width());
+	m_gBuffer.height = static_cast<int>(m_imagePtr->height());
+	m_gBuffer.samplesPerPixel = samplesPerPixel;
+	m_gBuffer.frameMatrix = inverse(camera->computeViewMatrix());
+	m_gBuffer.fov = camera->getFoV();
+	m_gBuffer.aspectRatio = camera->getAspectRatio();
+	m_gBuffer.points.assign(size_t(m_gBuffer.width) * m_gBuffer.height * samplesPerPixel, SurfacePoint());
+}
+
+template <typename TileFunction>
+bool RayTracer::renderTiles(const std::shared_ptr<Scene>& scenePtr, const TileFunction& renderTile) {
+	int width = static_cast<int>(m_imagePtr->width());
+	int height = static_cast<int>(m_imagePtr->height());
+	int numOfThreads = m_numOfThreads > 0 ? m_numOfThreads : omp_get_max_threads();
 
 	// <----  Preprocess scene ---->
 	std::shared_ptr<Camera> camera = scenePtr->camera();
+	// Rebuilt for each render, as the lights may change in between (e.g. before relighting). Sampling ignores the cutoff:
+	// lights culled by range would never be selected, biasing the estimate.
+	if (m_lightCutoff > 0.f || m_numOfLightSamples > 0) {
+		PROFILE_SCOPE("light BVH build");
+		m_lightBVHPtr = std::make_shared<LightBVH>(scenePtr->lights(), m_numOfLightSamples > 0 ? 0.f : m_lightCutoff);
+	} else
+		m_lightBVHPtr = nullptr;
+	{
+		PROFILE_SCOPE("scene snapshot");
+		m_snapshot = RenderSnapshot(*scenePtr, [&](const LightSource& light) { return lightRadiance(light, light.center()); });
+	}
 	glm::mat4 frameMatrix = inverse(camera->computeViewMatrix());
 
 	// <---- Ray tracing code ---->
-	for (int x = 0; x < width; x++) {
-		for (int y = 0; y < height; y++) {
-			float x_clip = (static_cast<float>(x) / (width - 1)) * 2 - 1.0f;
-			float y_clip = (static_cast<float>(y) / (height - 1)) * 2 - 1.0f;
+	int numOfTilesX = (width + TILE_SIZE - 1) / TILE_SIZE;
+	int numOfTiles = numOfTilesX * ((height + TILE_SIZE - 1) / TILE_SIZE);
+	size_t numOfRays = 0;
+	size_t numOfSamples = 0;
+	m_statistics.clear();
+	m_numOfCompletedTiles = 0;
+	m_numOfTiles = numOfTiles;
+	#pragma omp parallel num_threads(numOfThreads) reduction(+:numOfRays, numOfSamples)
+	{
+		size_t firstRay = t_numOfRays;
+		size_t firstSample = t_numOfSamples;
+#ifdef RENDERER_STATS
+		RenderStats::t_statistics.clear();
+#endif
+		#pragma omp for schedule(dynamic, 1)
+		for (int tile = 0; tile < numOfTiles; tile++) {
+			// No way out of an OpenMP loop: the remaining tiles are skipped
+			if (cancellationRequested())
+				continue;
+			PROFILE_SCOPE_ARG("render tile", tile);
+			int xMin = (tile % numOfTilesX) * TILE_SIZE;
+			int yMin = (tile / numOfTilesX) * TILE_SIZE;
+			int xMax = std::min(xMin + TILE_SIZE, width);
+			int yMax = std::min(yMin + TILE_SIZE, height);
+			renderTile(xMin, yMin, xMax, yMax, frameMatrix, camera);
+			m_numOfCompletedTiles.fetch_add(1, std::memory_order_relaxed);
+			if (m_tileCallback)
+				m_tileCallback(xMin, yMin, xMax, yMax);
+		}
+		numOfRays += t_numOfRays - firstRay;
+		numOfSamples += t_numOfSamples - firstSample;
+#ifdef RENDERER_STATS
+		// Once per thread
+		#pragma omp critical
+		m_statistics.merge(RenderStats::t_statistics);
+#endif
+	}
+	m_numOfRays = numOfRays;
+	m_numOfSamples = numOfSamples;
+	return m_numOfCompletedTiles == numOfTiles;
+}
 
-			shared_ptr<Ray> ray = rayAt((float(x) + 0.5) / width, 1.f - (float(y) + 0.5) / height, frameMatrix, camera);
+void RayTracer::updateCostHeatmap() {
+	PROFILE_SCOPE("RayTracer::updateCostHeatmap");
+	static const std::vector<glm::vec3> heatColors = { glm::vec3(0.f), glm::vec3(0.1f, 0.1f, 0.8f), glm::vec3(0.9f, 0.1f, 0.3f),
+		glm::vec3(1.f, 0.9f, 0.1f), glm::vec3(1.f) };
+	// Normalized by a high percentile rather than the maximum, which a single interrupted pixel can set
+	std::vector<float> costs(m_costImagePtr->pixels().size());
+	for (size_t i = 0; i < costs.size(); i++)
+		costs[i] = (*m_costImagePtr)[i].x;
+	size_t percentile = costs.size() * 99 / 100;
+	std::nth_element(costs.begin(), costs.begin() + percentile, costs.end());
+	float scale = costs[percentile] > 0.f ? 1.f / costs[percentile] : 0.f;
+	m_costHeatmapPtr = std::make_shared<Image>(m_costImagePtr->width(), m_costImagePtr->height());
+	for (size_t i = 0; i < costs.size(); i++)
+		(*m_costHeatmapPtr)[i] = colorMapLookup(std::min(1.f, (*m_costImagePtr)[i].x * scale), heatColors);
+	if (m_isVerbose)
+		Console::print("Cost heatmap normalized to " + std::to_string(costs[percentile]) + " per pixel (99th percentile)");
+}
 
-			shared_ptr<RayHit> rayHit = rayScene(ray, scenePtr);
+glm::vec3 RayTracer::renderPixel(const std::shared_ptr<Scene>& scenePtr, int x, int y, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera) {
+	float width = static_cast<float>(m_imagePtr->width());
+	float height = static_cast<float>(m_imagePtr->height());
+	if (adaptiveSamplingIsActive())
+		return renderAdaptivePixel(scenePtr, x, y, frameMatrix, camera);
+	// Differentials spanning the area of a sample
+	float footprint = 1.f / std::sqrt(float(m_samplesPerPixel));
+	glm::vec2 differential(footprint / width, -footprint / height);
+	glm::vec3 color(0.f);
+	for (int sample = 0; sample < m_samplesPerPixel; sample++) {
+		glm::vec2 offset = m_samplesPerPixel > 1 ? m_sampler.get2D(x, y, sample) : glm::vec2(0.5f);
+		color += renderSample(scenePtr, x, y, offset, differential, frameMatrix, camera, gBufferPoint(x, y, sample));
+	}
+	return color / float(m_samplesPerPixel);
+}
 
-			if (rayHit != nullptr) {
-				m_imagePtr->operator()(x, y) = shade(scenePtr, rayHit, ray);
-			}
-			else {
-				m_imagePtr->operator()(x, y) = scenePtr->backgroundColor();
-			}
+glm::vec3 RayTracer::renderAdaptivePixel(const std::shared_ptr<Scene>& scenePtr, int x, int y, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera) {
+	float width = static_cast<float>(m_imagePtr->width());
+	float height = static_cast<float>(m_imagePtr->height());
+	int batchSize = std::max(2, m_samplesPerPixel);
+	// Differentials spanning the area of a sample of the first batch
+	float footprint = 1.f / std::sqrt(float(batchSize));
+	glm::vec2 differential(footprint / width, -footprint / height);
+	glm::vec3 color(0.f);
+	// Running mean and sum of squared deviations of the sample luminances (Welford)
+	float mean = 0.f;
+	float squaredDeviations = 0.f;
+	int numOfSamples = 0;
+	while (numOfSamples < m_maxSamplesPerPixel) {
+		glm::vec3 sample = renderSample(scenePtr, x, y, m_sampler.get2D(x, y, numOfSamples), differential, frameMatrix, camera);
+		color += sample;
+		numOfSamples++;
+		float delta = luminance(sample) - mean;
+		mean += delta / numOfSamples;
+		squaredDeviations += delta * (luminance(sample) - mean);
+		// Refined by whole batches, so that the variance estimate is never based on a couple of samples only
+		if (numOfSamples % batchSize == 0) {
+			float standardError = std::sqrt(squaredDeviations / (float(numOfSamples - 1) * numOfSamples));
+			if (standardError <= m_adaptiveThreshold * std::max(mean, MIN_ADAPTIVE_LUMINANCE))
+				break;
 		}
 	}
+	return color / float(numOfSamples);
+}
 
-	std::chrono::time_point<std::chrono::high_resolution_clock> after = clock.now();
-	double elapsedTime = (double)std::chrono::duration_cast<std::chrono::milliseconds>(after - before).count();
-	Console::print("Ray tracing executed in " + std::to_string(elapsedTime) + "ms");
-
+glm::vec3 RayTracer::renderSample(const std::shared_ptr<Scene>& scenePtr, int x, int y, const glm::vec2& offset, const glm::vec2& differential, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera, SurfacePoint* gBufferPoint) {
+	float width = static_cast<float>(m_imagePtr->width());
+	float height = static_cast<float>(m_imagePtr->height());
+	t_numOfSamples++;
+	shared_ptr<Ray> ray = m_useRayDifferentials ?
+		rayAt((x + offset.x) / width, 1.f - (y + offset.y) / height, differential.x, differential.y, frameMatrix, camera) :
+		rayAt((x + offset.x) / width, 1.f - (y + offset.y) / height, frameMatrix, camera);
+
+	shared_ptr<RayHit> rayHit = rayScene(ray, scenePtr);
+
+	if (rayHit == nullptr)
+		return scenePtr->backgroundColor();
+	if (gBufferPoint == nullptr)
+		return shade(scenePtr, rayHit, ray);
+	*gBufferPoint = surfacePoint(scenePtr, *rayHit, *ray);
+	gBufferPoint->radiance = shade(scenePtr, *gBufferPoint);
+	return gBufferPoint->radiance;
 }
 
-std::shared_ptr<Ray> RayTracer::rayAt(float x, float y, const glm::mat4& frameMatrix, const std::shared_ptr<Camera> camera) {
+glm::vec3 RayTracer::rayDirectionAt(float x, float y, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera) const {
 	glm::vec3 viewRight = normalize(glm::vec3(frameMatrix[0]));
 	glm::vec3 viewUp = normalize(glm::vec3(frameMatrix[1]));
 	glm::vec3 viewDir = -normalize(glm::vec3(frameMatrix[2]));
-	glm::vec3 eye = glm::vec3(frameMatrix[3]);
 	float w = 2.0 * float(tan(glm::radians(camera->getFoV() / 2.0)));
-	glm::vec3 rayDir = glm::normalize(viewDir + ((x - 0.5f) * camera->getAspectRatio() * w) * viewRight + ((1.f - y) - 0.5f) * w * viewUp);
-	return std::make_shared<Ray>(eye, rayDir);
+	return glm::normalize(viewDir + ((x - 0.5f) * camera->getAspectRatio() * w) * viewRight + ((1.f - y) - 0.5f) * w * viewUp);
 }
 
-std::shared_ptr<RayHit> RayTracer::rayScene(const std::shared_ptr<Ray>& ray, const std::shared_ptr<Scene> scenePtr) {
-	std::shared_ptr<RayHit> nearestRayHit = nullptr;
-
-	if (!BVHisActive) {
-		for (int triangleIndex = 0; triangleIndex < scenePtr->numOfTriangles(); triangleIndex++) {
-			const Triangle& triangle = scenePtr->triangle(triangleIndex);
-			std::shared_ptr<RayHit> currentHit = ray->triangleIntersect(triangle.p0, triangle.p1, triangle.p2);
+std::shared_ptr<Ray> RayTracer::rayAt(float x, float y, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera) {
+	glm::vec3 eye = glm::vec3(frameMatrix[3]);
+	return std::make_shared<Ray>(eye, rayDirectionAt(x, y, frameMatrix, camera));
+}
 
-			if (currentHit) {
-				if (!nearestRayHit || (nearestRayHit && currentHit->distance() < nearestRayHit->distance())) {
-					nearestRayHit = currentHit;
-					nearestRayHit->setTriangleData(triangleIndex);
-				}
-			}
-		}
-		return nearestRayHit;
-	}
+std::shared_ptr<Ray> RayTracer::rayAt(float x, float y, float dx, float dy, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera) {
+	std::shared_ptr<Ray> ray = rayAt(x, y, frameMatrix, camera);
+	RayDifferential differentials;
+	differentials.rxOrigin = ray->origin();
+	differentials.rxDirection = rayDirectionAt(x + dx, y, frameMatrix, camera);
+	differentials.ryOrigin = ray->origin();
+	differentials.ryDirection = rayDirectionAt(x, y + dy, frameMatrix, camera);
+	ray->setDifferentials(differentials);
+	return ray;
+}
 
-	return ray->intersectBVH(scenePtr->triangles(), scenePtr->sceneBVH());
+std::shared_ptr<RayHit> RayTracer::rayScene(const std::shared_ptr<Ray>& ray, const std::shared_ptr<Scene>& scenePtr) {
+	t_numOfRays++;
+#ifdef RENDERER_STATS
+	RenderStats::Statistics& statistics = RenderStats::t_statistics;
+	size_t firstNode = statistics[RenderStats::NodesVisited];
+	size_t firstTriangleTest = statistics[RenderStats::TriangleTests];
+#endif
+
+	std::shared_ptr<RayHit> hit = BVHisActive ?
+		ray->intersectBVH(scenePtr->triangles(), scenePtr->sceneBVH()) :
+		ray->intersectTriangles(scenePtr->triangles());
+
+#ifdef RENDERER_STATS
+	statistics.numOfRays++;
+	statistics.nodesPerRay.add(statistics[RenderStats::NodesVisited] - firstNode);
+	statistics.triangleTestsPerRay.add(statistics[RenderStats::TriangleTests] - firstTriangleTest);
+#endif
+	return hit;
 }
 
-glm::vec3 RayTracer::lightRadiance(const std::shared_ptr<LightSource>& lightPtr, const glm::vec3& position) const {
-	return lightPtr->color() * lightPtr->intensity() * glm::pi<float>();
+glm::vec3 RayTracer::lightRadiance(const LightSource& light, const glm::vec3& position) const {
+	return light.color() * light.intensity() * glm::pi<float>();
 }
 
-glm::vec3 RayTracer::materialReflectance(const std::shared_ptr<Scene> scenePtr,
-	const std::shared_ptr<Material> materialPtr,
+glm::vec3 RayTracer::materialReflectance(const MaterialSample& sample,
 	const glm::vec3& wi,
 	const glm::vec3& wo,
-	const glm::vec2& fTextCoord,
 	const glm::vec3& n) const {
+	return sample.ambientOcclusion * BRDF(wi, wo, n, sample.albedo, sample.roughness, sample.metallicness);
+}
 
-	glm::vec3 albedo = materialPtr->hasAlbedoTexture() ?
-		scenePtr->texture(materialPtr->getTextureBundle().m_albedoTexId)->fetch(fTextCoord) :
-		materialPtr->albedo();
-
-	float roughness = materialPtr->hasRoughnessTexture() ?
-		scenePtr->texture(materialPtr->getTextureBundle().m_roughnessTexId)->fetch(fTextCoord).r :
-		roughness = materialPtr->roughness();
-
-	float metallicness = materialPtr->hasMetallicTexture() ?
-		scenePtr->texture(materialPtr->getTextureBundle().m_metallicTexId)->fetch(fTextCoord).r :
-		metallicness = materialPtr->metallicness();
-
-	float ambiantOcclusion = materialPtr->hasAmbiantOcclusionTexture() ?
-		scenePtr->texture(materialPtr->getTextureBundle().m_ambientOcclusionTexId)->fetch(fTextCoord).r :
-		ambiantOcclusion = 1;
-
-	return ambiantOcclusion * BRDF(wi, wo, n, albedo, roughness, metallicness);
+glm::vec3 RayTracer::shade(const std::shared_ptr<Scene>& scenePtr, const std::shared_ptr<RayHit>& rayHit, const std::shared_ptr<Ray>& ray) {
+	SurfacePoint point = surfacePoint(scenePtr, *rayHit, *ray);
+	return shade(scenePtr, point);
 }
 
-glm::vec3 RayTracer::shade(const std::shared_ptr<Scene> scenePtr, const std::shared_ptr<RayHit>& rayHit, const std::shared_ptr<Ray> ray) {
-	int triangleIndex = rayHit->triangleIndex();
-	const Triangle& triangle = scenePtr->triangle(triangleIndex);
+SurfacePoint RayTracer::surfacePoint(const std::shared_ptr<Scene>& scenePtr, const RayHit& rayHit, const Ray& ray) const {
+	SurfacePoint point;
+	point.triangleIndex = rayHit.triangleIndex();
+	point.barycentricCoord = rayHit.uv_coord();
+	const Triangle& triangle = scenePtr->triangle(point.triangleIndex);
+	float z = 1 - point.barycentricCoord.x - point.barycentricCoord.y;
+	point.position = z * triangle.p0 + point.barycentricCoord.x * triangle.p1 + point.barycentricCoord.y * triangle.p2;
+	point.normal = normalize(z * triangle.n0 + point.barycentricCoord.x * triangle.n1 + point.barycentricCoord.y * triangle.n2);
+	point.wo = glm::normalize(-ray.direction()); // normalize not necessary
+	// Pixel footprint on the surface, in world space
+	point.differentials = ray.surfaceDifferentials(triangle, rayHit);
+	return point;
+}
 
-	std::shared_ptr<Model> currentModel = scenePtr->model(triangle.modelIndex);
-	std::shared_ptr<Mesh> currentMesh = scenePtr->mesh(currentModel->meshId());
-	const glm::mat4& invModelMatrix = glm::inverse(currentModel->transform().computeTransformMatrix());
-	const glm::mat4& invNormalMatrix = glm::inverse(glm::transpose(invModelMatrix));
-	const glm::vec3& center = currentMesh->getCenter();
+void RayTracer::sampleMaterial(const std::shared_ptr<Scene>& scenePtr, SurfacePoint& point) const {
+	const Triangle& triangle = scenePtr->triangle(point.triangleIndex);
+	const RenderSnapshot::Model& model = m_snapshot.models[triangle.modelIndex];
+	const glm::mat4& invModelMatrix = model.invModelMatrix;
+	const glm::mat4& invNormalMatrix = model.invNormalMatrix;
 
-	const glm::vec2& barycentricCoord = rayHit->uv_coord();
+	const glm::vec2& barycentricCoord = point.barycentricCoord;
 	float z = 1 - barycentricCoord.x - barycentricCoord.y;
-	const glm::vec3 fPosition = z * triangle.p0 + barycentricCoord.x * triangle.p1 + barycentricCoord.y * triangle.p2;
 	const glm::vec3 fNormal = z * triangle.n0 + barycentricCoord.x * triangle.n1 + barycentricCoord.y * triangle.n2;
 	const glm::vec2 fTextCoord = z * triangle.uv0 + barycentricCoord.x * triangle.uv1 + barycentricCoord.y * triangle.uv2;
 
-	const glm::vec3 localPos = glm::vec3(invModelMatrix * glm::vec4(fPosition, 1.0f));
+	const glm::vec3 localPos = glm::vec3(invModelMatrix * glm::vec4(point.position, 1.0f));
 	const glm::vec3 localNormal = glm::vec3(invNormalMatrix * glm::vec4(fNormal, 1.0f));
 
-	glm::vec3 wo = glm::normalize(-ray->direction()); // normalize not necessary
-	glm::vec3 n = normalize(fNormal);
-	glm::vec3 res = glm::vec3(0, 0, 0);
-	std::shared_ptr<Material> modelMaterial = scenePtr->material(triangle.materialIndex);
-
+	// Pixel footprint on the surface, in model space
+	const glm::mat3& invModelLinear = model.invModelLinear;
+	const glm::mat3 localFootprint = invModelLinear * point.differentials.footprint() * glm::transpose(invModelLinear);
 
-	for (int i = 0; i < scenePtr->numOfLights(); i++) {
-		std::shared_ptr<LightSource> light = scenePtr->light(i);
-		glm::vec3 info;
-		if (light->type() == LightType::DirectionalLight) {
-			info = light->forward();
-		}
-		else {
-			info = light->attenuation();
-		}
-
-		glm::vec3 wi;
-		float attenuation;
-		if (light->type() == LightType::PointLight) {
-			glm::vec3 lp = light->center() - fPosition;
-			float d = length(lp);
-			wi = normalize(lp);
-			attenuation = 1 / (info.x + info.y * d + info.z * d * d);
-			attenuation = 1 / (info.x + info.y * d + info.z * d * d);
+	point.material = m_snapshot.materialKernels[triangle.materialIndex](*m_snapshot.materials[triangle.materialIndex], m_snapshot.textures,
+		m_textureFilter, fTextCoord, point.differentials, localPos, localNormal, localFootprint);
+	point.isMaterialSampled = true;
+}
 
+glm::vec3 RayTracer::shade(const std::shared_ptr<Scene>& scenePtr, SurfacePoint& point) {
+	glm::vec3 res = glm::vec3(0, 0, 0);
+#ifdef RENDERER_STATS
+	size_t firstNoiseCell = RenderStats::t_statistics[RenderStats::NoiseCells];
+#endif
+
+	if (!m_lightBVHPtr) {
+		for (int i : m_snapshot.pointLights)
+			res += lightContribution<LightType::PointLight>(scenePtr, point, m_snapshot.lights[i]);
+		for (int i : m_snapshot.directionalLights)
+			res += lightContribution<LightType::DirectionalLight>(scenePtr, point, m_snapshot.lights[i]);
+	} else {
+		for (int i : m_lightBVHPtr->directionalLights())
+			res += lightContribution<LightType::DirectionalLight>(scenePtr, point, m_snapshot.lights[i]);
+		if (m_numOfLightSamples == 0) {
+			m_lightBVHPtr->visitLights(point.position, point.normal, [&](int i) {
+				res += lightContribution<LightType::PointLight>(scenePtr, point, m_snapshot.lights[i]);
+			});
+		} else {
+			// Stratified over the samples, from a random offset per point
+			float offset = Sampler::toFloat(Sampler::hash(m_seed ^ pointKey(point.position)));
+			for (int sample = 0; sample < m_numOfLightSamples; sample++) {
+				float pdf;
+				int i = m_lightBVHPtr->sampleLight(point.position, point.normal, (sample + offset) / m_numOfLightSamples, pdf);
+				// No light reaching the point from this stratum
+				if (i < 0)
+					continue;
+				res += lightContribution<LightType::PointLight>(scenePtr, point, m_snapshot.lights[i]) / (m_numOfLightSamples * pdf);
+			}
 		}
-		else {
-			wi = -normalize(info);
-			attenuation = 1;
-		}
+	}
+#ifdef RENDERER_STATS
+	RenderStats::t_statistics.numOfShadingPoints++;
+	RenderStats::t_statistics.noiseCellsPerShadingPoint.add(RenderStats::t_statistics[RenderStats::NoiseCells] - firstNoiseCell);
+#endif
+	return res;
+}
 
+template <LightType type>
+glm::vec3 RayTracer::lightContribution(const std::shared_ptr<Scene>& scenePtr, SurfacePoint& point, const RenderSnapshot::Light& light) {
+	const glm::vec3& fPosition = point.position;
+	const glm::vec3& wo = point.wo;
+	const glm::vec3& n = point.normal;
+
+	glm::vec3 wi;
+	float attenuation;
+	if constexpr (type == LightType::PointLight) {
+		glm::vec3 lp = light.position - fPosition;
+		float d = length(lp);
+		wi = normalize(lp);
+		attenuation = 1 / (light.attenuation.x + light.attenuation.y * d + light.attenuation.z * d * d);
+	}
+	else {
+		wi = light.direction;
+		attenuation = 1;
+	}
 
-		std::shared_ptr<RayHit> hitToLight = rayScene(std::make_shared<Ray>(fPosition + 0.01f * n + 0.15f * wi, wi), scenePtr);
 
-		if (hitToLight) {
-			continue;
-		}
-
-		float wiDotN = max(0.f, dot(wi, n));
+	std::shared_ptr<RayHit> hitToLight = rayScene(std::make_shared<Ray>(fPosition + 0.01f * n + 0.15f * wi, wi), scenePtr);
+	RenderStats::count(RenderStats::ShadowRays);
 
-		if (wiDotN <= 0.f)
-			continue;
-		modelMaterial->albedo(localPos, localNormal);
-		modelMaterial->roughness(localPos, localNormal);
-		modelMaterial->metallicness(localPos, localNormal);
-		res += attenuation * lightRadiance(light, fPosition) * materialReflectance(scenePtr, modelMaterial, wi, wo, fTextCoord, n) * wiDotN;
+	if (hitToLight) {
+		RenderStats::count(RenderStats::ShadowRaysOccluded);
+		return glm::vec3(0.f);
 	}
-	return res;
-}
 
+	float wiDotN = max(0.f, dot(wi, n));
+
+	if (wiDotN <= 0.f)
+		return glm::vec3(0.f);
+	// Evaluated once, on the first light actually reaching the point
+	if (!point.isMaterialSampled)
+		sampleMaterial(scenePtr, point);
+	return attenuation * light.radiance * materialReflectance(point.material, wi, wo, n) * wiDotN;
+}
\ No newline at end of file
@@ -14,6 +14,8 @@
 #include <limits>
 #include <memory>
 #include <chrono>
+#include <atomic>
+#include <functional>
 
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
@@ -25,9 +27,36 @@
 #include "Camera.h"
 #include "PBR.h"
 #include "Solid3DNoise.h"
+#include "RenderStats.h"
+#include "Sampler.h"
+#include "LightBVH.h"
+#include "RenderSnapshot.h"
 
 using namespace std;
 
+/// Per pixel cost recorded by the ray tracer: time in cycles, (with RENDERER_STATS) BVH nodes visited or Gabor
+/// impulses evaluated, or camera samples.
+enum class CostMetric { None, Time, NodesVisited, NoiseImpulses, Samples };
+
+/// Reuse of the previous render when the camera moves: its primary hits are reprojected to the new view, and the pixels
+/// receiving a hit consistent with its neighbors skip their primary ray. Shading reuses the hit and its material sample,
+/// tracing the shadow rays again; Radiance reuses the color as well, view dependent highlights lagging behind.
+enum class ReprojectionMode { Off, Shading, Radiance };
+
+/// Primary hit of a camera sample, with all its shading needs but the lights.
+struct SurfacePoint {
+	int triangleIndex = -1; // -1 if the sample sees the background
+	glm::vec2 barycentricCoord;
+	glm::vec3 position;
+	glm::vec3 normal; // normalized
+	glm::vec3 wo; // toward the camera
+	SurfaceDifferentials differentials;
+	MaterialSample material;
+	bool isMaterialSampled = false; // on the first light reaching the point
+	glm::vec3 radiance = glm::vec3(0.f); // of the last shading
+	int age = 0; // renders the hit was reprojected through
+};
+
 
 class RayTracer {
 public:
@@ -37,21 +66,200 @@ public:
 
 	inline void setResolution (int width, int height) { m_imagePtr = make_shared<Image> (width, height); }
 	inline std::shared_ptr<Image> image () { return m_imagePtr; }
-	void init (const std::shared_ptr<Scene> scenePtr);
+	void init (const std::shared_ptr<Scene>& scenePtr);
 	void activateBVH(bool state) { BVHisActive = state; }
-	void render (const std::shared_ptr<Scene> scenePtr);
-	inline std::shared_ptr<RayHit> rayScene(const std::shared_ptr<Ray>& ray, const std::shared_ptr<Scene> scenePtr);
-	glm::vec3 lightRadiance(const std::shared_ptr<LightSource>& lightPtr, const glm::vec3& position) const;
-	glm::vec3 materialReflectance(const std::shared_ptr<Scene> scenePtr,
-		const std::shared_ptr<Material> material,
+	/// Primary rays carry differentials, used to band-limit texture and noise lookups to the pixel footprint.
+	void activateRayDifferentials(bool state) {
+		m_useRayDifferentials = state;
+		m_gBuffer.isValid = false;
+	}
+	inline bool rayDifferentialsAreActive() const { return m_useRayDifferentials; }
+	/// Filtering of the texture fetches over the pixel footprint (requires ray differentials).
+	inline void setTextureFilter(TextureFilter filter) { m_textureFilter = filter; }
+	inline TextureFilter textureFilter() const { return m_textureFilter; }
+	/// Samples per pixel, spread over the pixel area by the sampler. A single sample goes through the pixel center.
+	inline void setSamplesPerPixel(int samplesPerPixel) {
+		m_gBuffer.isValid = m_gBuffer.isValid && std::max(1, samplesPerPixel) == m_samplesPerPixel;
+		m_samplesPerPixel = std::max(1, samplesPerPixel);
+	}
+	inline int samplesPerPixel() const { return m_samplesPerPixel; }
+	/// Adaptive supersampling, active while 'maxSamplesPerPixel' is above samplesPerPixel: the samples of each pixel are
+	/// taken by batches of samplesPerPixel (at least 2), until the standard error of their mean
+	/// luminance falls below 'threshold' times the mean, or 'maxSamplesPerPixel' is reached.
+	inline void setAdaptiveSampling(int maxSamplesPerPixel, float threshold) {
+		m_maxSamplesPerPixel = std::max(1, maxSamplesPerPixel);
+		m_adaptiveThreshold = threshold;
+	}
+	inline bool adaptiveSamplingIsActive() const { return m_maxSamplesPerPixel > m_samplesPerPixel; }
+	inline int maxSamplesPerPixel() const { return m_maxSamplesPerPixel; }
+	inline float adaptiveThreshold() const { return m_adaptiveThreshold; }
+	/// Point lights whose attenuated radiance falls below 'cutoff' at a shading point are skipped, the ones in range
+	/// being found in a light BVH. 0, the default, evaluates every light.
+	inline void setLightCutoff(float cutoff) { m_lightCutoff = std::max(0.f, cutoff); }
+	inline float lightCutoff() const { return m_lightCutoff; }
+	/// Point lights sampled per shading point, by importance in the light BVH, for scenes of many lights: the shading cost
+	/// then grows with the logarithm of the number of lights. 0, the default, evaluates all the lights in range.
+	/// Directional lights are always evaluated. When sampling, the light cutoff does not apply, so that every light
+	/// keeps a chance of being selected.
+	inline void setNumOfLightSamples(int numOfLightSamples) { m_numOfLightSamples = std::max(0, numOfLightSamples); }
+	inline int numOfLightSamples() const { return m_numOfLightSamples; }
+	/// Number of rendering threads, 0 for the OpenMP default.
+	inline void setNumOfThreads(int numOfThreads) { m_numOfThreads = std::max(0, numOfThreads); }
+	inline int numOfThreads() const { return m_numOfThreads; }
+	/// Reports each render on the console. On by default.
+	inline void setVerbose(bool verbose) { m_isVerbose = verbose; }
+	/// Seed of the sample positions: a render is reproducible for a given seed.
+	inline void setSeed(unsigned int seed) {
+		m_seed = seed;
+		m_sampler = Sampler(m_sampler.type(), seed);
+		m_gBuffer.isValid = false;
+	}
+	/// Sequence of the sample positions over the pixels, for supersampling (progressive, uniform or adaptive).
+	inline void setSamplerType(SamplerType type) {
+		m_sampler = Sampler(type, m_seed);
+		m_gBuffer.isValid = false;
+	}
+	inline SamplerType samplerType() const { return m_sampler.type(); }
+	/// Renders the image by tiles, distributed over the threads. Returns false if cancelled before completion.
+	bool render (const std::shared_ptr<Scene>& scenePtr);
+	/// Passes of a progressive render filling the image at 1 spp, on grids of spacing 8, 4, 2 then 1.
+	static const int NUM_OF_COARSE_PASSES = 4;
+	/// Renders a pass of a progressive render, at the resolution of the image. Pass 0 renders every 8th pixel and fills
+	/// the 8x8 blocks, the coarse passes after halve the spacing, the last one completing the same image as render at
+	/// 1 spp. Each pass after adds a jittered sample per pixel to the running average. Returns false if cancelled.
+	bool renderPass (const std::shared_ptr<Scene>& scenePtr, int pass);
+	/// Keeps the primary hits of the renders in a G-buffer, for relight. Renders at a uniform sample count record every
+	/// sample (about 100 bytes each), progressive ones their first 1 spp image; adaptive ones record nothing.
+	/// Disabling it releases the G-buffer.
+	inline void setGBufferEnabled(bool enabled) {
+		m_isGBufferEnabled = enabled;
+		if (!enabled)
+			m_gBuffer = GBuffer();
+	}
+	inline bool gBufferIsEnabled() const { return m_isGBufferEnabled; }
+	/// True if the G-buffer holds a complete render of the current camera, at the resolution of the image.
+	bool canRelight(const std::shared_ptr<Scene>& scenePtr) const;
+	/// Renders the image again from the G-buffer, tracing only the shadow rays: for changes of the lights or of the
+	/// background. 'materialsChanged' evaluates the materials again, after a change of their parameters or of the texture
+	/// filter. Returns false, leaving the image as is, if the G-buffer cannot be used (see canRelight), or if cancelled.
+	/// Its tiles are posted to the tile callback as the ones of a render.
+	bool relight(const std::shared_ptr<Scene>& scenePtr, bool materialsChanged = false);
+	/// Discards the G-buffer, e.g. once the geometry moved, which the ray tracer cannot detect.
+	inline void invalidateGBuffer() { m_gBuffer.isValid = false; }
+	/// Renders after the first reproject the G-buffer of the previous one, recorded whatever setGBufferEnabled. Only
+	/// renders at 1 spp, not adaptive, reproject; the geometry must not move in between (see invalidateGBuffer).
+	inline void setReprojectionMode(ReprojectionMode mode) { m_reprojectionMode = mode; }
+	inline ReprojectionMode reprojectionMode() const { return m_reprojectionMode; }
+	/// Renders a reprojected hit can be reused through at most, before being traced again.
+	static const int MAX_REPROJECTION_AGE = 8;
+	/// Pixels of the last render reusing a reprojected hit instead of tracing their primary ray.
+	inline size_t numOfReprojectedPixels() const { return m_numOfReprojectedPixels; }
+	/// Called by the rendering threads once a tile of the image is final, with its pixel bounds [xMin, xMax) x [yMin, yMax).
+	using TileCallback = std::function<void (int xMin, int yMin, int xMax, int yMax)>;
+	inline void setTileCallback(const TileCallback& callback) { m_tileCallback = callback; }
+	/// Makes the render in flight, and the next ones until clearCancellation, skip their remaining tiles. Thread safe.
+	inline void requestCancellation() { m_cancellationRequested.store(true, std::memory_order_relaxed); }
+	inline void clearCancellation() { m_cancellationRequested.store(false, std::memory_order_relaxed); }
+	inline bool cancellationRequested() const { return m_cancellationRequested.load(std::memory_order_relaxed); }
+	/// Fraction of the tiles of the current (or last) render completed. Thread safe.
+	inline float progress() const { return m_numOfTiles ? float(m_numOfCompletedTiles.load(std::memory_order_relaxed)) / m_numOfTiles : 0.f; }
+	/// Records the cost of each pixel in the cost image during the next renders.
+	inline void setCostMetric(CostMetric metric) { m_costMetric = metric; }
+	inline CostMetric costMetric() const { return m_costMetric; }
+	/// Raw cost of each pixel of the last render with a cost metric, in every channel, stored as the color image.
+	inline std::shared_ptr<Image> costImage() { return m_costImagePtr; }
+	/// Cost image mapped to colors, from black (free) to white (99th percentile of the costs and above).
+	inline std::shared_ptr<Image> costHeatmap() { return m_costHeatmapPtr; }
+	/// Rays traced by the last render, primary and shadow ones.
+	inline size_t numOfRays() const { return m_numOfRays; }
+	/// Camera samples rendered by the last render.
+	inline size_t numOfSamples() const { return m_numOfSamples; }
+	/// Work counters of the last render, empty unless built with RENDERER_STATS.
+	inline const RenderStats::Statistics& statistics() const { return m_statistics; }
+	inline std::shared_ptr<RayHit> rayScene(const std::shared_ptr<Ray>& ray, const std::shared_ptr<Scene>& scenePtr);
+	glm::vec3 lightRadiance(const LightSource& light, const glm::vec3& position) const;
+	glm::vec3 materialReflectance(const MaterialSample& sample,
 		const glm::vec3& wi,
 		const glm::vec3& wo,
-		const glm::vec2& uv, 
 		const glm::vec3& n) const;
-	glm::vec3 shade(const std::shared_ptr<Scene> scenePtr, const std::shared_ptr<RayHit>& rayHit, const std::shared_ptr<Ray> ray);
-	std::shared_ptr<Ray> rayAt(float x, float y, const glm::mat4& frameMatrix, const std::shared_ptr<Camera> camera);
+	glm::vec3 shade(const std::shared_ptr<Scene>& scenePtr, const std::shared_ptr<RayHit>& rayHit, const std::shared_ptr<Ray>& ray);
+	SurfacePoint surfacePoint(const std::shared_ptr<Scene>& scenePtr, const RayHit& rayHit, const Ray& ray) const;
+	/// Evaluates the material of a point, in its model space and over its footprint, with the kernel of the material in
+	/// the snapshot of the current render.
+	void sampleMaterial(const std::shared_ptr<Scene>& scenePtr, SurfacePoint& point) const;
+	/// Direct lighting of a point, sampling its material on the first light reaching it if not yet sampled.
+	glm::vec3 shade(const std::shared_ptr<Scene>& scenePtr, SurfacePoint& point);
+	std::shared_ptr<Ray> rayAt(float x, float y, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera);
+	/// Same as above, with differentials toward the next pixel, (dx, dy) being the pixel size in normalized coordinates.
+	std::shared_ptr<Ray> rayAt(float x, float y, float dx, float dy, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera);
 
 private:
+	/// Primary hits of the last render, samplesPerPixel per pixel, row major.
+	struct GBuffer {
+		std::vector<SurfacePoint> points;
+		int width = 0;
+		int height = 0;
+		int samplesPerPixel = 0;
+		glm::mat4 frameMatrix = glm::mat4(1.f);
+		float fov = 0.f;
+		float aspectRatio = 0.f;
+		bool isRecording = false;
+		bool isValid = false;
+	};
+
+	/// Renders the tiles of the image over the threads, calling renderTile (xMin, yMin, xMax, yMax, frameMatrix, camera)
+	/// for each. Returns false if cancelled.
+	template <typename TileFunction>
+	bool renderTiles(const std::shared_ptr<Scene>& scenePtr, const TileFunction& renderTile);
+	glm::vec3 renderPixel(const std::shared_ptr<Scene>& scenePtr, int x, int y, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera);
+	glm::vec3 renderAdaptivePixel(const std::shared_ptr<Scene>& scenePtr, int x, int y, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera);
+	/// Radiance through the point 'offset' of pixel (x, y), 'differential' being the ray footprint in normalized coordinates.
+	/// The primary hit is stored in 'gBufferPoint' if not null.
+	glm::vec3 renderSample(const std::shared_ptr<Scene>& scenePtr, int x, int y, const glm::vec2& offset, const glm::vec2& differential, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera, SurfacePoint* gBufferPoint = nullptr);
+	/// For each pixel of the image seen from the current camera, the index of the hit of 'previous' reprojected to it, or -1
+	/// if the pixel must be traced: no hit landed on it, or a neighbor disagrees in depth or normal (occlusion boundary).
+	std::vector<int> reproject(const GBuffer& previous, const std::shared_ptr<Scene>& scenePtr) const;
+	/// Color of pixel (x, y) reusing the hit 'previousPoint', recorded in the G-buffer.
+	glm::vec3 renderReprojectedPixel(const std::shared_ptr<Scene>& scenePtr, int x, int y, const SurfacePoint& previousPoint, const glm::vec3& eye);
+	/// Prepares the G-buffer to record a render at 'samplesPerPixel', or invalidates it if not enabled.
+	void beginGBuffer(const std::shared_ptr<Scene>& scenePtr, int samplesPerPixel);
+	inline SurfacePoint* gBufferPoint(int x, int y, int sample) {
+		return m_gBuffer.isRecording ? &m_gBuffer.points[(size_t(y) * m_gBuffer.width + x) * m_gBuffer.samplesPerPixel + sample] : nullptr;
+	}
+	/// Radiance reflected by a point from a light of the snapshot of the given type, tracing its shadow ray.
+	template <LightType type>
+	glm::vec3 lightContribution(const std::shared_ptr<Scene>& scenePtr, SurfacePoint& point, const RenderSnapshot::Light& light);
+	glm::vec3 rayDirectionAt(float x, float y, const glm::mat4& frameMatrix, const std::shared_ptr<Camera>& camera) const;
+	void updateCostHeatmap();
+
 	std::shared_ptr<Image> m_imagePtr;
 	bool BVHisActive;
+	bool m_useRayDifferentials;
+	TextureFilter m_textureFilter;
+	int m_samplesPerPixel;
+	int m_maxSamplesPerPixel;
+	float m_adaptiveThreshold;
+	int m_numOfThreads;
+	unsigned int m_seed;
+	Sampler m_sampler;
+	bool m_isVerbose;
+	size_t m_numOfRays;
+	size_t m_numOfSamples;
+	RenderStats::Statistics m_statistics;
+	CostMetric m_costMetric;
+	std::shared_ptr<Image> m_costImagePtr;
+	std::shared_ptr<Image> m_costHeatmapPtr;
+	std::shared_ptr<Image> m_accumulatedImagePtr; // sum of the samples of a progressive render
+	bool m_isGBufferEnabled;
+	GBuffer m_gBuffer;
+	ReprojectionMode m_reprojectionMode;
+	size_t m_numOfReprojectedPixels;
+	float m_lightCutoff;
+	int m_numOfLightSamples;
+	std::shared_ptr<LightBVH> m_lightBVHPtr; // of the current render, null to loop over all the lights
+	RenderSnapshot m_snapshot; // of the scene, compiled at the start of each render
+	TileCallback m_tileCallback;
+	std::atomic<bool> m_cancellationRequested;
+	std::atomic<int> m_numOfCompletedTiles;
+	std::atomic<int> m_numOfTiles;
 };
\ No newline at end of file
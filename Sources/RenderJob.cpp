@@ -0,0 +1,101 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#include "RenderJob.h"
+
+#include <chrono>
+
+#include "Console.h"
+#include "Profiler.h"
+
+RenderJob::RenderJob (std::shared_ptr<RayTracer> rayTracerPtr)
+	: m_rayTracerPtr (rayTracerPtr),
+	  m_displayImagePtr (std::make_shared<Image> ()),
+	  m_isProgressive (false),
+	  m_maxSamplesPerPixel (64),
+	  m_numOfPasses (1),
+	  m_numOfCompletedPasses (0),
+	  m_isRunning (false) {}
+
+RenderJob::~RenderJob () {
+	cancel ();
+}
+
+void RenderJob::start (std::shared_ptr<Scene> scenePtr, int width, int height, std::shared_ptr<Image> previewPtr) {
+	cancel ();
+	m_rayTracerPtr->setResolution (width, height);
+	m_renderedImagePtr = m_rayTracerPtr->image ();
+	if (m_displayImagePtr->width () != size_t (width) || m_displayImagePtr->height () != size_t (height)) {
+		m_displayImagePtr = std::make_shared<Image> (width, height);
+		m_displayImagePtr->clear (scenePtr->backgroundColor ());
+	}
+	if (previewPtr)
+		for (size_t y = 0; y < m_displayImagePtr->height (); y++)
+			for (size_t x = 0; x < m_displayImagePtr->width (); x++)
+				(*m_displayImagePtr) (x, y) = (*previewPtr) (x * previewPtr->width () / width, y * previewPtr->height () / height);
+	{
+		std::lock_guard<std::mutex> lock (m_tilesMutex);
+		m_completedTiles.clear ();
+	}
+	m_numOfPasses = m_isProgressive ? RayTracer::NUM_OF_COARSE_PASSES + m_maxSamplesPerPixel - 1 : 1;
+	m_numOfCompletedPasses = 0;
+	m_isRunning = true;
+	// Only the renders of the job post their tiles: the synchronous ones in between render other images
+	m_rayTracerPtr->setTileCallback ([this] (int xMin, int yMin, int xMax, int yMax) {
+		std::lock_guard<std::mutex> lock (m_tilesMutex);
+		m_completedTiles.push_back ({ xMin, yMin, xMax, yMax });
+	});
+	m_thread = std::thread ([this, scenePtr] () {
+		if (m_isProgressive)
+			renderProgressively (scenePtr);
+		else if (m_rayTracerPtr->render (scenePtr))
+			m_numOfCompletedPasses = 1;
+		m_isRunning = false;
+	});
+}
+
+void RenderJob::cancel () {
+	if (!m_thread.joinable ())
+		return;
+	m_rayTracerPtr->requestCancellation ();
+	m_thread.join ();
+	m_rayTracerPtr->clearCancellation ();
+	m_rayTracerPtr->setTileCallback (nullptr);
+}
+
+void RenderJob::renderProgressively (std::shared_ptr<Scene> scenePtr) {
+	auto before = std::chrono::steady_clock::now ();
+	for (int pass = 0; pass < m_numOfPasses; pass++) {
+		if (!m_rayTracerPtr->renderPass (scenePtr, pass))
+			break;
+		m_numOfCompletedPasses++;
+		if (pass == RayTracer::NUM_OF_COARSE_PASSES - 1)
+			Console::print ("Progressive ray tracing: 1 spp image in " + std::to_string (std::chrono::duration_cast<std::chrono::milliseconds> (
+				std::chrono::steady_clock::now () - before).count ()) + "ms");
+	}
+	Console::print ("Progressive ray tracing " + std::string (m_numOfCompletedPasses == m_numOfPasses ? "completed" : "cancelled") + " at "
+					+ std::to_string (samplesPerPixel ()) + " spp, in " + std::to_string (std::chrono::duration_cast<std::chrono::milliseconds> (
+					std::chrono::steady_clock::now () - before).count ()) + "ms");
+}
+
+bool RenderJob::updateImage () {
+	std::vector<Tile> tiles;
+	{
+		std::lock_guard<std::mutex> lock (m_tilesMutex);
+		tiles.swap (m_completedTiles);
+	}
+	if (tiles.empty () || !m_renderedImagePtr)
+		return false;
+	PROFILE_SCOPE_ARG ("RenderJob::updateImage", tiles.size ());
+	// The image pixels of a tile are final before it is posted, the lock ordering their writes before these reads
+	for (const Tile & tile : tiles)
+		for (int y = tile.yMin; y < tile.yMax; y++)
+			std::copy (&(*m_renderedImagePtr) (tile.xMin, y), &(*m_renderedImagePtr) (tile.xMin, y) + (tile.xMax - tile.xMin),
+					   &(*m_displayImagePtr) (tile.xMin, y));
+	return true;
+}
@@ -0,0 +1,87 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#pragma once
+
+#include <algorithm>
+#include <atomic>
+#include <memory>
+#include <mutex>
+#include <thread>
+#include <vector>
+
+#include "Image.h"
+#include "Scene.h"
+#include "RayTracer.h"
+
+/// Runs the renders of a ray tracer on a background thread. The tiles completed by the ray tracer are copied to a
+/// separate display image when the owner asks for them, so that the image being rendered is never read while written.
+///
+/// The scene, its camera and the ray tracer settings must not change during a render: cancel it first.
+class RenderJob {
+public:
+	RenderJob (std::shared_ptr<RayTracer> rayTracerPtr);
+
+	/// Cancels the render in flight.
+	virtual ~RenderJob ();
+
+	/// Progressive renders (see RayTracer::renderPass) show a coarse image within milliseconds, refined to 1 spp then
+	/// accumulating samples up to 'maxSamplesPerPixel'. Otherwise, the ray tracer renders its final image at once.
+	inline void setProgressive (bool progressive, int maxSamplesPerPixel = 64) {
+		m_isProgressive = progressive;
+		m_maxSamplesPerPixel = std::max (1, maxSamplesPerPixel);
+	}
+
+	inline bool isProgressive () const { return m_isProgressive; }
+
+	/// Cancels the render in flight, then starts rendering the scene at the given resolution. Until the new tiles replace
+	/// them, the display image shows 'previewPtr' upscaled if given (e.g. a lower resolution render of the same view),
+	/// else keeps the previous render if of the same resolution.
+	void start (std::shared_ptr<Scene> scenePtr, int width, int height, std::shared_ptr<Image> previewPtr = nullptr);
+
+	/// Stops the render in flight, returning once the rendering thread is done (after the tiles started meanwhile). The
+	/// ray tracer can then be used again, e.g. for a synchronous render, whose tiles are not posted to the job.
+	void cancel ();
+
+	inline bool isRunning () const { return m_isRunning.load (); }
+
+	/// Fraction of the current render completed, over all its passes.
+	inline float progress () const {
+		return (m_numOfCompletedPasses.load () + m_rayTracerPtr->progress ()) / m_numOfPasses;
+	}
+
+	/// Samples per pixel of the completed passes of a progressive render, 0 before the image is complete.
+	inline int samplesPerPixel () const {
+		return std::max (0, m_numOfCompletedPasses.load () - RayTracer::NUM_OF_COARSE_PASSES + 1);
+	}
+
+	/// Copies the tiles completed since the last call to the display image. Returns true if any was.
+	bool updateImage ();
+
+	/// Image showing the tiles copied by updateImage.
+	inline std::shared_ptr<Image> image () { return m_displayImagePtr; }
+
+private:
+	void renderProgressively (std::shared_ptr<Scene> scenePtr);
+
+	struct Tile {
+		int xMin, yMin, xMax, yMax;
+	};
+
+	std::shared_ptr<RayTracer> m_rayTracerPtr;
+	std::shared_ptr<Image> m_renderedImagePtr;
+	std::shared_ptr<Image> m_displayImagePtr;
+	bool m_isProgressive;
+	int m_maxSamplesPerPixel;
+	int m_numOfPasses;
+	std::atomic<int> m_numOfCompletedPasses;
+	std::thread m_thread;
+	std::atomic<bool> m_isRunning;
+	std::mutex m_tilesMutex;
+	std::vector<Tile> m_completedTiles; // guarded by m_tilesMutex
+};
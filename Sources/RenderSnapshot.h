@@ -0,0 +1,82 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Scene.h"
+#include "ShadingKernels.h"
+
+/// Scene data constant over a render, compiled from the scene before the first pixel: the per pixel path reads plain
+/// arrays, indexed as the scene ones, instead of copying shared pointers and inverting matrices at every hit. The raw
+/// pointers are owned by the scene, which must outlive the snapshot and not change during the render.
+struct RenderSnapshot {
+	/// Light with its transform resolved.
+	struct Light {
+		LightType type;
+		glm::vec3 radiance; // at unit attenuation, see RayTracer::lightRadiance
+		glm::vec3 attenuation; // constant, linear and quadratic coefficients of a point light
+		glm::vec3 position; // of a point light
+		glm::vec3 direction; // toward a directional light, normalized
+	};
+
+	/// Inverse transforms of a model, from world space to its model space.
+	struct Model {
+		glm::mat4 invModelMatrix;
+		glm::mat4 invNormalMatrix;
+		glm::mat3 invModelLinear;
+	};
+
+	RenderSnapshot() = default;
+
+	/// Compiles 'scene', the light radiances being given by 'lightRadiance (light)'.
+	template <typename RadianceFunction>
+	RenderSnapshot(const Scene& scene, const RadianceFunction& lightRadiance);
+
+	std::vector<Light> lights;
+	/// Indices of the lights of each type, in the scene order, for the shading kernels of the type.
+	std::vector<int> pointLights;
+	std::vector<int> directionalLights;
+	std::vector<Model> models;
+	std::vector<const Material*> materials;
+	/// Specialized evaluation of each material (see ShadingKernels).
+	std::vector<ShadingKernels::MaterialKernel> materialKernels;
+	std::vector<const Texture*> textures;
+};
+
+template <typename RadianceFunction>
+RenderSnapshot::RenderSnapshot(const Scene& scene, const RadianceFunction& lightRadiance) {
+	lights.resize(scene.numOfLights());
+	for (size_t i = 0; i < lights.size(); i++) {
+		const LightSource& light = *scene.light(i);
+		lights[i].type = light.type();
+		lights[i].radiance = lightRadiance(light);
+		lights[i].attenuation = light.attenuation();
+		lights[i].position = light.center();
+		lights[i].direction = -glm::normalize(light.forward());
+		(light.type() == LightType::PointLight ? pointLights : directionalLights).push_back(static_cast<int>(i));
+	}
+	models.resize(scene.numOfModels());
+	for (size_t i = 0; i < models.size(); i++) {
+		models[i].invModelMatrix = glm::inverse(scene.model(i)->transform().computeTransformMatrix());
+		models[i].invNormalMatrix = glm::inverse(glm::transpose(models[i].invModelMatrix));
+		models[i].invModelLinear = glm::mat3(models[i].invModelMatrix);
+	}
+	materials.resize(scene.numOfMaterials());
+	materialKernels.resize(materials.size());
+	for (size_t i = 0; i < materials.size(); i++) {
+		materials[i] = scene.material(i).get();
+		materialKernels[i] = ShadingKernels::materialKernel(*materials[i]);
+	}
+	textures.resize(scene.numOfTextures());
+	for (size_t i = 0; i < textures.size(); i++)
+		textures[i] = scene.texture(i).get();
+}
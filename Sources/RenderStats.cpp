@@ -0,0 +1,81 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#include "RenderStats.h"
+
+#include <sstream>
+#include <iomanip>
+#include <algorithm>
+
+namespace RenderStats {
+
+#ifdef RENDERER_STATS
+thread_local Statistics t_statistics;
+#endif
+
+void Histogram::add(size_t value) {
+	int bucket = 0;
+	while (value && bucket < NUM_OF_BUCKETS - 1) {
+		value >>= 1;
+		bucket++;
+	}
+	m_buckets[bucket]++;
+}
+
+void Histogram::merge(const Histogram& other) {
+	for (int i = 0; i < NUM_OF_BUCKETS; i++)
+		m_buckets[i] += other.m_buckets[i];
+}
+
+size_t Histogram::count() const {
+	size_t result = 0;
+	for (size_t value : m_buckets)
+		result += value;
+	return result;
+}
+
+std::string Histogram::toString() const {
+	std::ostringstream stream;
+	for (int i = 0; i < NUM_OF_BUCKETS; i++) {
+		if (!m_buckets[i])
+			continue;
+		size_t low = i ? size_t(1) << (i - 1) : 0;
+		size_t high = size_t(1) << i;
+		stream << " [" << low << "," << high << ") " << m_buckets[i];
+	}
+	return stream.str();
+}
+
+void Statistics::merge(const Statistics& other) {
+	for (int i = 0; i < NUM_OF_COUNTERS; i++)
+		counters[i] += other.counters[i];
+	numOfRays += other.numOfRays;
+	numOfShadingPoints += other.numOfShadingPoints;
+	nodesPerRay.merge(other.nodesPerRay);
+	triangleTestsPerRay.merge(other.triangleTestsPerRay);
+	noiseCellsPerShadingPoint.merge(other.noiseCellsPerShadingPoint);
+}
+
+std::string Statistics::report() const {
+	double rays = static_cast<double>(std::max<size_t>(1, numOfRays));
+	double points = static_cast<double>(std::max<size_t>(1, numOfShadingPoints));
+	std::ostringstream stream;
+	stream << std::fixed << std::setprecision(2)
+		<< "Render statistics: " << numOfRays << " rays, " << counters[ShadowRays] << " shadow rays ("
+		<< counters[ShadowRaysOccluded] << " occluded), " << numOfShadingPoints << " shading points\n"
+		<< "  per ray: " << counters[NodesVisited] / rays << " nodes visited, " << counters[BoxTests] / rays << " box tests, "
+		<< counters[TriangleTests] / rays << " triangle tests\n"
+		<< "  per shading point: " << counters[ShadowRays] / points << " shadow rays, " << counters[NoiseCells] / points
+		<< " noise cells, " << counters[NoiseImpulses] / points << " noise impulses\n"
+		<< "  nodes visited per ray:" << nodesPerRay.toString() << "\n"
+		<< "  triangle tests per ray:" << triangleTestsPerRay.toString() << "\n"
+		<< "  noise cells per shading point:" << noiseCellsPerShadingPoint.toString();
+	return stream.str();
+}
+
+}
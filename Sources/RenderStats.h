@@ -0,0 +1,79 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#pragma once
+
+#include <array>
+#include <string>
+
+/// Work counters of the ray tracer: BVH traversal, shadow rays and noise evaluation. They are compiled in with
+/// RENDERER_STATS (CMake option of the same name) and cost nothing otherwise. Each thread counts in its own
+/// statistics, merged once per thread at the end of a render.
+namespace RenderStats {
+
+enum Counter {
+	NodesVisited,       ///< BVH nodes whose box is hit
+	BoxTests,           ///< ray / box intersection tests
+	TriangleTests,      ///< ray / triangle intersection tests
+	ShadowRays,
+	ShadowRaysOccluded,
+	NoiseCells,         ///< Gabor noise cells evaluated, of any noise
+	NoiseImpulses,      ///< Gabor impulses drawn in these cells
+	NUM_OF_COUNTERS
+};
+
+/// Distribution of a per-ray (or per-point) count, in power of two buckets: bucket 0 counts the zeros,
+/// bucket i > 0 the values in [2^(i-1), 2^i).
+class Histogram {
+public:
+	static const int NUM_OF_BUCKETS = 40;
+
+	void add(size_t value);
+	void merge(const Histogram& other);
+	size_t count() const;
+	/// Non empty buckets, as "[low,high) count" items.
+	std::string toString() const;
+
+private:
+	std::array<size_t, NUM_OF_BUCKETS> m_buckets = {};
+};
+
+/// Counters of one thread, or of a whole render once merged.
+struct Statistics {
+	std::array<size_t, NUM_OF_COUNTERS> counters = {};
+	size_t numOfRays = 0;
+	size_t numOfShadingPoints = 0;
+	Histogram nodesPerRay;
+	Histogram triangleTestsPerRay;
+	Histogram noiseCellsPerShadingPoint;
+
+	inline size_t operator[](Counter counter) const { return counters[counter]; }
+	inline void clear() { *this = Statistics(); }
+	void merge(const Statistics& other);
+	/// Averages per ray and per shading point, then the histograms.
+	std::string report() const;
+};
+
+#ifdef RENDERER_STATS
+
+const bool ENABLED = true;
+
+/// Statistics of the calling thread.
+extern thread_local Statistics t_statistics;
+
+inline void count(Counter counter, size_t n = 1) { t_statistics.counters[counter] += n; }
+
+#else
+
+const bool ENABLED = false;
+
+inline void count(Counter, size_t = 1) {}
+
+#endif
+
+}
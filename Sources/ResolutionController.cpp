@@ -0,0 +1,39 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#include "ResolutionController.h"
+
+#include <algorithm>
+#include <cmath>
+
+/// Weight of the last frame in the time per pixel: high enough to follow the view within a few frames, low enough to
+/// smooth out the noise of the timings.
+static const float LEARNING_RATE = 0.3f;
+
+/// Scale of the first frame, before any measure.
+static const float INITIAL_SCALE = 0.25f;
+
+ResolutionController::ResolutionController (float targetFrameTime, float minScale)
+	: m_targetFrameTime (targetFrameTime), m_minScale (minScale), m_timePerPixel (0.f) {}
+
+float ResolutionController::scale (int width, int height) const {
+	if (m_timePerPixel <= 0.f)
+		return std::max (m_minScale, INITIAL_SCALE);
+	float numOfPixels = m_targetFrameTime / (m_timePerPixel * float (width) * float (height));
+	return std::clamp (std::sqrt (numOfPixels), m_minScale, 1.f);
+}
+
+glm::ivec2 ResolutionController::resolution (int width, int height) const {
+	float s = scale (width, height);
+	return glm::ivec2 (std::max (1, static_cast<int> (s * width)), std::max (1, static_cast<int> (s * height)));
+}
+
+void ResolutionController::addFrame (int width, int height, float milliseconds) {
+	float timePerPixel = milliseconds / std::max (1.f, float (width) * float (height));
+	m_timePerPixel = m_timePerPixel > 0.f ? (1.f - LEARNING_RATE) * m_timePerPixel + LEARNING_RATE * timePerPixel : timePerPixel;
+}
@@ -0,0 +1,39 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#pragma once
+
+#include <glm/glm.hpp>
+
+/// Chooses the resolution of interactive ray traced frames so that they render within a time budget. The render time
+/// per pixel is learned from the previous frames, as a moving average following the changes of view.
+class ResolutionController {
+public:
+	/// 'minScale' bounds the resolution scale from below, whatever the cost of the frames.
+	ResolutionController (float targetFrameTime = 33.f, float minScale = 0.1f);
+
+	inline void setTargetFrameTime (float milliseconds) { m_targetFrameTime = milliseconds; }
+	inline float targetFrameTime () const { return m_targetFrameTime; }
+
+	/// Fraction of the viewport resolution, along each axis, of the next frame.
+	float scale (int width, int height) const;
+
+	/// Resolution of the next frame for a viewport of the given size, never above it.
+	glm::ivec2 resolution (int width, int height) const;
+
+	/// Learns from the render time of a frame of the given resolution.
+	void addFrame (int width, int height, float milliseconds);
+
+	/// Milliseconds per pixel learned so far, 0 before the first frame.
+	inline float timePerPixel () const { return m_timePerPixel; }
+
+private:
+	float m_targetFrameTime;
+	float m_minScale;
+	float m_timePerPixel;
+};
@@ -0,0 +1,109 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#include "Sampler.h"
+
+#include <algorithm>
+#include <cmath>
+
+#include "Profiler.h"
+
+namespace {
+
+/// Tileable blue noise values in [0, 1), by the void and cluster method (Ulichney 1993): pixels are ranked by
+/// adding them one at a time to the largest void of a binary pattern, the values being the normalized ranks.
+std::vector<float> voidAndCluster (int size, uint32_t seed) {
+	const int numOfPixels = size * size;
+	const float sigma = 1.5f;
+	// Gaussian energy of a pixel over the tile, wrapped around, indexed by the offset to it
+	std::vector<float> kernel (numOfPixels);
+	for (int dy = -size / 2; dy < size / 2; dy++)
+		for (int dx = -size / 2; dx < size / 2; dx++)
+			kernel[((dy + size) % size) * size + (dx + size) % size] = std::exp (-(dx * dx + dy * dy) / (2.f * sigma * sigma));
+
+	std::vector<char> pattern (numOfPixels, 0);
+	std::vector<float> energy (numOfPixels, 0.f);
+	auto update = [&] (std::vector<char> & bits, std::vector<float> & field, int pixel, bool set) {
+		bits[pixel] = set;
+		int px = pixel % size;
+		int py = pixel / size;
+		float sign = set ? 1.f : -1.f;
+		for (int y = 0; y < size; y++) {
+			const float * row = &kernel[((y - py + size) % size) * size];
+			for (int x = 0; x < size; x++)
+				field[y * size + x] += sign * row[(x - px + size) % size];
+		}
+	};
+	// Tightest cluster: set pixel of highest energy. Largest void: unset pixel of lowest energy.
+	auto extremum = [&] (const std::vector<char> & bits, const std::vector<float> & field, bool set) {
+		int best = -1;
+		for (int i = 0; i < numOfPixels; i++)
+			if (bits[i] == set && (best < 0 || (set ? field[i] > field[best] : field[i] < field[best])))
+				best = i;
+		return best;
+	};
+
+	// Initial pattern: a tenth of the pixels, at random, then moved from the clusters to the voids until stable
+	int numOfInitialPixels = numOfPixels / 10;
+	for (int i = 0, numOfSet = 0; numOfSet < numOfInitialPixels; i++) {
+		int pixel = static_cast<int> (Sampler::hash (seed ^ Sampler::hash (i)) % numOfPixels);
+		if (!pattern[pixel]) {
+			update (pattern, energy, pixel, true);
+			numOfSet++;
+		}
+	}
+	for (int iteration = 0; iteration < numOfPixels; iteration++) {
+		int cluster = extremum (pattern, energy, true);
+		update (pattern, energy, cluster, false);
+		int largestVoid = extremum (pattern, energy, false);
+		update (pattern, energy, largestVoid, true);
+		if (largestVoid == cluster)
+			break;
+	}
+
+	std::vector<int> ranks (numOfPixels);
+	// Ranks of the initial pattern, removing its tightest clusters first
+	std::vector<char> bits = pattern;
+	std::vector<float> field = energy;
+	for (int rank = numOfInitialPixels - 1; rank >= 0; rank--) {
+		int cluster = extremum (bits, field, true);
+		update (bits, field, cluster, false);
+		ranks[cluster] = rank;
+	}
+	// Ranks of the others, filling the largest voids first
+	for (int rank = numOfInitialPixels; rank < numOfPixels; rank++) {
+		int largestVoid = extremum (pattern, energy, false);
+		update (pattern, energy, largestVoid, true);
+		ranks[largestVoid] = rank;
+	}
+
+	std::vector<float> values (numOfPixels);
+	for (int i = 0; i < numOfPixels; i++)
+		values[i] = (ranks[i] + 0.5f) / numOfPixels;
+	return values;
+}
+
+}
+
+const char * Sampler::name (SamplerType type) {
+	static const char * names[] = { "random", "halton", "sobol", "bluenoise" };
+	return names[static_cast<int> (type)];
+}
+
+const std::vector<glm::vec2> & Sampler::blueNoiseTile () {
+	static const std::vector<glm::vec2> tile = [] () {
+		PROFILE_SCOPE ("Sampler::blueNoiseTile");
+		std::vector<float> first = voidAndCluster (BLUE_NOISE_TILE_SIZE, 1);
+		std::vector<float> second = voidAndCluster (BLUE_NOISE_TILE_SIZE, 2);
+		std::vector<glm::vec2> result (first.size ());
+		for (size_t i = 0; i < result.size (); i++)
+			result[i] = glm::vec2 (first[i], second[i]);
+		return result;
+	} ();
+	return tile;
+}
@@ -0,0 +1,146 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#pragma once
+
+#include <cstdint>
+#include <vector>
+
+#include <glm/glm.hpp>
+
+/// Sequences of sample points.
+/// - Random: white noise, the reference the others converge faster than.
+/// - Halton: radical inverses in pairs of prime bases, rotated per pixel (Cranley-Patterson).
+/// - Sobol: the (0, 2)-sequence in base 2, with hash-based Owen scrambling and shuffling per pixel (Burley 2020).
+/// - BlueNoise: the Sobol points rotated by a blue noise tile, so that the error of the first samples is spread at
+///   high frequencies over the image.
+enum class SamplerType { Random, Halton, Sobol, BlueNoise };
+
+/// Generates the 2D sample points of each pixel, as a pure function of the pixel, the sample index, the dimension and
+/// the seed: there is no state to share between threads, and the pixels may be rendered in any order with the same
+/// result. Independent pairs of dimensions (e.g. position on the pixel, on a light) are selected by 'dimension'.
+class Sampler {
+public:
+	/// Side of the blue noise tile, repeated over the image.
+	static const int BLUE_NOISE_TILE_SIZE = 64;
+
+	explicit Sampler (SamplerType type = SamplerType::Sobol, uint32_t seed = 0) : m_type (type), m_seed (hash (seed)) {}
+
+	inline SamplerType type () const { return m_type; }
+
+	/// Sample 'index' of pixel (x, y), in [0, 1)^2.
+	inline glm::vec2 get2D (uint32_t x, uint32_t y, uint32_t index, uint32_t dimension = 0) const {
+		uint32_t pixelSeed = hash (m_seed ^ hash (x ^ hash (y)));
+		switch (m_type) {
+		case SamplerType::Random:
+			return glm::vec2 (toFloat (hash (hashCombine (pixelSeed, 2 * dimension) ^ hash (index))),
+							  toFloat (hash (hashCombine (pixelSeed, 2 * dimension + 1) ^ hash (index))));
+		case SamplerType::Halton:
+			return halton (pixelSeed, index, dimension);
+		case SamplerType::Sobol:
+			return scrambledSobol (hashCombine (pixelSeed, dimension), index);
+		case SamplerType::BlueNoise:
+		default:
+			return blueNoise (x, y, index, dimension);
+		}
+	}
+
+	static const char * name (SamplerType type);
+
+	/// Integer hash (Wang).
+	static inline uint32_t hash (uint32_t key) {
+		key = (key ^ 61) ^ (key >> 16);
+		key *= 9;
+		key ^= key >> 4;
+		key *= 0x27d4eb2d;
+		key ^= key >> 15;
+		return key;
+	}
+
+	/// Maps the 24 high bits of an integer to [0, 1).
+	static inline float toFloat (uint32_t value) { return (value >> 8) * (1.f / 16777216.f); }
+
+	/// Blue noise tile of BLUE_NOISE_TILE_SIZE^2 2D values, row major, generated on first use (void and cluster).
+	static const std::vector<glm::vec2> & blueNoiseTile ();
+
+private:
+	static inline uint32_t hashCombine (uint32_t seed, uint32_t value) {
+		return seed ^ (value + 0x9e3779b9 + (seed << 6) + (seed >> 2));
+	}
+
+	static inline uint32_t reverseBits (uint32_t x) {
+		x = (x << 16) | (x >> 16);
+		x = ((x & 0x00ff00ff) << 8) | ((x & 0xff00ff00) >> 8);
+		x = ((x & 0x0f0f0f0f) << 4) | ((x & 0xf0f0f0f0) >> 4);
+		x = ((x & 0x33333333) << 2) | ((x & 0xcccccccc) >> 2);
+		x = ((x & 0x55555555) << 1) | ((x & 0xaaaaaaaa) >> 1);
+		return x;
+	}
+
+	/// Owen scrambling of the bits of x, most significant first (Laine-Karras hash on the reversed bits).
+	static inline uint32_t nestedUniformScramble (uint32_t x, uint32_t seed) {
+		x = reverseBits (x);
+		x += seed;
+		x ^= x * 0x6c50b47c;
+		x ^= x * 0xb82f1e52;
+		x ^= x * 0xc7afe638;
+		x ^= x * 0x8d22f6e6;
+		return reverseBits (x);
+	}
+
+	/// Second dimension of the Sobol sequence, the first one being the bit reversal of the index.
+	static inline uint32_t sobol1 (uint32_t index) {
+		uint32_t result = 0;
+		for (uint32_t v = 1u << 31; index; index >>= 1, v ^= v >> 1)
+			if (index & 1)
+				result ^= v;
+		return result;
+	}
+
+	static inline glm::vec2 scrambledSobol (uint32_t seed, uint32_t index) {
+		index = nestedUniformScramble (index, seed);
+		return glm::vec2 (toFloat (nestedUniformScramble (reverseBits (index), hashCombine (seed, 0))),
+						  toFloat (nestedUniformScramble (sobol1 (index), hashCombine (seed, 1))));
+	}
+
+	static inline float radicalInverse (uint32_t base, uint32_t index) {
+		float inverseBase = 1.f / base;
+		float factor = inverseBase;
+		float result = 0.f;
+		for (; index > 0; index /= base, factor *= inverseBase)
+			result += (index % base) * factor;
+		return result;
+	}
+
+	static inline glm::vec2 halton (uint32_t pixelSeed, uint32_t index, uint32_t dimension) {
+		static const uint32_t primes[] = { 2, 3, 5, 7, 11, 13, 17, 19, 23, 29, 31, 37, 41, 43, 47, 53 };
+		uint32_t pair = dimension % 8;
+		glm::vec2 rotation (toFloat (hash (hashCombine (pixelSeed, 2 * dimension))), toFloat (hash (hashCombine (pixelSeed, 2 * dimension + 1))));
+		glm::vec2 point (radicalInverse (primes[2 * pair], index), radicalInverse (primes[2 * pair + 1], index));
+		return wrap (point + rotation);
+	}
+
+	inline glm::vec2 blueNoise (uint32_t x, uint32_t y, uint32_t index, uint32_t dimension) const {
+		// Each pair of dimensions reads the tile at another offset, decorrelating them
+		uint32_t offset = hashCombine (m_seed, dimension);
+		uint32_t tileX = (x + offset) % BLUE_NOISE_TILE_SIZE;
+		uint32_t tileY = (y + (offset >> 16)) % BLUE_NOISE_TILE_SIZE;
+		glm::vec2 rotation = blueNoiseTile ()[tileY * BLUE_NOISE_TILE_SIZE + tileX];
+		glm::vec2 point (toFloat (reverseBits (index)), toFloat (sobol1 (index)));
+		return wrap (point + rotation);
+	}
+
+	/// Toroidal wrap to [0, 1), exclusive of 1 despite the float rounding.
+	static inline glm::vec2 wrap (const glm::vec2 & point) {
+		glm::vec2 result = glm::fract (point);
+		return glm::min (result, glm::vec2 (1.f - 1.f / 16777216.f));
+	}
+
+	SamplerType m_type;
+	uint32_t m_seed;
+};
@@ -7,9 +7,19 @@
 // All rights reserved.
 // ----------------------------------------------
 #include "Scene.h"
-#include "Texture2DNoise.h"
+#include "Texture2Dnoise.h"
+#include "Profiler.h"
+
+#include <chrono>
+
+typedef std::chrono::high_resolution_clock Clock;
+
+static double millisecondsSince(Clock::time_point start) {
+	return std::chrono::duration<double, std::milli>(Clock::now() - start).count();
+}
 
 void Scene::preprocessScene() {
+	PROFILE_SCOPE("Scene::preprocessScene");
 	for (int modelIndex = 0; modelIndex < numOfModels(); modelIndex++) {
 		std::shared_ptr<Model> currentModel = model(modelIndex);
 		std::shared_ptr<Mesh> modelMesh = mesh(currentModel->meshId());
@@ -45,10 +55,17 @@ void Scene::preprocessScene() {
 		}
 	}
 	std::vector<int> indices;
-	m_bvh = std::make_shared<BVH>(m_triangles, indices);
+	Clock::time_point start = Clock::now();
+	{
+		PROFILE_SCOPE("BVH build");
+		m_bvh = std::make_shared<BVH>(m_triangles, indices);
+	}
+	m_bvhBuildTime = millisecondsSince(start);
 }
 
 TextureBundle Scene::loadTextureBundle(std::string& materialDirName) {
+	PROFILE_SCOPE("Scene::loadTextureBundle");
+	Clock::time_point start = Clock::now();
 	TextureBundle result;
 	int firstIndex = numOfTextures();
 	result.m_albedoTexId = firstIndex;
@@ -56,32 +73,38 @@ TextureBundle Scene::loadTextureBundle(std::string& materialDirName) {
 	result.m_metallicTexId = firstIndex + 2;
 	result.m_ambientOcclusionTexId = firstIndex + 3;
 
-	auto albedo = std::make_shared<Texture>(result.m_roughnessTexId, materialDirName + "Base_Color.png", true);
-	auto roughness = std::make_shared<Texture>(result.m_roughnessTexId, materialDirName + "Roughness.png", true);
-	auto metallic = std::make_shared<Texture>(result.m_metallicTexId, materialDirName + "Metallic.png", true);
-	auto ambientOcclusion = std::make_shared<Texture>(result.m_ambientOcclusionTexId, materialDirName + "Ambient_Occlusion.png", true);
+	auto albedo = std::make_shared<Texture>(result.m_roughnessTexId, materialDirName + "Base_Color.png", true, colorTextureFormat(), m_textureLayout);
+	auto roughness = std::make_shared<Texture>(result.m_roughnessTexId, materialDirName + "Roughness.png", true, scalarTextureFormat(), m_textureLayout);
+	auto metallic = std::make_shared<Texture>(result.m_metallicTexId, materialDirName + "Metallic.png", true, scalarTextureFormat(), m_textureLayout);
+	auto ambientOcclusion = std::make_shared<Texture>(result.m_ambientOcclusionTexId, materialDirName + "Ambient_Occlusion.png", true, scalarTextureFormat(), m_textureLayout);
 
 	addTexture(albedo);
 	addTexture(roughness);
 	addTexture(metallic);
 	addTexture(ambientOcclusion);
 
+	m_textureLoadingTime += millisecondsSince(start);
 	return result;
 }
 
 TextureBundle Scene::loadTextureBundle(unsigned int resolution, Texture2Dnoise& noise, const std::vector<glm::vec3> &colorMap) {
+	PROFILE_SCOPE("Scene::loadTextureBundle");
+	Clock::time_point start = Clock::now();
 	TextureBundle result;
 	result.m_albedoTexId = numOfTextures();
 	result.m_roughnessTexId = -1;
 	result.m_metallicTexId = -1;
 	result.m_ambientOcclusionTexId = -1;
 	
-	auto texture = noise.generateColor2DNoiseTexture(numOfTextures(), resolution, colorMap);
+	auto texture = noise.generateColor2DNoiseTexture(numOfTextures(), resolution, colorMap, colorTextureFormat(), m_textureLayout);
 	addTexture(texture);
+	m_textureLoadingTime += millisecondsSince(start);
 	return result;
 }
 
 TextureBundle Scene::loadTextureBundle(int textureType, unsigned int resolution, Texture2Dnoise& noise) {
+	PROFILE_SCOPE("Scene::loadTextureBundle");
+	Clock::time_point start = Clock::now();
 	TextureBundle result;
 	int firstIndex = numOfTextures();
 	result.m_albedoTexId = -1;
@@ -99,8 +122,9 @@ TextureBundle Scene::loadTextureBundle(int textureType, unsigned int resolution,
 		result.m_ambientOcclusionTexId = firstIndex;
 		break;
 	}
-	auto texture = noise.generateFloat2DNoiseTexture(firstIndex, resolution);
+	auto texture = noise.generateFloat2DNoiseTexture(firstIndex, resolution, scalarTextureFormat(), m_textureLayout);
 	addTexture(texture);
 	
+	m_textureLoadingTime += millisecondsSince(start);
 	return result;
 }
@@ -21,18 +21,29 @@
 #include "LightSource.h"
 #include "BoundingBox.h"
 #include "Camera.h"
-#include "Texture2DNoise.h"
+#include "Texture2Dnoise.h"
 #include "BVH.h"
 
 
 class Scene {
 public:
-	inline Scene () : m_backgroundColor (0.f, 0.f ,0.f) {}
+	inline Scene () : m_backgroundColor (0.f, 0.f ,0.f), m_textureLayout (TextureLayout::Tiled), m_compressTextures (false),
+		m_textureLoadingTime (0.0), m_bvhBuildTime (0.0) {}
 	virtual ~Scene() {}
 
 	inline const glm::vec3 & backgroundColor () const { return m_backgroundColor; }
 
 	inline void setBackgroundColor (const glm::vec3 & color) { m_backgroundColor = color; }
+
+	/// Memory layout of the CPU copy of the textures loaded from now on.
+	inline TextureLayout textureLayout () const { return m_textureLayout; }
+
+	inline void setTextureLayout (TextureLayout layout) { m_textureLayout = layout; }
+
+	/// Color textures are stored as 8 bit sRGB and scalar maps as 8 bit by default, as BC1 / BC4 blocks when compressed.
+	inline bool texturesAreCompressed () const { return m_compressTextures; }
+
+	inline void compressTextures (bool compress) { m_compressTextures = compress; }
  
 	inline void set (std::shared_ptr<Camera> camera) { m_camera = camera; }
 
@@ -49,6 +60,8 @@ public:
 	inline void addModel (std::shared_ptr<Model> model) { m_models.push_back (model); }
 
 	inline void addLight(std::shared_ptr<LightSource> light) { return m_lights.push_back(light); }
+
+	inline void clearLights () { m_lights.clear (); }
 	
 	inline size_t numOfMeshes () const { return m_meshes.size (); }
 
@@ -72,6 +85,8 @@ public:
 	
 	const std::shared_ptr<LightSource>& light (size_t index) const { return m_lights[index]; }
 
+	const std::vector<std::shared_ptr<LightSource>>& lights () const { return m_lights; }
+
 	const Triangle& triangle (size_t index) const { return m_triangles[index]; }
 
 	const std::vector<Triangle>& triangles () const { return m_triangles; }
@@ -79,6 +94,13 @@ public:
 	const std::shared_ptr<BVH>& sceneBVH() const { return m_bvh; }
 	
 	void preprocessScene();
+
+	/// Time spent loading or generating the textures, in ms.
+	inline double textureLoadingTime () const { return m_textureLoadingTime; }
+
+	/// Time spent building the BVH in the last preprocessScene, in ms.
+	inline double bvhBuildTime () const { return m_bvhBuildTime; }
+
 	TextureBundle loadTextureBundle(std::string& materialDirName);
 	TextureBundle loadTextureBundle(unsigned int resolution, Texture2Dnoise& noise, const std::vector<glm::vec3>& colorMap);
 	TextureBundle loadTextureBundle(int textureType, unsigned int resolution, Texture2Dnoise& noise);
@@ -92,10 +114,18 @@ public:
 		m_lights.clear();
 		m_triangles.clear();
 		m_bvh = nullptr;
+		m_textureLoadingTime = 0.0;
+		m_bvhBuildTime = 0.0;
 	}
 
 private:
+	inline TextureFormat colorTextureFormat () const { return m_compressTextures ? TextureFormat::BC1 : TextureFormat::SRGBA8; }
+
+	inline TextureFormat scalarTextureFormat () const { return m_compressTextures ? TextureFormat::BC4 : TextureFormat::R8; }
+
 	glm::vec3 m_backgroundColor;
+	TextureLayout m_textureLayout;
+	bool m_compressTextures;
 	std::shared_ptr<Camera> m_camera;
 	std::vector<std::shared_ptr<Mesh> > m_meshes;
 	std::vector<std::shared_ptr<Material> > m_materials;
@@ -104,4 +134,6 @@ private:
 	std::vector <std::shared_ptr<LightSource>> m_lights;
 	std::vector<Triangle> m_triangles;
 	std::shared_ptr<BVH> m_bvh;
+	double m_textureLoadingTime;
+	double m_bvhBuildTime;
 };
\ No newline at end of file
@@ -0,0 +1,453 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+
+#define _USE_MATH_DEFINES
+
+#include "Scenes.h"
+
+#include <cmath>
+#include <vector>
+
+#include <glm/glm.hpp>
+#include <glm/ext.hpp>
+
+#include "Console.h"
+#include "Profiler.h"
+#include "IO.h"
+#include "Material.h"
+#include "Texture.h"
+#include "Model.h"
+#include "LightSource.h"
+#include "SetupFreeNoise.h"
+#include "Solid3DNoise.h"
+#include "Texture2Dnoise.h"
+
+namespace Scenes {
+
+std::shared_ptr<Scene> build (int index, const Settings& settings) {
+	PROFILE_SCOPE_ARG ("Scenes::build", index);
+	if (index == 0)
+		return buildScene1 (settings);
+	else if (index == 1)
+		return buildScene2 (settings);
+	return buildScene3 (settings);
+}
+
+std::shared_ptr<Scene> buildScene1 (const Settings& settings) {
+	Console::print("init scene 1");
+	
+	Console::print("Scene1 : albedo textures generated using noise (planar uv for walls and spherical uv for others)");
+	std::shared_ptr<Scene> scenePtr = std::make_shared<Scene> ();
+	scenePtr->setBackgroundColor (glm::vec3 (0.1f, 0.5f, 0.95f));
+
+	// Meshes
+	auto monkeyMeshPtr = IO::loadOFFMesh(settings.meshFilename, 0, true);
+	auto appleMeshPtr = IO::loadOFFMesh(settings.basePath + "/Resources/Models/Apple.off", 1, true);
+	auto killerooMeshPtr = IO::loadOFFMesh(settings.basePath + "/Resources/Models/killeroo.off", 2, true);
+	auto planMeshPtr = IO::loadOFFMesh(settings.basePath + "/Resources/Models/wall.off", 3, false);
+
+	scenePtr->addMesh(monkeyMeshPtr);
+	scenePtr->addMesh(appleMeshPtr);
+	scenePtr->addMesh(killerooMeshPtr);
+	scenePtr->addMesh(planMeshPtr);
+
+	// ### Textures
+	float K_ = 1.0;
+	float a_ = 0.1;
+	float F_0_ = 0.04;
+	float omega_0_ = M_PI / 4.0;
+	float number_of_impulses_per_kernel = 56.0;
+	unsigned random_offset = settings.seed;
+	prng gen;
+	gen.seed(random_offset);
+	
+	Texture2Dnoise isotropic_Noise1(true, K_, a_ * 1.3f, F_0_ * 4, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999));
+	Texture2Dnoise isotropic_Noise2(true, K_, a_ * 1.3f, F_0_ * 4, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999));
+	Texture2Dnoise anisotropic_Noise1(false, K_, a_ * 1.3f, F_0_ * 4, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999));
+	Texture2Dnoise anisotropic_Noise2(false, K_, a_ * 1.3f, F_0_ * 4, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999));
+	
+	std::vector<glm::vec3> colorMap1 = { glm::vec3(1.0, 1.0, 0.0), glm::vec3(0.0, 1.0, 0.0), glm::vec3(0.0, 0.1, 1.0) };
+	std::vector<glm::vec3> colorMap2 = { glm::vec3(1.0, 0.0, 0.0), glm::vec3(0.0, 0.1, 0.0), glm::vec3(0.0, 0.0, 1.0) };
+	std::vector<glm::vec3> colorMap3 = { glm::vec3(1.0 ,0.0, 1.0), glm::vec3(1.0 ,0.0, 0.0), glm::vec3(0.0 ,0.0, 1.0), glm::vec3(0.0, 1.0, 1.0), glm::vec3(1.0, 1.0, 1.0)};
+	std::vector<glm::vec3> colorMap4 = { glm::vec3(0.99 ,0.98, 0.1), glm::vec3(0.95 ,0.93, 0.1), glm::vec3(0.89 ,0.82, 0.0), glm::vec3(0.7, 0.62, 0.1)};
+	
+	// Textures generated using gabor Noise
+	Console::print("Generating textures using Gabor Noise");
+	TextureBundle textureBundle11 = scenePtr->loadTextureBundle(256, isotropic_Noise1, colorMap1);
+	TextureBundle textureBundle12 = scenePtr->loadTextureBundle(256, anisotropic_Noise1, colorMap1);
+	TextureBundle textureBundle2 = scenePtr->loadTextureBundle(256, isotropic_Noise2, colorMap2); 
+	TextureBundle textureBundle3 = scenePtr->loadTextureBundle(256, anisotropic_Noise2, colorMap3);
+	TextureBundle textureBundle4 = scenePtr->loadTextureBundle(256, isotropic_Noise2, colorMap4);
+	Console::print("5 textures of resolution 256 generated in " + std::to_string(scenePtr->textureLoadingTime()) + "ms");
+
+	// ---------------------------------
+	
+	// ### Materials
+	auto materialPtr11 = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(1,1,0.0), 0.8, 0.05, textureBundle11);
+	scenePtr->addMaterial(materialPtr11);
+	auto materialPtr12 = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(1,1,0.0), 0.8, 0.05, textureBundle12);
+	scenePtr->addMaterial(materialPtr12);
+	auto materialPtr2 = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.2, 0.8), 0.1, 0.1, textureBundle2);
+	scenePtr->addMaterial(materialPtr2);
+	auto materialPtr3 = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(0.8, 1.0, 0.3), 0.1, 0.1, textureBundle3);
+	scenePtr->addMaterial(materialPtr3);
+	auto materialPtr4 = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(0.9, 0.8, 0.2), 0.8, 0.2, textureBundle4);
+	scenePtr->addMaterial(materialPtr4);
+
+	// ---------------------------------
+	
+	// ### Models
+	auto wallPtr = std::make_shared<Model>();
+	wallPtr->transform().setTranslation({ 0 , 0, -7 });
+	wallPtr->transform().setScale(7);
+	wallPtr->useMesh(planMeshPtr->getId());
+	wallPtr->useMaterial(materialPtr11->getId());
+	scenePtr->addModel(wallPtr);
+
+	auto groundlPtr = std::make_shared<Model>();
+	groundlPtr->transform().setTranslation({ 0 , -7, 0 });
+	groundlPtr->transform().setRotation(glm::vec3(glm::radians(-90.0f), 0, 0));
+	groundlPtr->transform().setScale(7);
+	groundlPtr->useMesh(planMeshPtr->getId());
+	groundlPtr->useMaterial(materialPtr12->getId());
+	scenePtr->addModel(groundlPtr);
+	
+	for (int i = 0; i <= 4; i+=2) {
+		for (int j = 0; j <= 4; j+=2) {
+			auto modelPtr = std::make_shared<Model>();
+			modelPtr->transform().setTranslation({ -4 + 2 * j, -4 + 2 * i, ((2 * i + j) % 3 == 0) ? -2.0f : ((2 * i + j) % 3 == 1) ? 2 : 0 });
+			modelPtr->useMesh(((i * 4 + j) % 3 == 0) ? monkeyMeshPtr->getId() : (((i * 4 + j) % 3 == 1) ? appleMeshPtr->getId() : killerooMeshPtr->getId()));
+			modelPtr->useMaterial(((i + j * 4) % 3 == 0)? materialPtr2->getId() : (((i*4+j) % 3 == 1)? materialPtr3->getId() : materialPtr4->getId()));
+			modelPtr->transform().setScale(SCALE / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
+			scenePtr->addModel(modelPtr);
+		}
+	}
+
+	// ---------------------------------
+	
+	// ### Light
+	auto pointLight1 = std::make_shared<LightSource>(LightType::PointLight, glm::vec3(1, 1, 1), 70);
+	pointLight1->transform().setTranslation(glm::vec3(-15, 1, 0));
+	scenePtr->addLight(pointLight1);
+
+	auto pointLight2 = std::make_shared<LightSource>(LightType::PointLight, glm::vec3(1, 1, 1), 70);
+	pointLight2->transform().setTranslation(glm::vec3(15, 1, 0));
+	scenePtr->addLight(pointLight2);
+
+	auto dirtectionalLight2 = std::make_shared<LightSource>(LightType::DirectionalLight, glm::vec3(1.0, 1.0, 1.0), 1.5f);
+	dirtectionalLight2->transform().setRotation(glm::vec3(glm::radians(45.0f), glm::radians(180.0f), glm::radians(0.0f)));
+	scenePtr->addLight(dirtectionalLight2);
+	// ---------------------------------
+	
+	// Preprocess scene (apply model transforms & calculate AABB)  // should be called in render for dynamic scenes
+	scenePtr->preprocessScene();
+	// ---------------------------------
+
+	// Camera
+	auto cameraPtr = std::make_shared<Camera> ();
+	cameraPtr->setAspectRatio (settings.aspectRatio);
+	cameraPtr->setTranslation (glm::vec3 (0.0, 0.0, 5.f * SCALE));
+	cameraPtr->setNear (0.1f);
+	cameraPtr->setFar (100.f * SCALE);
+	scenePtr->set (cameraPtr);
+	return scenePtr;
+}
+
+std::shared_ptr<Scene> buildScene2 (const Settings& settings) {
+	Console::print("init scene 2");
+	Console::print("Scene2 (Ray tracing should be activated) : texture(spherical uv) / surface / solid  ");
+	std::shared_ptr<Scene> scenePtr = std::make_shared<Scene> ();
+	scenePtr->setBackgroundColor(glm::vec3(0.1f, 0.5f, 0.95f));
+
+	// Meshes
+	auto planMeshPtr = IO::loadOFFMesh(settings.basePath + "/Resources/Models/wall.off", scenePtr->numOfMeshes(), false);
+	scenePtr->addMesh(planMeshPtr);
+	auto rhinoMeshPtr = IO::loadOFFMesh(settings.basePath + "/Resources/Models/rhino.off", scenePtr->numOfMeshes(), true);
+	scenePtr->addMesh(rhinoMeshPtr);
+
+	// ### Textures
+	float K_ = 1.0;
+	float a_ = 0.1;
+	float F_0_ = 0.04;
+	float omega_0_ = M_PI / 4.0;
+	float number_of_impulses_per_kernel = 56.0;
+	unsigned random_offset = settings.seed;
+	prng gen;
+	gen.seed(random_offset);
+
+
+	Texture2Dnoise isotropic_Noise(true, K_, a_ * 2, F_0_ * 3, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999));
+	Texture2Dnoise anisotropic_Noise(false, K_, a_ * 2, F_0_ * 3, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999));
+
+	std::vector<glm::vec3> colorMap = { glm::vec3(1.0 ,0.0, 1.0), glm::vec3(1.0 ,0.0, 0.0), glm::vec3(0.0 ,0.0, 1.0), glm::vec3(0.0, 1.0, 1.0), glm::vec3(1.0, 1.0, 1.0) };
+
+	// Textures generated using gabor Noise
+	Console::print("Generating textures using Gabor Noise");
+	TextureBundle anisotropicTextureBundle = scenePtr->loadTextureBundle(256, anisotropic_Noise, colorMap);
+	TextureBundle isotropicTextureBundle = scenePtr->loadTextureBundle(256, isotropic_Noise, colorMap);
+	Console::print("Textures generation ended");
+	// ---------------------------------
+
+	// ### Materials
+	TextureBundle textureBundleEmpty = { -1, -1, -1, -1 }; // used as a  control  sample
+	auto controlMaterialPtr = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(0.7, 0.7, 0.7), 0.5, 0.5, textureBundleEmpty);
+	scenePtr->addMaterial(controlMaterialPtr);
+	
+	auto isotropicTextureMaterialPtr = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.4, 0.4, isotropicTextureBundle);
+	scenePtr->addMaterial(isotropicTextureMaterialPtr);
+	auto anisotropicTextureMaterialPtr = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.4, 0.4, anisotropicTextureBundle);
+	scenePtr->addMaterial(anisotropicTextureMaterialPtr);
+
+
+	auto isotropicSurfaceMaterialPtr = std::make_shared<SurfaceNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.1, 0.1, textureBundleEmpty);
+	isotropicSurfaceMaterialPtr->setGen(std::make_shared<SetupFreeNoise>(true, K_, a_ * 1.2f, F_0_ * 4, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999)));
+	isotropicSurfaceMaterialPtr->addColor(colorMap);
+	scenePtr->addMaterial(isotropicSurfaceMaterialPtr);
+	auto anisotropicSurfaceMaterialPtr = std::make_shared<SurfaceNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.1, 0.1, textureBundleEmpty);
+	anisotropicSurfaceMaterialPtr->setGen(std::make_shared<SetupFreeNoise>(false, K_, a_ * 1.2f, F_0_ * 4, omega_0_, number_of_impulses_per_kernel, gen.uniform(0, 99999999)));
+	anisotropicSurfaceMaterialPtr->addColor(colorMap);
+	scenePtr->addMaterial(anisotropicSurfaceMaterialPtr);
+	
+	auto isotropicSolidMaterialPtr = std::make_shared<SolidNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.1, 0.1, textureBundleEmpty);
+	isotropicSolidMaterialPtr->setGen(std::make_shared<Solid3DNoise>(true, K_, a_ * 1.2f, F_0_ * 4, glm::vec3(1.0,0.0,0.0), number_of_impulses_per_kernel * 1.2f, gen.uniform(0, 99999999)));
+	isotropicSolidMaterialPtr->addColor(colorMap);
+	scenePtr->addMaterial(isotropicSolidMaterialPtr);
+	auto anisotropicSolidMaterialPtr = std::make_shared<SolidNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.1, 0.1, textureBundleEmpty);
+	anisotropicSolidMaterialPtr->setGen(std::make_shared<Solid3DNoise>(false, K_, a_ * 1.2f, F_0_ * 4, glm::vec3(1.0, 0.0, 0.0), number_of_impulses_per_kernel * 1.2f, gen.uniform(0, 99999999)));
+	anisotropicSolidMaterialPtr->addColor(colorMap);
+	scenePtr->addMaterial(anisotropicSolidMaterialPtr);
+
+	// ---------------------------------
+
+	// ### Models
+	auto wallPtr = std::make_shared<Model>();
+	wallPtr->transform().setTranslation({ 0 , 0, -6 });
+	wallPtr->transform().setScale(6);
+	wallPtr->useMesh(planMeshPtr->getId());
+	wallPtr->useMaterial(controlMaterialPtr->getId());
+	scenePtr->addModel(wallPtr);
+
+	auto groundlPtr = std::make_shared<Model>();
+	groundlPtr->transform().setTranslation({ 0 , -6, 0 });
+	groundlPtr->transform().setRotation(glm::vec3(glm::radians(-90.0f), 0, 0));
+	groundlPtr->transform().setScale(6);
+	groundlPtr->useMesh(planMeshPtr->getId());
+	groundlPtr->useMaterial(controlMaterialPtr->getId());
+	scenePtr->addModel(groundlPtr);
+
+	// Top Row : isotropic
+	Console::print("(Top Left) :isotropic albedo noise texture resolution = 256, isotropic gabor noise ");
+	auto modelPtr = std::make_shared<Model>();
+	modelPtr->transform().setTranslation({ -3.2, 2, 0 });
+	modelPtr->transform().setRotation({ 0, M_PI / 4, 0 });
+	modelPtr->useMesh(rhinoMeshPtr->getId());
+	modelPtr->useMaterial(isotropicTextureMaterialPtr->getId());
+	modelPtr->transform().setScale(1.5f * SCALE / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
+	scenePtr->addModel(modelPtr);
+
+	Console::print("(Top center) : isotropic surface noise");
+	modelPtr = std::make_shared<Model>();
+	modelPtr->transform().setTranslation({ 0, 2, 0 });
+	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
+	modelPtr->useMesh(rhinoMeshPtr->getId());
+	modelPtr->useMaterial(isotropicSurfaceMaterialPtr->getId());
+	modelPtr->transform().setScale(1.5f * SCALE / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
+	scenePtr->addModel(modelPtr);
+
+	Console::print("(Top Right) : isotropic solid noise");
+	modelPtr = std::make_shared<Model>();
+	modelPtr->transform().setTranslation({ 3.2, 2, 0 });
+	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
+	modelPtr->useMesh(rhinoMeshPtr->getId());
+	modelPtr->useMaterial(isotropicSolidMaterialPtr->getId());
+	modelPtr->transform().setScale(1.5f * SCALE / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
+	scenePtr->addModel(modelPtr);
+
+	// Bottom row : anistotropic
+	
+	Console::print("(Bottom Left) : anisotropic albedo noise texture resolution = 256, isotropic gabor noise ");
+	modelPtr = std::make_shared<Model>();
+	modelPtr->transform().setTranslation({ -3.2, -2, 2 });
+	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
+	modelPtr->useMesh(rhinoMeshPtr->getId());
+	modelPtr->useMaterial(anisotropicTextureMaterialPtr->getId());
+	modelPtr->transform().setScale(1.5f * SCALE / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
+	scenePtr->addModel(modelPtr);
+
+	Console::print("(Bottom center) : anisotropic surface noise");
+	modelPtr = std::make_shared<Model>();
+	modelPtr->transform().setTranslation({ 0, -2, 2 });
+	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
+	modelPtr->useMesh(rhinoMeshPtr->getId());
+	modelPtr->useMaterial(anisotropicSurfaceMaterialPtr->getId());
+	modelPtr->transform().setScale(1.5f * SCALE / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
+	scenePtr->addModel(modelPtr);
+
+	Console::print("(Bottom Right) : anisotropic solid noise");
+	modelPtr = std::make_shared<Model>();
+	modelPtr->transform().setTranslation({ 3.2, -2, 2 });
+	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
+	modelPtr->useMesh(rhinoMeshPtr->getId());
+	modelPtr->useMaterial(anisotropicSolidMaterialPtr->getId());
+	modelPtr->transform().setScale(1.5f * SCALE / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
+	scenePtr->addModel(modelPtr);
+
+	// ---------------------------------
+
+	// ### Light
+	auto pointLight1 = std::make_shared<LightSource>(LightType::PointLight, glm::vec3(1, 1, 1), 150);
+	pointLight1->transform().setTranslation(glm::vec3(-30, 0, 0));
+	scenePtr->addLight(pointLight1);
+
+	auto pointLight2 = std::make_shared<LightSource>(LightType::PointLight, glm::vec3(1, 1, 1), 150);
+	pointLight2->transform().setTranslation(glm::vec3(30, 0, 0));
+	scenePtr->addLight(pointLight2);
+
+	auto dirtectionalLight2 = std::make_shared<LightSource>(LightType::DirectionalLight, glm::vec3(1.0, 1.0, 1.0), 1.2f);
+	dirtectionalLight2->transform().setRotation(glm::vec3(glm::radians(45.0f), glm::radians(180.0f), glm::radians(0.0f)));
+	scenePtr->addLight(dirtectionalLight2);
+
+	// Preprocess scene (apply model transforms & calculate AABB)  // should be called in render for dynamic scenes
+	scenePtr->preprocessScene();
+	// ---------------------------------
+
+	// Camera
+	auto cameraPtr = std::make_shared<Camera>();
+	cameraPtr->setAspectRatio(settings.aspectRatio);
+	cameraPtr->setTranslation(glm::vec3(0.0, 0.0, 10.f * SCALE));
+	cameraPtr->setNear(0.1f);
+	cameraPtr->setFar(100.f * SCALE);
+	scenePtr->set(cameraPtr);
+	return scenePtr;
+}
+
+std::shared_ptr<Scene> buildScene3 (const Settings& settings) {
+	Console::print("init scene 3");
+	Console::print("Scene3 (Ray tracing should be activated) : albedo / roughness / metalicness  ");
+	std::shared_ptr<Scene> scenePtr = std::make_shared<Scene> ();
+	scenePtr->setBackgroundColor(glm::vec3(0.1f, 0.5f, 0.95f));
+
+	// Meshes
+	auto planMeshPtr = IO::loadOFFMesh(settings.basePath + "/Resources/Models/wall.off", scenePtr->numOfMeshes(), false);
+	scenePtr->addMesh(planMeshPtr);
+	auto rhinoMeshPtr = IO::loadOFFMesh(settings.basePath + "/Resources/Models/rhino.off", scenePtr->numOfMeshes(), true);
+	scenePtr->addMesh(rhinoMeshPtr);
+
+	// ### Textures
+	float K_ = 1.0;
+	float a_ = 0.1;
+	float F_0_ = 0.04;
+	float omega_0_ = M_PI / 4.0;
+	float number_of_impulses_per_kernel = 56.0;
+	unsigned random_offset = settings.seed;
+	prng gen;
+	gen.seed(random_offset);
+
+
+	std::vector<glm::vec3> colorMap = { glm::vec3(1.0 ,0.0, 1.0), glm::vec3(1.0 ,0.0, 0.0), glm::vec3(0.0 ,0.0, 1.0), glm::vec3(0.0, 1.0, 1.0), glm::vec3(1.0, 1.0, 1.0) };
+
+	// ---------------------------------
+
+	// ### Materials
+	TextureBundle textureBundleEmpty = { -1, -1, -1, -1 }; // used as a  control  sample
+	auto controlMaterialPtr = std::make_shared<Material>(scenePtr->numOfMaterials(), glm::vec3(0.7, 0.7, 0.7), 0.4, 0.4, textureBundleEmpty);
+	scenePtr->addMaterial(controlMaterialPtr);
+
+	auto albedo_isotropicSolidMaterialPtr = std::make_shared<SolidNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.4, 0.4, textureBundleEmpty);
+	albedo_isotropicSolidMaterialPtr->setGen(std::make_shared<Solid3DNoise>(true, K_, a_ * 1.4f, F_0_ * 5, glm::vec3(1.0, 0.0, 0.0), number_of_impulses_per_kernel * 1.2f, gen.uniform(0, 99999999)));
+	albedo_isotropicSolidMaterialPtr->addColor(colorMap);
+	albedo_isotropicSolidMaterialPtr->setmask(true,false,false);
+	scenePtr->addMaterial(albedo_isotropicSolidMaterialPtr);
+
+	auto roughness_isotropicSolidMaterialPtr = std::make_shared<SolidNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.2, 0.1, textureBundleEmpty);
+	roughness_isotropicSolidMaterialPtr->setGen(std::make_shared<Solid3DNoise>(true, K_, a_ * 1.4f, F_0_ * 5, glm::vec3(1.0, 0.0, 0.0), number_of_impulses_per_kernel * 1.2f, gen.uniform(0, 99999999)));
+	roughness_isotropicSolidMaterialPtr->addColor(colorMap);
+	roughness_isotropicSolidMaterialPtr->setmask(false, true, false);
+	scenePtr->addMaterial(roughness_isotropicSolidMaterialPtr);
+
+	auto metalic_isotropicSolidMaterialPtr = std::make_shared<SolidNoiseMaterial>(scenePtr->numOfMaterials(), glm::vec3(1.0, 0.5, 0.0), 0.1, 0.1, textureBundleEmpty);
+	metalic_isotropicSolidMaterialPtr->setGen(std::make_shared<Solid3DNoise>(true, K_, a_ * 1.4f, F_0_ * 5, glm::vec3(1.0, 0.0, 0.0), number_of_impulses_per_kernel * 1.2f, gen.uniform(0, 99999999)));
+	metalic_isotropicSolidMaterialPtr->addColor(colorMap);
+	metalic_isotropicSolidMaterialPtr->setmask(false, false, true);
+	scenePtr->addMaterial(metalic_isotropicSolidMaterialPtr);
+
+	// ---------------------------------
+
+	// ### Models
+	auto wallPtr = std::make_shared<Model>();
+	wallPtr->transform().setTranslation({ 0 , 0, -4 });
+	wallPtr->transform().setScale(4);
+	wallPtr->useMesh(planMeshPtr->getId());
+	wallPtr->useMaterial(controlMaterialPtr->getId());
+	scenePtr->addModel(wallPtr);
+
+	auto groundlPtr = std::make_shared<Model>();
+	groundlPtr->transform().setTranslation({ 0 , -4, 0 });
+	groundlPtr->transform().setRotation(glm::vec3(glm::radians(-90.0f), 0, 0));
+	groundlPtr->transform().setScale(4);
+	groundlPtr->useMesh(planMeshPtr->getId());
+	groundlPtr->useMaterial(controlMaterialPtr->getId());
+	scenePtr->addModel(groundlPtr);
+
+
+
+	auto modelPtr = std::make_shared<Model>();
+	modelPtr->transform().setTranslation({ -2.4, 1, 0 });
+	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
+	modelPtr->useMesh(rhinoMeshPtr->getId());
+	modelPtr->useMaterial(albedo_isotropicSolidMaterialPtr->getId());
+	modelPtr->transform().setScale(1.5f * SCALE / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
+	scenePtr->addModel(modelPtr);
+
+	modelPtr = std::make_shared<Model>();
+	modelPtr->transform().setTranslation({ 0, 1, 0 });
+	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
+	modelPtr->useMesh(rhinoMeshPtr->getId());
+	modelPtr->useMaterial(roughness_isotropicSolidMaterialPtr->getId());
+	modelPtr->transform().setScale(1.5f * SCALE / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
+	scenePtr->addModel(modelPtr);
+
+	modelPtr = std::make_shared<Model>();
+	modelPtr->transform().setTranslation({ 2.4, 1, 0 });
+	modelPtr->transform().setRotation({ 0, M_PI / 4 , 0 });
+	modelPtr->useMesh(rhinoMeshPtr->getId());
+	modelPtr->useMaterial(metalic_isotropicSolidMaterialPtr->getId());
+	modelPtr->transform().setScale(1.5f * SCALE / scenePtr->mesh(modelPtr->meshId())->getMeshScale());
+	scenePtr->addModel(modelPtr);
+
+	// ---------------------------------
+
+	// ### Light
+	auto pointLight1 = std::make_shared<LightSource>(LightType::PointLight, glm::vec3(1, 1, 1), 150);
+	pointLight1->transform().setTranslation(glm::vec3(-30, 0, 0));
+	scenePtr->addLight(pointLight1);
+
+	auto pointLight2 = std::make_shared<LightSource>(LightType::PointLight, glm::vec3(1, 1, 1), 150);
+	pointLight2->transform().setTranslation(glm::vec3(30, 0, 0));
+	scenePtr->addLight(pointLight2);
+
+	auto dirtectionalLight2 = std::make_shared<LightSource>(LightType::DirectionalLight, glm::vec3(1.0, 1.0, 1.0), 1.2f);
+	dirtectionalLight2->transform().setRotation(glm::vec3(glm::radians(45.0f), glm::radians(180.0f), glm::radians(0.0f)));
+	scenePtr->addLight(dirtectionalLight2);
+
+	// Preprocess scene (apply model transforms & calculate AABB)  // should be called in render for dynamic scenes
+	scenePtr->preprocessScene();
+	// ---------------------------------
+
+	// Camera
+	auto cameraPtr = std::make_shared<Camera>();
+	cameraPtr->setAspectRatio(settings.aspectRatio);
+	cameraPtr->setTranslation(glm::vec3(0.0, 0.0, 10.f * SCALE));
+	cameraPtr->setNear(0.1f);
+	cameraPtr->setFar(100.f * SCALE);
+	scenePtr->set(cameraPtr);
+	return scenePtr;
+}
+
+}
@@ -0,0 +1,43 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#pragma once
+
+#include <string>
+#include <memory>
+
+#include "Scene.h"
+
+/// Built-in scenes, shared by the interactive application and the headless tools. Building a scene needs no window.
+namespace Scenes {
+
+/// Scale of the models, also used for the camera navigation.
+const float SCALE = 2.5f;
+
+const int NUM_OF_SCENES = 3;
+
+struct Settings {
+	std::string basePath; // directory containing the Resources folder
+	std::string meshFilename; // main mesh of the first scene
+	float aspectRatio;
+	unsigned int seed; // seeds every noise of the scene
+};
+
+/// Scene 'index' in [0, NUM_OF_SCENES), preprocessed and with its camera set.
+std::shared_ptr<Scene> build (int index, const Settings& settings);
+
+/// Albedo textures generated using noise (planar uv for walls and spherical uv for others).
+std::shared_ptr<Scene> buildScene1 (const Settings& settings);
+
+/// Texture (spherical uv) / surface / solid noise, isotropic and anisotropic.
+std::shared_ptr<Scene> buildScene2 (const Settings& settings);
+
+/// Solid noise on albedo / roughness / metalicness.
+std::shared_ptr<Scene> buildScene3 (const Settings& settings);
+
+}
@@ -3,9 +3,11 @@
 #include <vector>
 #include <cmath>
 #include <algorithm>
+#include <optional>
 
 #include "SetupFreeNoise.h"
 #include "Texture2Dnoise.h"
+#include "RenderStats.h"
 
 int pseudoRandom(int seed)
 {
@@ -15,7 +17,7 @@ int pseudoRandom(int seed)
     return seed;
 }
 
-float SetupFreeNoise::cell(int i, int j, int k, const glm::vec3 &pos, const glm::vec3 &normal) const
+float SetupFreeNoise::cell(int i, int j, int k, const glm::vec3 &pos, const glm::vec3 &normal, const glm::mat3* footprint, const FilteredGabor<2>* sharedFilter) const
 {
     unsigned s = m_random_offset + i + j * 400 + 400 * 400 * k;
     if (s == 0) s = 1;
@@ -23,6 +25,8 @@ float SetupFreeNoise::cell(int i, int j, int k, const glm::vec3 &pos, const glm:
     gen.seed(s);
     double number_of_impulses_per_cell = m_impulse_density * m_kernel_radius * m_kernel_radius * m_kernel_radius;
     unsigned number_of_impulses = gen.poisson(number_of_impulses_per_cell);
+    RenderStats::count(RenderStats::NoiseCells);
+    RenderStats::count(RenderStats::NoiseImpulses, number_of_impulses);
     float noise = 0.0;
     glm::vec3 n = glm::normalize(normal);
     for (int i = 0; i < number_of_impulses; ++i) {  
@@ -41,52 +45,70 @@ float SetupFreeNoise::cell(int i, int j, int k, const glm::vec3 &pos, const glm:
             float x_i_x  = glm::dot(projection, tangent);
             float y_i_y  = glm::dot(projection, biTangent);
             float w_i = 2 * (0.5f - abs(signedDistanceToPlan));
-            if (m_isIsotropic)
-                noise += w_i * gabor(m_magnitude, m_kernel_freq_width, m_frequency, gen.uniform(0, 2.f * 3.14f) , x_i_x * m_kernel_radius, y_i_y * m_kernel_radius); // isotropic
+            float omega_i = m_isIsotropic ? gen.uniform(0, 2.f * 3.14f) : m_orientation;
+            if (sharedFilter || footprint) {
+                glm::vec2 f_i = m_frequency * glm::vec2(std::cos(omega_i * M_PI), std::sin(omega_i * M_PI));
+                glm::vec2 x_i = glm::vec2(x_i_x, y_i_y) * m_kernel_radius;
+                if (sharedFilter)
+                    noise += w_i * (*sharedFilter)(m_magnitude, f_i, x_i);
+                else
+                    noise += w_i * impulseFilter(tangent, biTangent, *footprint)(m_magnitude, f_i, x_i);
+            }
             else
-                noise += w_i * gabor(m_magnitude, m_kernel_freq_width, m_frequency, m_orientation , x_i_x * m_kernel_radius, y_i_y * m_kernel_radius); // anisotropic  
+                noise += w_i * gabor(m_magnitude, m_kernel_freq_width, m_frequency, omega_i, x_i_x * m_kernel_radius, y_i_y * m_kernel_radius);
         }
     } 
     
     return noise;
 }
 
-float SetupFreeNoise::noiseFloat(const glm::vec3& pos, const glm::vec3& normal) {
+float SetupFreeNoise::evaluate(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3* footprint) const {
     glm::vec3 fracPos = 180.0f * pos / m_kernel_radius;
     int i = int(fracPos.x), j = int(fracPos.y), k = int(fracPos.z);
     fracPos = fracPos - floor(fracPos);
+    // kernel coordinates are 180 * pos
+    glm::mat3 kernelFootprint;
+    std::optional<FilteredGabor<2>> sharedFilter;
+    if (footprint) {
+        kernelFootprint = (180.0f * 180.0f) * (*footprint);
+        // Anisotropic kernels share their frame: one filter for the whole evaluation
+        if (!m_isIsotropic) {
+            glm::vec3 n = glm::normalize(normal);
+            glm::vec3 tangent = glm::cross(glm::normalize(glm::vec3(1.0, 0.2, 0.7)), n);
+            sharedFilter = impulseFilter(tangent, glm::cross(n, tangent), kernelFootprint);
+        }
+    }
     float value = 0.0;
     for (int di = -1; di <= +1; ++di) {
         for (int dj = -1; dj <= +1; ++dj) {
             for (int dk = -1; dk <= +1; ++dk) {
-                value += cell(i + di, j + dj, k + dk, fracPos - glm::vec3(di, dj, dk), normal);
+                value += cell(i + di, j + dj, k + dk, fracPos - glm::vec3(di, dj, dk), normal, footprint ? &kernelFootprint : nullptr, sharedFilter ? &*sharedFilter : nullptr);
             }
         }
     }
     return std::max(0.00f, std::min(1.01f, 0.4f + value / (60 * variance())));
 }
 
+FilteredGabor<2> SetupFreeNoise::impulseFilter(const glm::vec3& tangent, const glm::vec3& biTangent, const glm::mat3& kernelFootprint) const {
+    // footprint projected in the (tangent, biTangent) frame of the impulse
+    glm::mat2x3 tangentFrame(tangent, biTangent);
+    return FilteredGabor<2>(m_kernel_freq_width, glm::transpose(tangentFrame) * kernelFootprint * tangentFrame);
+}
+
+float SetupFreeNoise::noiseFloat(const glm::vec3& pos, const glm::vec3& normal) {
+    return evaluate(pos, normal, nullptr);
+}
+
 glm::vec3 SetupFreeNoise::noiseColor(const glm::vec3& pos, const glm::vec3& normal, const std::vector<glm::vec3>& colorMap) {
-    glm::vec3 fracPos = 180.0f * pos / m_kernel_radius;
-    int i = int(fracPos.x), j = int(fracPos.y), k = int(fracPos.z);
-    fracPos = fracPos - floor(fracPos);
-    float value = 0.0;
-    for (int di = -1; di <= +1; ++di) {
-        for (int dj = -1; dj <= +1; ++dj) {
-            for (int dk = -1; dk <= +1; ++dk) {
-                value += cell(i + di, j + dj, k + dk, fracPos - glm::vec3(di, dj, dk), normal);
-            }
-        }
-    }
-    float noiseEval = std::max(0.00f, std::min(1.01f, 0.4f + value / (60 * variance()))) * colorMap.size();
-    int interval = static_cast<int>(noiseEval);
-    float frac = noiseEval - interval;
-    glm::vec3 color;
-    if (interval >= colorMap.size() - 1)
-        color = colorMap[colorMap.size() - 1];
-    else
-        color = (1 - frac) * colorMap[interval] + frac * colorMap[interval + 1];
-    return color;
+    return colorMapLookup(evaluate(pos, normal, nullptr), colorMap);
+}
+
+float SetupFreeNoise::noiseFloat(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const {
+    return evaluate(pos, normal, footprint == glm::mat3(0.0f) ? nullptr : &footprint);
+}
+
+glm::vec3 SetupFreeNoise::noiseColor(const glm::vec3& pos, const glm::vec3& normal, const std::vector<glm::vec3>& colorMap, const glm::mat3& footprint) const {
+    return colorMapLookup(evaluate(pos, normal, footprint == glm::mat3(0.0f) ? nullptr : &footprint), colorMap);
 }
 
 float SetupFreeNoise::variance() const
@@ -125,6 +147,24 @@ float& SurfaceNoiseMaterial::metallicness(const glm::vec3& pos, const glm::vec3&
     return m_metallicness;
 }
 
+glm::vec3 SurfaceNoiseMaterial::albedo(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const {
+    if (noiseActive[0])
+        return m_generator->noiseColor(pos, normal, m_colorMap, footprint);
+    return m_albedo;
+}
+
+float SurfaceNoiseMaterial::roughness(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const {
+    if (noiseActive[1])
+        return 0.05 + 1.1 * m_generator->noiseFloat(pos, normal, footprint);
+    return m_roughness;
+}
+
+float SurfaceNoiseMaterial::metallicness(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const {
+    if (noiseActive[2])
+        return 0.05 + 0.7 * m_generator->noiseFloat(pos, normal, footprint);
+    return m_metallicness;
+}
+
 void SurfaceNoiseMaterial::setmask(bool activateAlbedoNoise, bool activateRoughnessNoise, bool activateMetalicNoise) {
     noiseActive[0] = activateAlbedoNoise;
     noiseActive[1] = activateRoughnessNoise;
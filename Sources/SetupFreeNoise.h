@@ -15,6 +15,7 @@
 
 #include "Material.h"
 #include "Texture.h"
+#include "GaborFilter.h"
 
 class SetupFreeNoise
 {
@@ -25,9 +26,14 @@ public:
         m_kernel_radius = std::sqrt(-std::log(0.05) / M_PI) / m_kernel_freq_width;
         m_impulse_density = number_of_impulses_per_kernel / (2 * M_PI * m_kernel_radius * m_kernel_radius * m_kernel_radius);
     }
-    float cell(int i, int j, int k, const glm::vec3 &fracPos, const glm::vec3& normal) const;
+    /// 'footprint' is in kernel coordinates. The impulses are filtered with 'sharedFilter' if not null, built once per
+    /// evaluation when they share their frame, otherwise each with its own projection of the footprint.
+    float cell(int i, int j, int k, const glm::vec3 &fracPos, const glm::vec3& normal, const glm::mat3* footprint = nullptr, const FilteredGabor<2>* sharedFilter = nullptr) const;
     float noiseFloat(const glm::vec3& pos, const glm::vec3& normal);
     glm::vec3 noiseColor(const glm::vec3& pos, const glm::vec3& normal, const std::vector<glm::vec3>& colorMap);
+    /// Filtered variants: 'footprint' is the covariance of the pixel footprint on the surface, in the space of 'pos' (null for a point sample).
+    float noiseFloat(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const;
+    glm::vec3 noiseColor(const glm::vec3& pos, const glm::vec3& normal, const std::vector<glm::vec3>& colorMap, const glm::mat3& footprint) const;
     float variance() const;
 
 private:
@@ -39,6 +45,10 @@ private:
     float m_kernel_radius;
     float m_impulse_density;
     unsigned m_random_offset;
+    float evaluate(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3* footprint) const;
+    /// Filter of the kernels of frame (tangent, biTangent), unnormalized for the isotropic kernels, which draw a frame per
+    /// impulse.
+    FilteredGabor<2> impulseFilter(const glm::vec3& tangent, const glm::vec3& biTangent, const glm::mat3& kernelFootprint) const;
 };
 
 class SurfaceNoiseMaterial : public Material {
@@ -50,6 +60,9 @@ public:
     virtual glm::vec3& albedo(const glm::vec3& pos, const glm::vec3& normal) override;
     virtual float& metallicness(const glm::vec3& pos, const glm::vec3& normal) override;
     virtual float& roughness(const glm::vec3& pos, const glm::vec3& normal) override;
+    virtual glm::vec3 albedo(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const override;
+    virtual float roughness(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const override;
+    virtual float metallicness(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const override;
     void setmask(bool activateAlbedoNoise, bool activateRoughnessNoise, bool activateMetalicNoise);
 private:
     std::shared_ptr< SetupFreeNoise> m_generator;
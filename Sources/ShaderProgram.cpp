@@ -7,6 +7,7 @@
 // All rights reserved.
 // ----------------------------------------------
 #include "ShaderProgram.h"
+#include "Console.h"
 
 #include <iostream>
 #include <fstream>
@@ -48,7 +49,7 @@ void ShaderProgram::loadShader (GLenum type, const std::string & shaderFilename)
 	if (!success)
 	{
 		glGetShaderInfoLog(shader, 512, NULL, infoLog);
-		std::cout << "ERROR::" << shaderFilename << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+		Console::log (Console::Severity::Error, shaderFilename + " compilation failed\n" + infoLog);
 	}
 	
 	glAttachShader (m_id, shader); // Set the vertex shader as the one ot be used with the program/pipeline
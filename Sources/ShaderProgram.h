@@ -19,6 +19,7 @@
 #include "Material.h"
 #include "Texture.h"
 #include "LightSource.h"
+#include "Console.h"
 
 class ShaderProgram {
 public:
@@ -45,7 +46,7 @@ public:
 		glGetProgramiv(m_id, GL_LINK_STATUS, &success);
 		if (!success) {
 			glGetProgramInfoLog(m_id, 512, NULL, infoLog);
-			std::cout << "ERROR::" << "linking shaders" << "::COMPILATION_FAILED\n" << infoLog << std::endl;
+			Console::log (Console::Severity::Error, std::string ("shader linking failed\n") + infoLog);
 		}
 	}
 
@@ -0,0 +1,128 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#include "ShadingKernels.h"
+
+#include <array>
+#include <typeinfo>
+#include <utility>
+
+#include "SetupFreeNoise.h"
+#include "Solid3DNoise.h"
+
+namespace ShadingKernels {
+
+namespace {
+
+/// Concrete class of the materials of a kind.
+template <MaterialKind kind> struct MaterialClass { using Type = Material; };
+template <> struct MaterialClass<MaterialKind::SurfaceNoise> { using Type = SurfaceNoiseMaterial; };
+template <> struct MaterialClass<MaterialKind::SolidNoise> { using Type = SolidNoiseMaterial; };
+
+/// Material methods, called on the concrete class (qualified: no virtual dispatch) unless the kind is Generic.
+template <MaterialKind kind>
+struct MaterialEvaluator {
+	using Type = typename MaterialClass<kind>::Type;
+
+	static inline glm::vec3 albedo(const Material& material, const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) {
+		if constexpr (kind == MaterialKind::Generic)
+			return material.albedo(pos, normal, footprint);
+		else
+			return static_cast<const Type&>(material).Type::albedo(pos, normal, footprint);
+	}
+
+	static inline float roughness(const Material& material, const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) {
+		if constexpr (kind == MaterialKind::Generic)
+			return material.roughness(pos, normal, footprint);
+		else
+			return static_cast<const Type&>(material).Type::roughness(pos, normal, footprint);
+	}
+
+	static inline float metallicness(const Material& material, const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) {
+		if constexpr (kind == MaterialKind::Generic)
+			return material.metallicness(pos, normal, footprint);
+		else
+			return static_cast<const Type&>(material).Type::metallicness(pos, normal, footprint);
+	}
+};
+
+template <MaterialKind kind, unsigned mask>
+MaterialSample sampleMaterial(const Material& material,
+	const std::vector<const Texture*>& textures,
+	TextureFilter filter,
+	const glm::vec2& uv,
+	const SurfaceDifferentials& differentials,
+	const glm::vec3& localPos,
+	const glm::vec3& localNormal,
+	const glm::mat3& localFootprint) {
+	using Evaluator = MaterialEvaluator<kind>;
+	const TextureBundle& bundle = material.getTextureBundle();
+	MaterialSample sample;
+
+	if constexpr ((mask & AlbedoTexture) != 0)
+		sample.albedo = textures[bundle.m_albedoTexId]->fetch(uv, differentials.duvdx, differentials.duvdy, filter);
+	else
+		sample.albedo = Evaluator::albedo(material, localPos, localNormal, localFootprint);
+
+	if constexpr ((mask & RoughnessTexture) != 0)
+		sample.roughness = textures[bundle.m_roughnessTexId]->fetch(uv, differentials.duvdx, differentials.duvdy, filter).r;
+	else
+		sample.roughness = Evaluator::roughness(material, localPos, localNormal, localFootprint);
+
+	if constexpr ((mask & MetallicTexture) != 0)
+		sample.metallicness = textures[bundle.m_metallicTexId]->fetch(uv, differentials.duvdx, differentials.duvdy, filter).r;
+	else
+		sample.metallicness = Evaluator::metallicness(material, localPos, localNormal, localFootprint);
+
+	if constexpr ((mask & AmbientOcclusionTexture) != 0)
+		sample.ambientOcclusion = textures[bundle.m_ambientOcclusionTexId]->fetch(uv, differentials.duvdx, differentials.duvdy, filter).r;
+	else
+		sample.ambientOcclusion = 1.f;
+
+	return sample;
+}
+
+/// Kernels of a material kind, indexed by texture mask.
+template <MaterialKind kind, unsigned... masks>
+std::array<MaterialKernel, sizeof...(masks)> kernelsOfKind(std::integer_sequence<unsigned, masks...>) {
+	return { { &sampleMaterial<kind, masks>... } };
+}
+
+}
+
+MaterialKind materialKind(const Material& material) {
+	// Exact classes only: a subclass of a known material may override its methods
+	const std::type_info& type = typeid(material);
+	if (type == typeid(Material))
+		return MaterialKind::Constant;
+	if (type == typeid(SurfaceNoiseMaterial))
+		return MaterialKind::SurfaceNoise;
+	if (type == typeid(SolidNoiseMaterial))
+		return MaterialKind::SolidNoise;
+	return MaterialKind::Generic;
+}
+
+unsigned textureMask(const Material& material) {
+	return (material.hasAlbedoTexture() ? AlbedoTexture : 0u)
+		| (material.hasRoughnessTexture() ? RoughnessTexture : 0u)
+		| (material.hasMetallicTexture() ? MetallicTexture : 0u)
+		| (material.hasAmbiantOcclusionTexture() ? AmbientOcclusionTexture : 0u);
+}
+
+MaterialKernel materialKernel(const Material& material) {
+	using Masks = std::make_integer_sequence<unsigned, NUM_OF_TEXTURE_MASKS>;
+	static const std::array<std::array<MaterialKernel, NUM_OF_TEXTURE_MASKS>, 4> kernels = { {
+		kernelsOfKind<MaterialKind::Constant>(Masks()),
+		kernelsOfKind<MaterialKind::SurfaceNoise>(Masks()),
+		kernelsOfKind<MaterialKind::SolidNoise>(Masks()),
+		kernelsOfKind<MaterialKind::Generic>(Masks())
+	} };
+	return kernels[static_cast<int>(materialKind(material))][textureMask(material)];
+}
+
+}
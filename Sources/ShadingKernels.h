@@ -0,0 +1,50 @@
+// ----------------------------------------------
+// Polytechnique - INF584 "Image Synthesis"
+//
+// Base code for practical assignments.
+//
+// Copyright (C) 2022 Tamy Boubekeur
+// All rights reserved.
+// ----------------------------------------------
+#pragma once
+
+#include <vector>
+
+#include <glm/glm.hpp>
+
+#include "Material.h"
+#include "Texture.h"
+#include "Ray.h"
+
+/// Concrete class of a material, known once the scene is compiled. The kernels of the known ones call the material
+/// methods without virtual dispatch; Generic covers any other subclass.
+enum class MaterialKind { Constant, SurfaceNoise, SolidNoise, Generic };
+
+/// Material evaluation specialized per material kind and per set of textured channels, so that a hit neither dispatches
+/// on the class of its material nor tests its texture bundle. The kernel of a material is selected once per render,
+/// when the scene snapshot is compiled (see RenderSnapshot).
+namespace ShadingKernels {
+
+/// Channels of a material read from a texture, bits of a texture mask.
+enum TextureChannel : unsigned { AlbedoTexture = 1, RoughnessTexture = 2, MetallicTexture = 4, AmbientOcclusionTexture = 8 };
+static const unsigned NUM_OF_TEXTURE_MASKS = 16;
+
+/// Evaluates a material at a point, 'textures' being the textures of the scene: 'uv' and 'differentials' locate the
+/// fetches, the point and its footprint in model space the procedural evaluations.
+using MaterialKernel = MaterialSample (*)(const Material& material,
+	const std::vector<const Texture*>& textures,
+	TextureFilter filter,
+	const glm::vec2& uv,
+	const SurfaceDifferentials& differentials,
+	const glm::vec3& localPos,
+	const glm::vec3& localNormal,
+	const glm::mat3& localFootprint);
+
+MaterialKind materialKind(const Material& material);
+
+unsigned textureMask(const Material& material);
+
+/// Kernel of the kind and texture mask of 'material'.
+MaterialKernel materialKernel(const Material& material);
+
+}
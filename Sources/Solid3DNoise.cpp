@@ -6,6 +6,7 @@
 
 #include "Solid3DNoise.h"
 #include "Texture2Dnoise.h"
+#include "RenderStats.h"
 
 float gabor3D(float K, float a, float F_0, glm::vec3 orientation, glm::vec3 pos)
 {
@@ -14,7 +15,7 @@ float gabor3D(float K, float a, float F_0, glm::vec3 orientation, glm::vec3 pos)
     return gaussian_envelop * sinusoidal_carrier;
 }
 
-float Solid3DNoise::cell(int i, int j, int k, const glm::vec3 &pos) const
+float Solid3DNoise::cell(int i, int j, int k, const glm::vec3 &pos, const FilteredGabor<3>* filter) const
 {
     unsigned s = m_random_offset + i + j * 400 + (400 * 400 * k);
     if (s == 0) s = 1;
@@ -22,17 +23,19 @@ float Solid3DNoise::cell(int i, int j, int k, const glm::vec3 &pos) const
     gen.seed(s);
     double number_of_impulses_per_cell = m_impulse_density * m_kernel_radius * m_kernel_radius * m_kernel_radius;
     unsigned number_of_impulses = gen.poisson(number_of_impulses_per_cell);
+    RenderStats::count(RenderStats::NoiseCells);
+    RenderStats::count(RenderStats::NoiseImpulses, number_of_impulses);
     float noise = 0.0;
     for (int i = 0; i < number_of_impulses; ++i) {  
         glm::vec3 samplePos = glm::vec3(gen.uniform(0, 1), gen.uniform(0, 1), gen.uniform(0, 1)); 
         glm::vec3 fracPos = pos - samplePos;
         float w_i = gen.uniform(-1.0f, 1.0f);
         if (fracPos.x * fracPos.x + fracPos.y + fracPos.z * fracPos.z < 1.0f) { // inside cylindre
-            if (m_isIsotropic)
-                noise += w_i * gabor3D(m_magnitude, m_kernel_freq_width, m_frequency, glm::normalize(glm::vec3(gen.uniform(-1, 1), gen.uniform(-1, 1), gen.uniform(-1, 1))), fracPos * m_kernel_radius); // isotropic
-            else {
-                noise += w_i * gabor3D(m_magnitude, m_kernel_freq_width, m_frequency, m_orientation, fracPos * m_kernel_radius); // anisotropic  
-            }
+            glm::vec3 orientation_i = m_isIsotropic ? glm::normalize(glm::vec3(gen.uniform(-1, 1), gen.uniform(-1, 1), gen.uniform(-1, 1))) : m_orientation;
+            if (filter)
+                noise += w_i * (*filter)(m_magnitude, m_frequency * orientation_i, fracPos * m_kernel_radius);
+            else
+                noise += w_i * gabor3D(m_magnitude, m_kernel_freq_width, m_frequency, orientation_i, fracPos * m_kernel_radius);
         }
     } 
     
@@ -45,7 +48,7 @@ float Solid3DNoise::variance() const
     return m_impulse_density * (1.0 / 3.0) * integral_gabor_filter_squared;
 }
 
-glm::vec3 Solid3DNoise::noiseColor(const glm::vec3& pos, const std::vector<glm::vec3>& colorMap) {
+float Solid3DNoise::evaluate(const glm::vec3& pos, const FilteredGabor<3>* filter) const {
     glm::vec3 fracPos = 180.0f * pos / m_kernel_radius;
     int i = int(fracPos.x), j = int(fracPos.y), k = int(fracPos.z);
     fracPos = fracPos - floor(fracPos);
@@ -53,34 +56,31 @@ glm::vec3 Solid3DNoise::noiseColor(const glm::vec3& pos, const std::vector<glm::
     for (int di = -1; di <= +1; ++di) {
         for (int dj = -1; dj <= +1; ++dj) {
             for (int dk = -1; dk <= +1; ++dk) {
-                value += cell(i + di, j + dj, k + dk, fracPos - glm::vec3(di, dj, dk));
+                value += cell(i + di, j + dj, k + dk, fracPos - glm::vec3(di, dj, dk), filter);
             }
         }
     }
-    float noiseEval = std::max(0.00f, std::min(1.01f, 0.4f + value / (60 * variance()))) * colorMap.size();
-    int interval = static_cast<int>(noiseEval);
-    float frac = noiseEval - interval;
-    glm::vec3 color;
-    if (interval >= colorMap.size() -1 )
-        color = colorMap[colorMap.size() - 1];
-    else
-        color = (1 - frac) * colorMap[interval] + frac * colorMap[interval + 1];
-    return color;
+    return std::max(0.00f, std::min(1.01f, 0.4f + value / (60 * variance())));
+}
+
+glm::vec3 Solid3DNoise::noiseColor(const glm::vec3& pos, const std::vector<glm::vec3>& colorMap) {
+    return colorMapLookup(evaluate(pos, nullptr), colorMap);
 }
 
 float Solid3DNoise::noiseFloat(const glm::vec3& pos) {
-    glm::vec3 fracPos = 180.0f * pos / m_kernel_radius;
-    int i = int(fracPos.x), j = int(fracPos.y), k = int(fracPos.z);
-    fracPos = fracPos - floor(fracPos);
-    float value = 0.0;
-    for (int di = -1; di <= +1; ++di) {
-        for (int dj = -1; dj <= +1; ++dj) {
-            for (int dk = -1; dk <= +1; ++dk) {
-                value += cell(i + di, j + dj, k + dk, fracPos - glm::vec3(di, dj, dk));
-            }
-        }
-    }
-    return std::max(0.00f, std::min(1.01f, 0.4f + value / (60 * variance())));
+    return evaluate(pos, nullptr);
+}
+
+glm::vec3 Solid3DNoise::noiseColor(const glm::vec3& pos, const std::vector<glm::vec3>& colorMap, const glm::mat3& footprint) const {
+    return colorMapLookup(noiseFloat(pos, footprint), colorMap);
+}
+
+float Solid3DNoise::noiseFloat(const glm::vec3& pos, const glm::mat3& footprint) const {
+    if (footprint == glm::mat3(0.0f))
+        return evaluate(pos, nullptr);
+    // kernel coordinates are 180 * pos
+    FilteredGabor<3> filter(m_kernel_freq_width, (180.0f * 180.0f) * footprint);
+    return evaluate(pos, &filter);
 }
 
 void SolidNoiseMaterial::addColor(const std::vector<glm::vec3> & colors) {
@@ -114,6 +114,24 @@ float& SolidNoiseMaterial::metallicness(const glm::vec3& pos, const glm::vec3& n
     return m_metallicness;
 }
 
+glm::vec3 SolidNoiseMaterial::albedo(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const {
+    if (noiseActive[0])
+        return m_generator->noiseColor(pos, m_colorMap, footprint);
+    return m_albedo;
+}
+
+float SolidNoiseMaterial::roughness(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const {
+    if (noiseActive[1])
+        return 0.05 + 1.1 * m_generator->noiseFloat(pos, footprint);
+    return m_roughness;
+}
+
+float SolidNoiseMaterial::metallicness(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const {
+    if (noiseActive[2])
+        return 0.05 + 0.7 * m_generator->noiseFloat(pos, footprint);
+    return m_metallicness;
+}
+
 void SolidNoiseMaterial::setmask(bool activateAlbedoNoise, bool activateRoughnessNoise, bool activateMetalicNoise) {
     noiseActive[0] = activateAlbedoNoise;
     noiseActive[1] = activateRoughnessNoise;
@@ -15,6 +15,7 @@
 
 #include "Material.h"
 #include "Texture.h"
+#include "GaborFilter.h"
 
 class Solid3DNoise
 {
@@ -25,10 +26,13 @@ public:
         m_kernel_radius = std::sqrt(-std::log(0.05) / M_PI) / m_kernel_freq_width;
         m_impulse_density = number_of_impulses_per_kernel / (2 * M_PI * m_kernel_radius * m_kernel_radius * m_kernel_radius);
     }
-    float cell(int i, int j, int k, const glm::vec3 &fracPos) const;
+    float cell(int i, int j, int k, const glm::vec3 &fracPos, const FilteredGabor<3>* filter = nullptr) const;
     float variance() const;
     glm::vec3 noiseColor(const glm::vec3& pos, const std::vector<glm::vec3>& colorMap);
     float noiseFloat(const glm::vec3& pos);
+    /// Filtered variants: 'footprint' is the covariance of the pixel footprint, in the space of 'pos' (null for a point sample).
+    glm::vec3 noiseColor(const glm::vec3& pos, const std::vector<glm::vec3>& colorMap, const glm::mat3& footprint) const;
+    float noiseFloat(const glm::vec3& pos, const glm::mat3& footprint) const;
 private:
     bool m_isIsotropic;
     float m_magnitude;
@@ -38,6 +42,7 @@ private:
     float m_kernel_radius;
     float m_impulse_density;
     unsigned m_random_offset;
+    float evaluate(const glm::vec3& pos, const FilteredGabor<3>* filter) const;
 };
 
 class SolidNoiseMaterial : public Material {
@@ -49,6 +54,9 @@ public:
     virtual glm::vec3& albedo(const glm::vec3& pos, const glm::vec3& normal) override;
     virtual float& roughness(const glm::vec3& pos, const glm::vec3& normal) override;
     virtual float& metallicness(const glm::vec3& pos, const glm::vec3& normal) override;
+    virtual glm::vec3 albedo(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const override;
+    virtual float roughness(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const override;
+    virtual float metallicness(const glm::vec3& pos, const glm::vec3& normal, const glm::mat3& footprint) const override;
     void setmask(bool activateAlbedoNoise, bool activateRoughnessNoise, bool activateMetalicNoise);
 private:
     std::shared_ptr< Solid3DNoise> m_generator;
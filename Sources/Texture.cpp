@@ -9,16 +9,23 @@
 
 #include <iostream>
 #include <vector>
+#include <algorithm>
+#include <array>
+#include <cstring>
+#include <limits>
 
 #include "Texture.h"
+#include "Console.h"
+#include "Profiler.h"
 #define STB_IMAGE_IMPLEMENTATION
 #include "stb_image.h"
 
-Texture::Texture(int id, const std::string& filename, bool floatingPoint)
-			:m_id(id), m_filename(filename), m_isFloatingPoint(floatingPoint){
-	std::cout << "Start Loading texture "  << filename << std::endl;
-	
-	GLuint texID;
+/// Texel standing for a texture that could not be loaded.
+static const float FALLBACK_TEXEL[3] = { 1.f, 1.f, 1.f };
+
+Texture::Texture(int id, const std::string& filename, bool floatingPoint, TextureFormat format, TextureLayout layout)
+			:m_id(id), m_filename(filename), m_isFloatingPoint(floatingPoint), m_format(format), m_layout(layout){
+	Console::print("Start Loading texture " + filename);
 	
 	if (!floatingPoint) {
 		// Loading the image in CPU memory using stbd_image
@@ -27,28 +34,16 @@ Texture::Texture(int id, const std::string& filename, bool floatingPoint)
 			&m_height,
 			&m_nbComponent, // 1 for a 8 bit greyscale image, 3 for 24bits RGB image
 			0);
-		// Create a texture in GPU memory
-		glGenTextures(1, &texID);
-		glBindTexture(GL_TEXTURE_2D, texID);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// Uploading the image data to GPU memory
-		glTexImage2D(GL_TEXTURE_2D,
-			0,
-			(m_nbComponent == 1 ? GL_RED : (m_nbComponent == 3 ? GL_RGB : GL_RGBA)),
-			m_width,
-			m_height,
-			0,
-			(m_nbComponent == 1 ? GL_RED : (m_nbComponent == 3 ? GL_RGB : GL_RGBA)),
-			GL_UNSIGNED_BYTE,
-			data);
-		// Generating mipmaps for filtered texture fetch
-		glGenerateMipmap(GL_TEXTURE_2D);
-		// keeping the CPU memory for cpu based raytracing
-		m_data = (void*) data;
-		glBindTexture(GL_TEXTURE_2D, 0);
+		if (!data) {
+			buildFallbackTexel("cannot load " + filename + " (" + stbi_failure_reason() + ")");
+			return;
+		}
+		// keeping a CPU mip pyramid for cpu based raytracing
+		std::vector<float> values(data, data + size_t(m_width) * m_height * m_nbComponent);
+		for (float& value : values)
+			value /= 255;
+		buildMipPyramid(values.data());
+		stbi_image_free(data);
 	}
 	else
 	{
@@ -58,146 +53,501 @@ Texture::Texture(int id, const std::string& filename, bool floatingPoint)
 			&m_height,
 			&m_nbComponent,
 			0);
-		// Create a texture in GPU memory
-		glGenTextures(1, &texID);
-		glBindTexture(GL_TEXTURE_2D, texID);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// Uploading the image data to GPU memory
-		glTexImage2D(GL_TEXTURE_2D,
-			0,
-			(m_nbComponent == 1 ? GL_R16F : (m_nbComponent == 3 ? GL_RGB16F : GL_RGBA16F)),
-			m_width,
-			m_height,
-			0,
-			(m_nbComponent == 1 ? GL_RED : (m_nbComponent == 3 ? GL_RGB : GL_RGBA)),
-			GL_FLOAT,
-			data);
-		// Generating mipmaps for filtered texture fetch
-		glGenerateMipmap(GL_TEXTURE_2D);
-		// keeping the CPU memory for cpu based raytracing
-		m_data = (void*) data;
-		glBindTexture(GL_TEXTURE_2D, 0);
-	}
-	m_contextId = texID;
-}
-
-Texture::Texture(int id, int width, int height, int nbComponent, const float* data, bool floatingPoint)
-	:m_id(id), m_width(width), m_height(height), m_nbComponent(nbComponent), m_filename(""), m_isFloatingPoint(floatingPoint) {
-
-	GLuint texID;
+		if (!data) {
+			buildFallbackTexel("cannot load " + filename + " (" + stbi_failure_reason() + ")");
+			return;
+		}
+		// keeping a CPU mip pyramid for cpu based raytracing
+		buildMipPyramid(data);
+		stbi_image_free(data);
+	}
+}
 
-	if (!floatingPoint) {
-		// Create a texture in GPU memory
-		glGenTextures(1, &texID);
-		glBindTexture(GL_TEXTURE_2D, texID);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// Uploading the image data to GPU memory
-		glTexImage2D(GL_TEXTURE_2D,
-			0,
-			(m_nbComponent == 1 ? GL_RED : (m_nbComponent == 3 ? GL_RGB : GL_RGBA)),
-			m_width,
-			m_height,
-			0,
-			(m_nbComponent == 1 ? GL_RED : (m_nbComponent == 3 ? GL_RGB : GL_RGBA)),
-			GL_UNSIGNED_BYTE,
-			data);
-		// Generating mipmaps for filtered texture fetch
-		glGenerateMipmap(GL_TEXTURE_2D);
-		// keeping the CPU memory for cpu based raytracing
-		m_data = (void*) data;
-		glBindTexture(GL_TEXTURE_2D, 0);
+Texture::Texture(int id, int width, int height, int nbComponent, const float* data, bool floatingPoint, TextureFormat format, TextureLayout layout)
+	:m_id(id), m_filename(""), m_isFloatingPoint(floatingPoint), m_width(width), m_height(height), m_nbComponent(nbComponent), m_format(format), m_layout(layout) {
+	// keeping a CPU mip pyramid for cpu based raytracing
+	buildMipPyramid(data);
+	delete[] data;
+}
+
+void Texture::buildFallbackTexel(const std::string& reason) {
+	Console::log(Console::Severity::Error, "Texture " + std::to_string(m_id) + ": " + reason + ", replaced by a white texel");
+	m_width = 1;
+	m_height = 1;
+	m_nbComponent = 3;
+	buildMipPyramid(FALLBACK_TEXEL);
+}
+
+/// Box filtered 2x2 reduction, the last row / column being repeated for odd sizes.
+static void downsample(const float* src, int srcWidth, int srcHeight, float* dst, int dstWidth, int dstHeight, int nbComponent) {
+	for (int y = 0; y < dstHeight; y++) {
+		int y0 = std::min(2 * y, srcHeight - 1);
+		int y1 = std::min(2 * y + 1, srcHeight - 1);
+		for (int x = 0; x < dstWidth; x++) {
+			int x0 = std::min(2 * x, srcWidth - 1);
+			int x1 = std::min(2 * x + 1, srcWidth - 1);
+			for (int c = 0; c < nbComponent; c++) {
+				float sum = src[(x0 + y0 * srcWidth) * nbComponent + c] + src[(x1 + y0 * srcWidth) * nbComponent + c]
+					+ src[(x0 + y1 * srcWidth) * nbComponent + c] + src[(x1 + y1 * srcWidth) * nbComponent + c];
+				dst[(x + y * dstWidth) * nbComponent + c] = 0.25f * sum;
+			}
+		}
 	}
-	else
-	{
-		// Create a texture in GPU memory
-		glGenTextures(1, &texID);
-		glBindTexture(GL_TEXTURE_2D, texID);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MAG_FILTER, GL_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_MIN_FILTER, GL_LINEAR_MIPMAP_LINEAR);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_S, GL_REPEAT);
-		glTexParameteri(GL_TEXTURE_2D, GL_TEXTURE_WRAP_T, GL_REPEAT);
-		// Uploading the image data to GPU memory
-		glTexImage2D(GL_TEXTURE_2D,
-			0,
-			(m_nbComponent == 1 ? GL_R16F : (m_nbComponent == 3 ? GL_RGB16F : GL_RGBA16F)),
-			m_width,
-			m_height,
-			0,
-			(m_nbComponent == 1 ? GL_RED : (m_nbComponent == 3 ? GL_RGB : GL_RGBA)),
-			GL_FLOAT,
-			data);
-		// Generating mipmaps for filtered texture fetch
-		glGenerateMipmap(GL_TEXTURE_2D);
-		// keeping the CPU memory for cpu based raytracing
-		m_data = (void *) data;
-		glBindTexture(GL_TEXTURE_2D, 0);
-	}
-	m_contextId = texID;
-}
-
-Texture::~Texture() {
-	if (m_filename == "") {
-		delete[] ((float *)m_data);
-	}
-	else {
-		stbi_image_free(m_data);
-	}
-}
-
-glm::vec3 Texture::fetch(int x, int y) {
-	int index = (x + y * m_width) * m_nbComponent;
-	if (!m_isFloatingPoint) {
-		unsigned char* pixel_ptr = (unsigned char*) m_data + index;
-		if (m_nbComponent >= 3) {
-			return glm::vec3(float(pixel_ptr[0]) / 255, float(pixel_ptr[1]) / 255, float(pixel_ptr[2]) / 255);
+}
+
+static const unsigned int TILE_SIZE = 8;
+static const unsigned int BLOCK_SIZE = 4;
+static const size_t BLOCK_BYTES = 8;
+
+static inline bool isBlockFormat(TextureFormat format) {
+	return format == TextureFormat::BC1 || format == TextureFormat::BC4;
+}
+
+/// Bytes per texel of the uncompressed formats.
+static inline size_t texelSize(TextureFormat format) {
+	switch (format) {
+	case TextureFormat::R8:
+		return 1;
+	case TextureFormat::RGBA8:
+	case TextureFormat::SRGBA8:
+	case TextureFormat::R32F:
+		return 4;
+	case TextureFormat::R16F:
+		return 2;
+	case TextureFormat::RGB16F:
+		return 6;
+	case TextureFormat::RGB32F:
+		return 12;
+	case TextureFormat::RGBA32F:
+		return 16;
+	default:
+		return 0;
+	}
+}
+
+static float linearToSRGB(float value) {
+	value = glm::clamp(value, 0.f, 1.f);
+	return value <= 0.0031308f ? 12.92f * value : 1.055f * std::pow(value, 1.f / 2.4f) - 0.055f;
+}
+
+/// Linear value of each 8 bit sRGB code.
+static const std::array<float, 256>& sRGBToLinearTable() {
+	static const std::array<float, 256> table = [] {
+		std::array<float, 256> result;
+		for (int i = 0; i < 256; i++) {
+			float value = i / 255.f;
+			result[i] = value <= 0.04045f ? value / 12.92f : std::pow((value + 0.055f) / 1.055f, 2.4f);
 		}
-		else
-		{
-			return glm::vec3(float(pixel_ptr[0]) / 255, 0, 0);
+		return result;
+	}();
+	return table;
+}
+
+static inline unsigned char toUnorm8(float value) {
+	return static_cast<unsigned char>(glm::clamp(value, 0.f, 1.f) * 255.f + 0.5f);
+}
+
+static inline void store(unsigned char* dst, const void* src, size_t size) {
+	std::memcpy(dst, src, size);
+}
+
+static void encodeTexel(TextureFormat format, const glm::vec4& value, unsigned char* dst) {
+	switch (format) {
+	case TextureFormat::R8:
+		dst[0] = toUnorm8(value.r);
+		break;
+	case TextureFormat::RGBA8:
+		for (int c = 0; c < 4; c++)
+			dst[c] = toUnorm8(value[c]);
+		break;
+	case TextureFormat::SRGBA8:
+		for (int c = 0; c < 3; c++)
+			dst[c] = toUnorm8(linearToSRGB(value[c]));
+		dst[3] = toUnorm8(value.a);
+		break;
+	case TextureFormat::R16F:
+	case TextureFormat::RGB16F: {
+		int nbComponent = format == TextureFormat::R16F ? 1 : 3;
+		for (int c = 0; c < nbComponent; c++) {
+			glm::uint16 half = static_cast<glm::uint16>(glm::packHalf1x16(value[c]));
+			store(dst + 2 * c, &half, 2);
 		}
+		break;
+	}
+	case TextureFormat::R32F:
+		store(dst, &value.r, 4);
+		break;
+	default:
+		store(dst, &value.r, texelSize(format));
+		break;
+	}
+}
+
+static inline glm::uint16 toRGB565(const glm::vec3& color) {
+	glm::vec3 c = glm::clamp(color, 0.f, 1.f);
+	return static_cast<glm::uint16>((unsigned(c.r * 31 + 0.5f) << 11) | (unsigned(c.g * 63 + 0.5f) << 5) | unsigned(c.b * 31 + 0.5f));
+}
+
+static inline glm::vec3 fromRGB565(glm::uint16 color) {
+	return glm::vec3(float((color >> 11) & 31) / 31, float((color >> 5) & 63) / 63, float(color & 31) / 31);
+}
+
+static inline glm::uint64 loadBlock(const unsigned char* block) {
+	glm::uint64 bits = 0;
+	for (int i = BLOCK_BYTES - 1; i >= 0; i--)
+		bits = (bits << 8) | block[i];
+	return bits;
+}
+
+static inline void storeBlock(glm::uint64 bits, unsigned char* block) {
+	for (size_t i = 0; i < BLOCK_BYTES; i++, bits >>= 8)
+		block[i] = static_cast<unsigned char>(bits & 0xff);
+}
+
+/// Endpoints on the principal axis of the block colors, 2 bit index of the closest of the 4 palette colors per texel.
+static void encodeBC1(const glm::vec4 texels[16], unsigned char* block) {
+	glm::vec3 mean(0.f);
+	for (int i = 0; i < 16; i++)
+		mean += glm::vec3(texels[i]) / 16.f;
+	glm::mat3 covariance(0.f);
+	for (int i = 0; i < 16; i++) {
+		glm::vec3 d = glm::vec3(texels[i]) - mean;
+		covariance += glm::outerProduct(d, d);
+	}
+	glm::vec3 axis(1.f);
+	for (int iteration = 0; iteration < 8; iteration++) {
+		glm::vec3 next = covariance * axis;
+		float length = glm::length(next);
+		if (length < 1e-12f)
+			break;
+		axis = next / length;
 	}
-	else {
-		float* pixel_ptr = (float*) m_data + index;
-		if (m_nbComponent >= 3) {
-			return glm::vec3(pixel_ptr[0], pixel_ptr[1], pixel_ptr[2]);
+	float tMin = std::numeric_limits<float>::max(), tMax = -std::numeric_limits<float>::max();
+	for (int i = 0; i < 16; i++) {
+		float t = glm::dot(glm::vec3(texels[i]) - mean, axis);
+		tMin = std::min(tMin, t);
+		tMax = std::max(tMax, t);
+	}
+	glm::uint16 c0 = toRGB565(mean + tMax * axis);
+	glm::uint16 c1 = toRGB565(mean + tMin * axis);
+	if (c0 < c1)
+		std::swap(c0, c1);
+	glm::uint64 bits = glm::uint64(c0) | (glm::uint64(c1) << 16);
+	if (c0 != c1) {
+		// c0 > c1 selects the 4 color mode
+		glm::vec3 palette[4] = { fromRGB565(c0), fromRGB565(c1), {}, {} };
+		palette[2] = (2.f * palette[0] + palette[1]) / 3.f;
+		palette[3] = (palette[0] + 2.f * palette[1]) / 3.f;
+		for (int i = 0; i < 16; i++) {
+			int best = 0;
+			float bestDistance = std::numeric_limits<float>::max();
+			for (int p = 0; p < 4; p++) {
+				glm::vec3 d = palette[p] - glm::vec3(texels[i]);
+				if (glm::dot(d, d) < bestDistance) {
+					bestDistance = glm::dot(d, d);
+					best = p;
+				}
+			}
+			bits |= glm::uint64(best) << (32 + 2 * i);
 		}
+	}
+	storeBlock(bits, block);
+}
+
+static glm::vec3 decodeBC1(const unsigned char* block, int i) {
+	glm::uint64 bits = loadBlock(block);
+	glm::uint16 c0 = static_cast<glm::uint16>(bits & 0xffff);
+	glm::uint16 c1 = static_cast<glm::uint16>((bits >> 16) & 0xffff);
+	int index = static_cast<int>((bits >> (32 + 2 * i)) & 3);
+	glm::vec3 color0 = fromRGB565(c0), color1 = fromRGB565(c1);
+	switch (index) {
+	case 0:
+		return color0;
+	case 1:
+		return color1;
+	case 2:
+		return c0 > c1 ? (2.f * color0 + color1) / 3.f : 0.5f * (color0 + color1);
+	default:
+		return c0 > c1 ? (color0 + 2.f * color1) / 3.f : glm::vec3(0.f);
+	}
+}
+
+static inline float bc4Palette(int r0, int r1, int index) {
+	if (index < 2)
+		return float(index == 0 ? r0 : r1) / 255;
+	if (r0 > r1)
+		return float((8 - index) * r0 + (index - 1) * r1) / (7 * 255);
+	if (index < 6)
+		return float((6 - index) * r0 + (index - 1) * r1) / (5 * 255);
+	return index == 6 ? 0.f : 1.f;
+}
+
+/// Block extrema as endpoints, 3 bit index of the closest of the 8 interpolated values per texel.
+static void encodeBC4(const glm::vec4 texels[16], unsigned char* block) {
+	int r0 = 0, r1 = 255;
+	for (int i = 0; i < 16; i++) {
+		r0 = std::max(r0, int(toUnorm8(texels[i].r)));
+		r1 = std::min(r1, int(toUnorm8(texels[i].r)));
+	}
+	glm::uint64 bits = glm::uint64(r0) | (glm::uint64(r1) << 8);
+	for (int i = 0; i < 16; i++) {
+		int best = 0;
+		for (int index = 1; index < 8; index++)
+			if (std::abs(bc4Palette(r0, r1, index) - texels[i].r) < std::abs(bc4Palette(r0, r1, best) - texels[i].r))
+				best = index;
+		bits |= glm::uint64(best) << (16 + 3 * i);
+	}
+	storeBlock(bits, block);
+}
+
+static inline float decodeBC4(const unsigned char* block, int i) {
+	glm::uint64 bits = loadBlock(block);
+	return bc4Palette(block[0], block[1], static_cast<int>((bits >> (16 + 3 * i)) & 7));
+}
+
+/// Spreads the lower 16 bits of v over the even bits.
+static inline size_t part1By1(unsigned int v) {
+	v &= 0x0000ffff;
+	v = (v | (v << 8)) & 0x00ff00ff;
+	v = (v | (v << 4)) & 0x0f0f0f0f;
+	v = (v | (v << 2)) & 0x33333333;
+	v = (v | (v << 1)) & 0x55555555;
+	return v;
+}
+
+static inline int nextPowerOfTwo(int v) {
+	int p = 1;
+	while (p < v)
+		p <<= 1;
+	return p;
+}
+
+static inline int roundUp(int v, unsigned int multiple) {
+	return int((v + multiple - 1) / multiple * multiple);
+}
+
+static Texture::MipLevel levelLayout(int width, int height, size_t offset, TextureFormat format, TextureLayout layout) {
+	if (isBlockFormat(format))
+		return { width, height, offset, roundUp(width, BLOCK_SIZE), roundUp(height, BLOCK_SIZE) };
+	switch (layout) {
+	case TextureLayout::Tiled:
+		return { width, height, offset, roundUp(width, TILE_SIZE), roundUp(height, TILE_SIZE) };
+	case TextureLayout::Morton:
+		return { width, height, offset, nextPowerOfTwo(width), nextPowerOfTwo(height) };
+	default:
+		return { width, height, offset, width, height };
+	}
+}
+
+static inline size_t levelSize(const Texture::MipLevel& mip, TextureFormat format) {
+	if (isBlockFormat(format))
+		return size_t(mip.paddedWidth / BLOCK_SIZE) * (mip.paddedHeight / BLOCK_SIZE) * BLOCK_BYTES;
+	return size_t(mip.paddedWidth) * mip.paddedHeight * texelSize(format);
+}
+
+/// Position of the texel (x, y) in its level, in texels.
+static inline size_t swizzledIndex(TextureLayout layout, const Texture::MipLevel& mip, int x, int y) {
+	switch (layout) {
+	case TextureLayout::Tiled: {
+		unsigned int tx = unsigned(x) / TILE_SIZE, ty = unsigned(y) / TILE_SIZE;
+		size_t tile = size_t(ty) * (unsigned(mip.paddedWidth) / TILE_SIZE) + tx;
+		return tile * (TILE_SIZE * TILE_SIZE) + (unsigned(y) % TILE_SIZE) * TILE_SIZE + (unsigned(x) % TILE_SIZE);
+	}
+	case TextureLayout::Morton: {
+		// Z-order inside squares of the smallest padded dimension, the squares being stored one after the other
+		int shift = glm::findLSB(std::min(mip.paddedWidth, mip.paddedHeight));
+		unsigned int mask = (1u << shift) - 1;
+		size_t squareIndex = size_t(unsigned(y) >> shift) * (unsigned(mip.paddedWidth) >> shift) + (unsigned(x) >> shift);
+		return (squareIndex << (2 * shift)) + (part1By1(unsigned(x) & mask) | (part1By1(unsigned(y) & mask) << 1));
+	}
+	default:
+		return x + size_t(y) * mip.width;
+	}
+}
+
+size_t Texture::texelIndex(const MipLevel& mip, int x, int y) const {
+	return swizzledIndex(m_layout, mip, x, y);
+}
+
+/// Texel of a linear level as fetched: (r, 0, 0) for less than 3 components, opaque without alpha.
+static inline glm::vec4 sourceTexel(const float* level, int width, int nbComponent, int x, int y) {
+	const float* texel = level + (x + size_t(y) * width) * nbComponent;
+	if (nbComponent < 3)
+		return glm::vec4(texel[0], 0.f, 0.f, 1.f);
+	return glm::vec4(texel[0], texel[1], texel[2], nbComponent > 3 ? texel[3] : 1.f);
+}
+
+void Texture::buildMipPyramid(const float* data) {
+	PROFILE_SCOPE("Texture::buildMipPyramid");
+	if (m_width <= 0 || m_height <= 0 || m_nbComponent <= 0 || data == nullptr) {
+		buildFallbackTexel("no texels");
+		return;
+	}
+	if (m_format == TextureFormat::Native) {
+		if (m_isFloatingPoint)
+			m_format = m_nbComponent >= 4 ? TextureFormat::RGBA32F : (m_nbComponent == 3 ? TextureFormat::RGB32F : TextureFormat::R32F);
 		else
-		{
-			return glm::vec3(pixel_ptr[0], 0, 0);
+			m_format = m_nbComponent >= 3 ? TextureFormat::RGBA8 : TextureFormat::R8;
+	}
+	// The pyramid is reduced in floating point and linear order, then encoded in the requested format and layout
+	std::vector<MipLevel> linearLevels;
+	size_t linearSize = 0;
+	size_t size = 0;
+	int width = m_width, height = m_height;
+	m_levels.clear();
+	while (true) {
+		linearLevels.push_back({ width, height, linearSize, width, height });
+		m_levels.push_back(levelLayout(width, height, size, m_format, m_layout));
+		linearSize += size_t(width) * height * m_nbComponent;
+		size += levelSize(m_levels.back(), m_format);
+		if (width == 1 && height == 1)
+			break;
+		width = std::max(1, width / 2);
+		height = std::max(1, height / 2);
+	}
+	std::vector<float> pyramid(linearSize);
+	std::copy(data, data + size_t(m_width) * m_height * m_nbComponent, pyramid.begin());
+	for (size_t level = 1; level < linearLevels.size(); level++) {
+		const MipLevel& src = linearLevels[level - 1];
+		const MipLevel& dst = linearLevels[level];
+		downsample(&pyramid[src.offset], src.width, src.height, &pyramid[dst.offset], dst.width, dst.height, m_nbComponent);
+	}
+	m_data.assign(size, 0); // padding texels are never fetched
+	for (size_t level = 0; level < m_levels.size(); level++) {
+		const float* src = &pyramid[linearLevels[level].offset];
+		const MipLevel& dst = m_levels[level];
+		if (isBlockFormat(m_format)) {
+			// Blocks overlapping the border repeat the last row / column
+			glm::vec4 texels[16];
+			for (int by = 0; by < dst.paddedHeight / int(BLOCK_SIZE); by++)
+				for (int bx = 0; bx < dst.paddedWidth / int(BLOCK_SIZE); bx++) {
+					for (int i = 0; i < 16; i++)
+						texels[i] = sourceTexel(src, dst.width, m_nbComponent,
+							std::min(int(bx * BLOCK_SIZE) + i % 4, dst.width - 1), std::min(int(by * BLOCK_SIZE) + i / 4, dst.height - 1));
+					unsigned char* block = &m_data[dst.offset + (bx + size_t(by) * (dst.paddedWidth / BLOCK_SIZE)) * BLOCK_BYTES];
+					if (m_format == TextureFormat::BC1)
+						encodeBC1(texels, block);
+					else
+						encodeBC4(texels, block);
+				}
+		}
+		else {
+			for (int y = 0; y < dst.height; y++)
+				for (int x = 0; x < dst.width; x++)
+					encodeTexel(m_format, sourceTexel(src, dst.width, m_nbComponent, x, y), &m_data[dst.offset + texelIndex(dst, x, y) * texelSize(m_format)]);
 		}
 	}
 }
 
-glm::vec3 Texture::fetch(glm::vec2 uv_input) {
-	glm::vec2 uv = glm::vec2(fmod(uv_input.x, 1), fmod(uv_input.y, 1));
-	int x_left_bottom = static_cast<int>(uv.x * (m_width-1));
-	int y_left_bottom = static_cast<int>(uv.y * (m_height - 1));
-	
-	int x_left_top = x_left_bottom;
-	int y_left_top = y_left_bottom + 1;
-
-	int x_right_bottom = x_left_bottom + 1;
-	int y_right_bottom = y_left_bottom;
-		  
-	int x_right_top = x_left_bottom + 1;
-	int y_right_top = y_left_bottom + 1;
+glm::vec3 Texture::fetch(int level, int x, int y) const {
+	const MipLevel& mip = m_levels[level];
+	const unsigned char* data = m_data.data() + mip.offset;
+	if (isBlockFormat(m_format)) {
+		const unsigned char* block = data + (x / BLOCK_SIZE + size_t(y / BLOCK_SIZE) * (mip.paddedWidth / BLOCK_SIZE)) * BLOCK_BYTES;
+		int i = (y % BLOCK_SIZE) * BLOCK_SIZE + x % BLOCK_SIZE;
+		if (m_format == TextureFormat::BC1)
+			return decodeBC1(block, i);
+		return glm::vec3(decodeBC4(block, i), 0, 0);
+	}
+	const unsigned char* pixel_ptr = data + texelIndex(mip, x, y) * texelSize(m_format);
+	switch (m_format) {
+	case TextureFormat::R8:
+		return glm::vec3(float(pixel_ptr[0]) / 255, 0, 0);
+	case TextureFormat::RGBA8:
+		return glm::vec3(float(pixel_ptr[0]) / 255, float(pixel_ptr[1]) / 255, float(pixel_ptr[2]) / 255);
+	case TextureFormat::SRGBA8: {
+		const std::array<float, 256>& table = sRGBToLinearTable();
+		return glm::vec3(table[pixel_ptr[0]], table[pixel_ptr[1]], table[pixel_ptr[2]]);
+	}
+	case TextureFormat::R16F:
+	case TextureFormat::RGB16F: {
+		glm::uint16 half[3] = { 0, 0, 0 };
+		std::memcpy(half, pixel_ptr, texelSize(m_format));
+		return glm::vec3(glm::unpackHalf1x16(half[0]), m_format == TextureFormat::R16F ? 0.f : glm::unpackHalf1x16(half[1]),
+			m_format == TextureFormat::R16F ? 0.f : glm::unpackHalf1x16(half[2]));
+	}
+	case TextureFormat::R32F: {
+		float value;
+		std::memcpy(&value, pixel_ptr, sizeof(float));
+		return glm::vec3(value, 0, 0);
+	}
+	default: {
+		glm::vec3 value;
+		std::memcpy(&value, pixel_ptr, sizeof(glm::vec3));
+		return value;
+	}
+	}
+}
 
-	float alpha = uv.x * (m_width - 1) - x_left_bottom;
-	float beta = uv.y * (m_height - 1) - y_left_bottom;
+glm::vec3 Texture::fetchBilinear(int level, glm::vec2 uv) const {
+	const MipLevel& mip = m_levels[level];
+	uv = glm::fract(uv);
+	float x = uv.x * (mip.width - 1);
+	float y = uv.y * (mip.height - 1);
+	int x_left = static_cast<int>(x);
+	int y_bottom = static_cast<int>(y);
+	int x_right = std::min(x_left + 1, mip.width - 1);
+	int y_top = std::min(y_bottom + 1, mip.height - 1);
 
-	glm::vec3 pixel_left_bottom = fetch(x_left_bottom, y_left_bottom);
-	glm::vec3 pixel_left_top = fetch(x_left_top, y_left_top);
-	glm::vec3 pixel_right_bottom = fetch(x_right_bottom, y_right_bottom);
-	glm::vec3 pixel_right_top = fetch(x_right_top, y_right_top);
+	float alpha = x - x_left;
+	float beta = y - y_bottom;
 
-	glm::vec3 pixel_left = beta * pixel_left_top + (1 - beta) * pixel_left_bottom;
-	glm::vec3 pixel_right = beta * pixel_right_top + (1 - beta) * pixel_right_bottom;
+	glm::vec3 pixel_left = beta * fetch(level, x_left, y_top) + (1 - beta) * fetch(level, x_left, y_bottom);
+	glm::vec3 pixel_right = beta * fetch(level, x_right, y_top) + (1 - beta) * fetch(level, x_right, y_bottom);
 
 	return alpha * pixel_right + (1 - alpha) * pixel_left;
+}
+
+glm::vec3 Texture::fetch(glm::vec2 uv) {
+	return fetchBilinear(0, uv);
+}
+
+glm::vec3 Texture::fetchLod(glm::vec2 uv, float lod) const {
+	lod = glm::clamp(lod, 0.f, float(numOfLevels() - 1));
+	int level = static_cast<int>(lod);
+	float t = lod - level;
+	if (t <= 0.f)
+		return fetchBilinear(level, uv);
+	return (1 - t) * fetchBilinear(level, uv) + t * fetchBilinear(level + 1, uv);
+}
+
+glm::vec3 Texture::fetchTrilinear(glm::vec2 uv, glm::vec2 duvdx, glm::vec2 duvdy) const {
+	glm::vec2 size(m_width, m_height);
+	float footprint = std::max(glm::length(duvdx * size), glm::length(duvdy * size));
+	return fetchLod(uv, std::log2(footprint));
+}
+
+glm::vec3 Texture::fetchAnisotropic(glm::vec2 uv, glm::vec2 duvdx, glm::vec2 duvdy, int maxAnisotropy) const {
+	glm::vec2 size(m_width, m_height);
+	float lengthX = glm::length(duvdx * size);
+	float lengthY = glm::length(duvdy * size);
+	glm::vec2 majorAxis = lengthX > lengthY ? duvdx : duvdy;
+	float majorLength = std::max(lengthX, lengthY);
+	float minorLength = std::min(lengthX, lengthY);
+	int probes = glm::clamp(static_cast<int>(std::ceil(majorLength / std::max(minorLength, 1e-6f))), 1, maxAnisotropy);
+	float lod = std::log2(majorLength / probes);
+	glm::vec3 result(0.f);
+	for (int i = 0; i < probes; i++)
+		result += fetchLod(uv + ((i + 0.5f) / probes - 0.5f) * majorAxis, lod);
+	return result / float(probes);
+}
+
+glm::vec3 Texture::fetch(glm::vec2 uv, glm::vec2 duvdx, glm::vec2 duvdy, TextureFilter filter) const {
+	switch (filter) {
+	case TextureFilter::Trilinear:
+		return fetchTrilinear(uv, duvdx, duvdy);
+	case TextureFilter::Anisotropic:
+		return fetchAnisotropic(uv, duvdx, duvdy);
+	default:
+		return fetchBilinear(0, uv);
+	}
+}
+
+std::vector<glm::vec3> Texture::texels(int level) const {
+	const MipLevel& mip = m_levels[level];
+	std::vector<glm::vec3> result(size_t(mip.width) * mip.height);
+	for (int y = 0; y < mip.height; y++)
+		for (int x = 0; x < mip.width; x++)
+			result[x + size_t(y) * mip.width] = fetch(level, x, y);
+	return result;
 }
\ No newline at end of file
@@ -3,10 +3,9 @@
 
 #include <string>
 #include <memory>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
-#include <glad/glad.h>
-#include <GLFW/glfw3.h>
 
 struct TextureBundle {
 	int m_albedoTexId;
@@ -15,24 +14,68 @@ struct TextureBundle {
 	int m_ambientOcclusionTexId;
 };
 
+/// Filtering used by the CPU texture fetch when a footprint is available.
+enum class TextureFilter { Bilinear = 0, Trilinear = 1, Anisotropic = 2 };
+
+/// Memory order of the texels of each CPU mip level. Tiled stores 8x8 blocks contiguously, Morton follows a Z-order curve,
+/// so that the four texels of a bilinear fetch (and neighbouring fetches) share cache lines.
+enum class TextureLayout { Linear = 0, Tiled = 1, Morton = 2 };
+
+/// Storage of the CPU mip pyramid, decoded by the fetch. Native keeps the precision and the channels of the source data.
+/// SRGBA8 stores colors through the sRGB transfer curve, BC1 (RGB) and BC4 (single channel) store 4x4 blocks in 8 bytes.
+/// Single channel formats fetch (r, 0, 0).
+enum class TextureFormat { Native = 0, R8, RGBA8, SRGBA8, R16F, RGB16F, R32F, RGB32F, RGBA32F, BC1, BC4 };
+
+/// CPU image store of the ray tracer, no graphics context needed. The Rasterizer creates the GPU copy when first used.
 class Texture
 {
 public:
-	Texture(int id, const std::string& filename, bool floatingPoint);
-	Texture(int id, int width, int height, int nbComponent, const float * data, bool floatingPoint);
-	~Texture();
-	GLuint getContextId() {return m_contextId;}
+	/// Position of a mip level in the pyramid buffer, in bytes. Swizzled layouts pad the level to whole tiles, block
+	/// formats to whole blocks (stored row by row whatever the layout).
+	struct MipLevel {
+		int width;
+		int height;
+		size_t offset;
+		int paddedWidth;
+		int paddedHeight;
+	};
+
+	Texture(int id, const std::string& filename, bool floatingPoint, TextureFormat format = TextureFormat::Native, TextureLayout layout = TextureLayout::Linear);
+	Texture(int id, int width, int height, int nbComponent, const float * data, bool floatingPoint, TextureFormat format = TextureFormat::Native, TextureLayout layout = TextureLayout::Linear);
 	int getScenetId() {return m_id;}
+	inline int numOfLevels() const { return static_cast<int>(m_levels.size()); }
+	inline const MipLevel& level(int index) const { return m_levels[index]; }
+	inline TextureLayout layout() const { return m_layout; }
+	inline TextureFormat format() const { return m_format; }
+	/// Size of the CPU mip pyramid, in bytes.
+	inline size_t memorySize() const { return m_data.size(); }
+	/// Decoded texels of a mip level, row by row, e.g. for a GPU upload.
+	std::vector<glm::vec3> texels(int level) const;
+	/// Bilinear fetch in the full resolution level.
 	glm::vec3 fetch(glm::vec2 uv);
+	/// Filtered fetch over the footprint given by the uv derivatives along the pixel axes.
+	glm::vec3 fetch(glm::vec2 uv, glm::vec2 duvdx, glm::vec2 duvdy, TextureFilter filter) const;
+	/// Bilinear fetch in the two levels surrounding the footprint size, linearly blended.
+	glm::vec3 fetchTrilinear(glm::vec2 uv, glm::vec2 duvdx, glm::vec2 duvdy) const;
+	/// Several trilinear probes along the major axis of the footprint, taken in the level of its minor axis.
+	glm::vec3 fetchAnisotropic(glm::vec2 uv, glm::vec2 duvdx, glm::vec2 duvdy, int maxAnisotropy = 8) const;
 
 private:
 	int m_id; // For the moment, id = index in scene.m_textures  // for denugging purpose
 	std::string m_filename;
-	GLuint m_contextId;
 	bool m_isFloatingPoint;
 	int m_width;
 	int m_height;
 	int m_nbComponent;
-	void* m_data;
-	glm::vec3 fetch(int x, int y);
+	TextureFormat m_format;
+	TextureLayout m_layout;
+	std::vector<unsigned char> m_data; // every mip level, contiguous, from the full resolution to 1x1
+	std::vector<MipLevel> m_levels;
+	void buildMipPyramid(const float* data);
+	/// Pyramid of a single white texel, for an image that could not be loaded or has no texels, logging 'reason'.
+	void buildFallbackTexel(const std::string& reason);
+	size_t texelIndex(const MipLevel& mip, int x, int y) const;
+	glm::vec3 fetch(int level, int x, int y) const;
+	glm::vec3 fetchBilinear(int level, glm::vec2 uv) const;
+	glm::vec3 fetchLod(glm::vec2 uv, float lod) const;
 };
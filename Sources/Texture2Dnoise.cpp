@@ -4,7 +4,9 @@
 #include <cmath>
 #include <algorithm>
 
-#include "Texture2DNoise.h"
+#include "Texture2Dnoise.h"
+#include "RenderStats.h"
+#include "Profiler.h"
 
 float gabor(float K, float a, float F_0, float omega_0, float x, float y)
 {
@@ -22,6 +24,17 @@ unsigned int morton(unsigned int x, unsigned int y)
     return z;
 }
 
+glm::vec3 colorMapLookup(float noiseEval, const std::vector<glm::vec3>& colorMap) {
+    noiseEval *= colorMap.size();
+    int interval = static_cast<int>(noiseEval);
+    float frac = noiseEval - interval;
+    glm::vec3 color;
+    if (interval >= static_cast<int>(colorMap.size()) - 1)
+        color = colorMap[colorMap.size() - 1];
+    else
+        color = (1 - frac) * colorMap[interval] + frac * colorMap[interval + 1];
+    return color;
+}
 
 glm::vec2 randomFreqOrient(prng &gen, const float &frequency) {
     float test = gen.uniform(0.0, 2.0);
@@ -35,7 +48,7 @@ glm::vec2 randomFreqOrient(prng &gen, const float &frequency) {
 }
 
 
-float Texture2Dnoise::cell(int i, int j, float x, float y) const
+float Texture2Dnoise::cell(int i, int j, float x, float y, const FilteredGabor<2>* filter) const
 {
     unsigned s = morton(i, j) + m_random_offset; // nonperiodic noise
     if (s == 0) s = 1;
@@ -43,6 +56,8 @@ float Texture2Dnoise::cell(int i, int j, float x, float y) const
     gen.seed(s);
     double number_of_impulses_per_cell = m_impulse_density * m_kernel_radius * m_kernel_radius;
     unsigned number_of_impulses = gen.poisson(number_of_impulses_per_cell);
+    RenderStats::count(RenderStats::NoiseCells);
+    RenderStats::count(RenderStats::NoiseImpulses, number_of_impulses);
     float noise = 0.0;
     for (unsigned i = 0; i < number_of_impulses; ++i) {
         float x_i = gen.uniform(0, 1);
@@ -51,48 +66,73 @@ float Texture2Dnoise::cell(int i, int j, float x, float y) const
         float x_i_x = x - x_i;
         float y_i_y = y - y_i;
         if (((x_i_x * x_i_x) + (y_i_y * y_i_y)) < 1.0) {
-            if (m_isIsotropic)
-                noise += w_i * gabor(m_magnitude, m_kernel_freq_width, m_frequency, gen.uniform(-1, +1), x_i_x * m_kernel_radius, y_i_y * m_kernel_radius);
+            float omega_i = m_isIsotropic ? gen.uniform(-1, +1) : m_orientation;
+            if (filter) {
+                glm::vec2 f_i = m_frequency * glm::vec2(std::cos(omega_i * M_PI), std::sin(omega_i * M_PI));
+                noise += w_i * (*filter)(m_magnitude, f_i, glm::vec2(x_i_x, y_i_y) * m_kernel_radius);
+            }
             else {
-                noise += w_i * gabor(m_magnitude, m_kernel_freq_width, m_frequency, m_orientation, x_i_x * m_kernel_radius, y_i_y * m_kernel_radius);
+                noise += w_i * gabor(m_magnitude, m_kernel_freq_width, m_frequency, omega_i, x_i_x * m_kernel_radius, y_i_y * m_kernel_radius);
             }
         }
     }
     return noise;
 }
 
+float Texture2Dnoise::evaluate(float x, float y, const FilteredGabor<2>* filter) const
+{
+    x /= m_kernel_radius, y /= m_kernel_radius;
+    float int_x = std::floor(x), int_y = std::floor(y);
+    float frac_x = x - int_x, frac_y = y - int_y;
+    int i = int(int_x), j = int(int_y);
+    float noise = 0.0;
+    for (int di = -1; di <= +1; ++di) {
+        for (int dj = -1; dj <= +1; ++dj) {
+            noise += cell(i + di, j + dj, frac_x - di, frac_y - dj, filter);
+        }
+    }
+    return noise;
+}
+
+float Texture2Dnoise::noise(float x, float y) const
+{
+    return evaluate(x, y, nullptr);
+}
+
+float Texture2Dnoise::noise(float x, float y, const glm::mat2& footprint) const
+{
+    if (footprint == glm::mat2(0.0f))
+        return evaluate(x, y, nullptr);
+    FilteredGabor<2> filter(m_kernel_freq_width, footprint);
+    return evaluate(x, y, &filter);
+}
+
 float Texture2Dnoise::variance() const
 {
     float integral_gabor_filter_squared = ((m_magnitude * m_magnitude) / (4.0 * m_kernel_freq_width * m_kernel_freq_width)) * (1.0 + std::exp(-(2.0 * M_PI * m_frequency * m_frequency) / (m_kernel_freq_width * m_kernel_freq_width)));
     return m_impulse_density * (1.0 / 3.0) * integral_gabor_filter_squared;
 }
 
-std::shared_ptr<Texture> Texture2Dnoise::generateColor2DNoiseTexture(int currentIndex, int resolution, const std::vector<glm::vec3>& colorMap_) {
+std::shared_ptr<Texture> Texture2Dnoise::generateColor2DNoiseTexture(int currentIndex, int resolution, const std::vector<glm::vec3>& colorMap_, TextureFormat format, TextureLayout layout) {
+    PROFILE_SCOPE("Texture2Dnoise::generateColor2DNoiseTexture");
     float* image = new float[resolution * resolution * 3];
     float scale = 3.0f * std::sqrt(variance());
+    // Box filter of a texel, so that the texture does not alias the kernels finer than its resolution
+    const glm::mat2 texelFootprint(1.0f / 12.0f);
     for (unsigned row = 0; row < resolution; ++row) {
         for (unsigned col = 0; col < resolution; ++col) {
             float x = (float(col) + 0.5) - (float(resolution) / 2.0);
             float y = (float(resolution - row - 1) + 0.5) - (float(resolution) / 2.0);
-            x /= m_kernel_radius, y /= m_kernel_radius;
-            float int_x = std::floor(x), int_y = std::floor(y);
-            float frac_x = x - int_x, frac_y = y - int_y;
-            int i = int(int_x), j = int(int_y);
-            float noise = 0.0;
-            for (int di = -1; di <= +1; ++di) {
-                for (int dj = -1; dj <= +1; ++dj) {
-                    noise += cell(i + di, j + dj, frac_x - di, frac_y - dj);
-                }
-            }
-            noise = std::max(0.0f, std::min(0.5f + (0.5f * (noise / scale)), 1.1f))  * colorMap_.size();
-            int interval = static_cast<int>(noise);
-            float frac = noise - interval;
+            float value = noise(x, y, texelFootprint);
+            value = std::max(0.0f, std::min(0.5f + (0.5f * (value / scale)), 1.1f))  * colorMap_.size();
+            int interval = static_cast<int>(value);
+            float frac = value - interval;
             glm::vec3 color;
             if (interval >= colorMap_.size() - 1) {
                 color = colorMap_[colorMap_.size() - 1];
             }
             else {
-                float frac = noise - floor(noise);
+                float frac = value - floor(value);
                 color = (1 - frac) * colorMap_[interval] + frac * colorMap_[interval + 1];
             }
             int pixelIndex = (row * resolution) + col;
@@ -101,30 +141,24 @@ std::shared_ptr<Texture> Texture2Dnoise::generateColor2DNoiseTexture(int current
             image[3 * pixelIndex + 2] = color.z;
         }
     }
-    return std::make_shared<Texture>(currentIndex, resolution, resolution, 3, image, true);
+    return std::make_shared<Texture>(currentIndex, resolution, resolution, 3, image, true, format, layout);
 }
 
-std::shared_ptr<Texture> Texture2Dnoise::generateFloat2DNoiseTexture(int currentIndex, int resolution) {
+std::shared_ptr<Texture> Texture2Dnoise::generateFloat2DNoiseTexture(int currentIndex, int resolution, TextureFormat format, TextureLayout layout) {
+    PROFILE_SCOPE("Texture2Dnoise::generateFloat2DNoiseTexture");
     float* image = new float[resolution * resolution];
     float scale = 2.5f * std::sqrt(variance());
+    // As for the color texture
+    const glm::mat2 texelFootprint(1.0f / 12.0f);
     for (unsigned row = 0; row < resolution; ++row) {
         for (unsigned col = 0; col < resolution; ++col) {
             float x = (float(col) + 0.5) - (float(resolution) / 2.0);
             float y = (float(resolution - row - 1) + 0.5) - (float(resolution) / 2.0);
-            x /= m_kernel_radius, y /= m_kernel_radius;
-            float int_x = std::floor(x), int_y = std::floor(y);
-            float frac_x = x - int_x, frac_y = y - int_y;
-            int i = int(int_x), j = int(int_y);
-            float noise = 0.0;
-            for (int di = -1; di <= +1; ++di) {
-                for (int dj = -1; dj <= +1; ++dj) {
-                    noise += cell(i + di, j + dj, frac_x - di, frac_y - dj);
-                }
-            }
-            noise = std::max(0.0f, std::min(0.5f + (0.5f * (noise / scale)), 1.1f));
+            float value = noise(x, y, texelFootprint);
+            value = std::max(0.0f, std::min(0.5f + (0.5f * (value / scale)), 1.1f));
             int pixelIndex = (row * resolution) + col;
-            image[pixelIndex] = noise;
+            image[pixelIndex] = value;
         }
     }
-    return std::make_shared<Texture>(currentIndex, resolution, resolution, 1, image, true);
+    return std::make_shared<Texture>(currentIndex, resolution, resolution, 1, image, true, format, layout);
 }
\ No newline at end of file
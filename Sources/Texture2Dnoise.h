@@ -11,6 +11,7 @@
 #include <iomanip>
 #include <memory>
 #include <random>
+#include <vector>
 #include <glm/glm.hpp>
 #include <glm/ext.hpp>
 
@@ -19,11 +20,14 @@
 #endif
 
 #include "Texture.h"
+#include "GaborFilter.h"
 
 
 
 float gabor(float K, float a, float F_0, float omega_0, float x, float y);
 unsigned int morton(unsigned int x, unsigned int y);
+/// Maps a noise value in [0, 1] to a color, linearly interpolated in the color map.
+glm::vec3 colorMapLookup(float noiseEval, const std::vector<glm::vec3>& colorMap);
 
 class prng
 {
@@ -53,10 +57,15 @@ public:
         m_kernel_radius = std::sqrt(-std::log(0.05) / M_PI) / m_kernel_freq_width;
         m_impulse_density = number_of_impulses_per_kernel / (M_PI * m_kernel_radius * m_kernel_radius);
     }
-    float cell(int i, int j, float x, float y) const;
+    float cell(int i, int j, float x, float y, const FilteredGabor<2>* filter = nullptr) const;
+    /// Noise value at (x, y), in texel units of the generated textures.
+    float noise(float x, float y) const;
+    /// Noise value at (x, y) band-limited to a pixel footprint, given as a covariance matrix in texel units.
+    float noise(float x, float y, const glm::mat2& footprint) const;
     float variance() const;
-    std::shared_ptr<Texture> generateColor2DNoiseTexture(int currentIndex, int resolution, const std::vector<glm::vec3>& colorMap_);
-    std::shared_ptr<Texture> generateFloat2DNoiseTexture(int currentIndex, int resolution);
+    /// Textures of the noise, each texel holding its value band-limited to the texel area.
+    std::shared_ptr<Texture> generateColor2DNoiseTexture(int currentIndex, int resolution, const std::vector<glm::vec3>& colorMap_, TextureFormat format = TextureFormat::Native, TextureLayout layout = TextureLayout::Linear);
+    std::shared_ptr<Texture> generateFloat2DNoiseTexture(int currentIndex, int resolution, TextureFormat format = TextureFormat::Native, TextureLayout layout = TextureLayout::Linear);
 
 private:
     bool m_isIsotropic;
@@ -67,4 +76,5 @@ private:
     float m_kernel_radius;
     float m_impulse_density;
     unsigned m_random_offset;
+    float evaluate(float x, float y, const FilteredGabor<2>* filter) const;
 };